@@ -0,0 +1,329 @@
+
+//
+// AES-128 ECB encrypt (default) or decrypt (CB_AES_DEC).
+//
+//  The state is held column major, so byte 4c+r of a block is row r of
+//  column c, and the little endian word c of a block holds column c.
+//
+//  The xcrypto version uses xc.aessub.* and xc.aesmix.* with rs1 == rs2,
+//  so each instruction operates on a single column word. ShiftRows is
+//  done by merging bytes of the columns.
+//
+
+#include "cryptobench.h"
+
+#ifdef CB_AES_DEC
+char *    cb_name        = "aes128-dec";
+#else
+char *    cb_name        = "aes128-enc";
+#endif
+
+const int cb_block_bytes = 16;
+
+static uint8_t  aes_sbox    [256];
+static uint8_t  aes_inv_sbox[256];
+
+//! Expanded key schedule used by cb_run.
+static uint32_t aes_rk      [44];
+
+#define ROR32(x,n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define ROL8(x,n)  ((uint8_t)(((x) << (n)) | ((x) >> (8 - (n)))))
+
+#define M0 0x000000FF
+#define M1 0x0000FF00
+#define M2 0x00FF0000
+#define M3 0xFF000000
+
+//! Compute the forward and inverse s-boxes.
+static void aes_init_tables() {
+    uint8_t p = 1, q = 1;
+    do {
+        // p = p * 3 in GF(2^8), q = q / 3.
+        p = p ^ (p << 1) ^ (p & 0x80 ? 0x1B : 0);
+        q ^= q << 1;
+        q ^= q << 2;
+        q ^= q << 4;
+        if(q & 0x80) {
+            q ^= 0x09;
+        }
+        uint8_t x = q ^ ROL8(q,1) ^ ROL8(q,2) ^ ROL8(q,3) ^ ROL8(q,4);
+        aes_sbox[p] = x ^ 0x63;
+    } while(p != 1);
+    aes_sbox[0] = 0x63;
+
+    for(int i = 0; i < 256; i ++) {
+        aes_inv_sbox[aes_sbox[i]] = i;
+    }
+}
+
+static inline uint32_t aes_subword(uint32_t w) {
+    return ((uint32_t)aes_sbox[(w >>  0) & 0xFF] <<  0) |
+           ((uint32_t)aes_sbox[(w >>  8) & 0xFF] <<  8) |
+           ((uint32_t)aes_sbox[(w >> 16) & 0xFF] << 16) |
+           ((uint32_t)aes_sbox[(w >> 24) & 0xFF] << 24) ;
+}
+
+//! AES-128 key expansion.
+static void aes_key_schedule(uint32_t rk[44], const uint8_t key[16]) {
+    uint8_t rcon = 0x01;
+    for(int i = 0; i < 4; i ++) {
+        rk[i] = ((const uint32_t*)key)[i];
+    }
+    for(int i = 4; i < 44; i ++) {
+        uint32_t t = rk[i-1];
+        if((i & 3) == 0) {
+            t    = aes_subword(ROR32(t, 8)) ^ rcon;
+            rcon = (rcon << 1) ^ (rcon & 0x80 ? 0x1B : 0);
+        }
+        rk[i] = rk[i-4] ^ t;
+    }
+}
+
+//
+// Plain ISA implementation
+// ------------------------------------------------------------
+
+static inline uint8_t aes_xtime(uint8_t x) {
+    return (x << 1) ^ ((x >> 7) * 0x1B);
+}
+
+static inline void aes_mix_column(uint8_t * a) {
+    uint8_t x  = a[0] ^ a[1] ^ a[2] ^ a[3];
+    uint8_t a0 = a[0];
+    a[0] ^= x ^ aes_xtime(a[0] ^ a[1]);
+    a[1] ^= x ^ aes_xtime(a[1] ^ a[2]);
+    a[2] ^= x ^ aes_xtime(a[2] ^ a[3]);
+    a[3] ^= x ^ aes_xtime(a[3] ^ a0  );
+}
+
+static inline void aes_inv_mix_column(uint8_t * a) {
+    uint8_t u = aes_xtime(aes_xtime(a[0] ^ a[2]));
+    uint8_t v = aes_xtime(aes_xtime(a[1] ^ a[3]));
+    a[0] ^= u;
+    a[1] ^= v;
+    a[2] ^= u;
+    a[3] ^= v;
+    aes_mix_column(a);
+}
+
+static void aes_enc_plain(uint8_t ct[16], const uint8_t pt[16],
+                          const uint32_t rk[44]) {
+    const uint8_t * k = (const uint8_t*)rk;
+    uint8_t s[16], t[16];
+
+    for(int i = 0; i < 16; i ++) {
+        s[i] = pt[i] ^ k[i];
+    }
+
+    for(int round = 1; round <= 10; round ++) {
+        // SubBytes and ShiftRows
+        for(int c = 0; c < 4; c ++) {
+            for(int r = 0; r < 4; r ++) {
+                t[4*c + r] = aes_sbox[s[4*((c + r) & 3) + r]];
+            }
+        }
+        if(round != 10) {
+            for(int c = 0; c < 4; c ++) {
+                aes_mix_column(&t[4*c]);
+            }
+        }
+        for(int i = 0; i < 16; i ++) {
+            s[i] = t[i] ^ k[16*round + i];
+        }
+    }
+
+    for(int i = 0; i < 16; i ++) {
+        ct[i] = s[i];
+    }
+}
+
+static void aes_dec_plain(uint8_t pt[16], const uint8_t ct[16],
+                          const uint32_t rk[44]) {
+    const uint8_t * k = (const uint8_t*)rk;
+    uint8_t s[16], t[16];
+
+    for(int i = 0; i < 16; i ++) {
+        s[i] = ct[i] ^ k[160 + i];
+    }
+
+    for(int round = 9; round >= 0; round --) {
+        // InvShiftRows and InvSubBytes
+        for(int c = 0; c < 4; c ++) {
+            for(int r = 0; r < 4; r ++) {
+                t[4*c + r] = aes_inv_sbox[s[4*((c - r) & 3) + r]];
+            }
+        }
+        for(int i = 0; i < 16; i ++) {
+            s[i] = t[i] ^ k[16*round + i];
+        }
+        if(round != 0) {
+            for(int c = 0; c < 4; c ++) {
+                aes_inv_mix_column(&s[4*c]);
+            }
+        }
+    }
+
+    for(int i = 0; i < 16; i ++) {
+        pt[i] = s[i];
+    }
+}
+
+//
+// XCrypto implementation
+// ------------------------------------------------------------
+
+#ifdef CB_XCRYPTO
+
+static inline uint32_t xc_aessub_enc(uint32_t a) {
+    uint32_t rd;
+    __asm__ ("xc.aessub.enc %0, %1, %1" : "=r"(rd) : "r"(a));
+    return rd;
+}
+
+static inline uint32_t xc_aessub_dec(uint32_t a) {
+    uint32_t rd;
+    __asm__ ("xc.aessub.dec %0, %1, %1" : "=r"(rd) : "r"(a));
+    return rd;
+}
+
+static inline uint32_t xc_aesmix_enc(uint32_t a) {
+    uint32_t rd;
+    __asm__ ("xc.aesmix.enc %0, %1, %1" : "=r"(rd) : "r"(a));
+    return rd;
+}
+
+static inline uint32_t xc_aesmix_dec(uint32_t a) {
+    uint32_t rd;
+    __asm__ ("xc.aesmix.dec %0, %1, %1" : "=r"(rd) : "r"(a));
+    return rd;
+}
+
+static void aes_enc_xc(uint32_t ct[4], const uint32_t pt[4],
+                       const uint32_t rk[44]) {
+    uint32_t s0 = pt[0] ^ rk[0];
+    uint32_t s1 = pt[1] ^ rk[1];
+    uint32_t s2 = pt[2] ^ rk[2];
+    uint32_t s3 = pt[3] ^ rk[3];
+
+    for(int round = 1; round <= 10; round ++) {
+        uint32_t t0 = xc_aessub_enc(s0);
+        uint32_t t1 = xc_aessub_enc(s1);
+        uint32_t t2 = xc_aessub_enc(s2);
+        uint32_t t3 = xc_aessub_enc(s3);
+
+        // ShiftRows: row r of column c comes from column c+r.
+        s0 = (t0 & M0) | (t1 & M1) | (t2 & M2) | (t3 & M3);
+        s1 = (t1 & M0) | (t2 & M1) | (t3 & M2) | (t0 & M3);
+        s2 = (t2 & M0) | (t3 & M1) | (t0 & M2) | (t1 & M3);
+        s3 = (t3 & M0) | (t0 & M1) | (t1 & M2) | (t2 & M3);
+
+        if(round != 10) {
+            s0 = xc_aesmix_enc(s0);
+            s1 = xc_aesmix_enc(s1);
+            s2 = xc_aesmix_enc(s2);
+            s3 = xc_aesmix_enc(s3);
+        }
+
+        s0 ^= rk[4*round + 0];
+        s1 ^= rk[4*round + 1];
+        s2 ^= rk[4*round + 2];
+        s3 ^= rk[4*round + 3];
+    }
+
+    ct[0] = s0; ct[1] = s1; ct[2] = s2; ct[3] = s3;
+}
+
+static void aes_dec_xc(uint32_t pt[4], const uint32_t ct[4],
+                       const uint32_t rk[44]) {
+    uint32_t s0 = ct[0] ^ rk[40];
+    uint32_t s1 = ct[1] ^ rk[41];
+    uint32_t s2 = ct[2] ^ rk[42];
+    uint32_t s3 = ct[3] ^ rk[43];
+
+    for(int round = 9; round >= 0; round --) {
+        uint32_t t0 = xc_aessub_dec(s0);
+        uint32_t t1 = xc_aessub_dec(s1);
+        uint32_t t2 = xc_aessub_dec(s2);
+        uint32_t t3 = xc_aessub_dec(s3);
+
+        // InvShiftRows: row r of column c comes from column c-r.
+        s0 = (t0 & M0) | (t3 & M1) | (t2 & M2) | (t1 & M3);
+        s1 = (t1 & M0) | (t0 & M1) | (t3 & M2) | (t2 & M3);
+        s2 = (t2 & M0) | (t1 & M1) | (t0 & M2) | (t3 & M3);
+        s3 = (t3 & M0) | (t2 & M1) | (t1 & M2) | (t0 & M3);
+
+        s0 ^= rk[4*round + 0];
+        s1 ^= rk[4*round + 1];
+        s2 ^= rk[4*round + 2];
+        s3 ^= rk[4*round + 3];
+
+        if(round != 0) {
+            s0 = xc_aesmix_dec(s0);
+            s1 = xc_aesmix_dec(s1);
+            s2 = xc_aesmix_dec(s2);
+            s3 = xc_aesmix_dec(s3);
+        }
+    }
+
+    pt[0] = s0; pt[1] = s1; pt[2] = s2; pt[3] = s3;
+}
+
+#define aes_enc(ct,pt,rk) aes_enc_xc((uint32_t*)(ct),(const uint32_t*)(pt),rk)
+#define aes_dec(pt,ct,rk) aes_dec_xc((uint32_t*)(pt),(const uint32_t*)(ct),rk)
+
+#else
+
+#define aes_enc(ct,pt,rk) aes_enc_plain(ct,pt,rk)
+#define aes_dec(pt,ct,rk) aes_dec_plain(pt,ct,rk)
+
+#endif
+
+//
+// Kernel interface
+// ------------------------------------------------------------
+
+// FIPS-197 Appendix C.1 test vector.
+static const uint32_t kat_key[4] = {0x03020100, 0x07060504,
+                                    0x0b0a0908, 0x0f0e0d0c};
+static const uint32_t kat_pt [4] = {0x33221100, 0x77665544,
+                                    0xbbaa9988, 0xffeeddcc};
+static const uint32_t kat_ct [4] = {0xd8e0c469, 0x30047b6a,
+                                    0x80b7cdd8, 0x5ac5b470};
+
+int cb_check() {
+    uint32_t rk[44];
+    uint32_t out[4];
+    int      fail = 0;
+
+    aes_init_tables();
+    aes_key_schedule(rk, (const uint8_t*)kat_key);
+
+    aes_enc_plain((uint8_t*)out, (const uint8_t*)kat_pt, rk);
+    for(int i = 0; i < 4; i ++) { fail |= out[i] != kat_ct[i]; }
+
+    aes_dec_plain((uint8_t*)out, (const uint8_t*)kat_ct, rk);
+    for(int i = 0; i < 4; i ++) { fail |= out[i] != kat_pt[i]; }
+
+    aes_enc(out, kat_pt, rk);
+    for(int i = 0; i < 4; i ++) { fail |= out[i] != kat_ct[i]; }
+
+    aes_dec(out, kat_ct, rk);
+    for(int i = 0; i < 4; i ++) { fail |= out[i] != kat_pt[i]; }
+
+    return fail;
+}
+
+void cb_setup() {
+    aes_key_schedule(aes_rk, (const uint8_t*)kat_key);
+}
+
+void cb_run(uint8_t * buf, int nblocks) {
+    for(int i = 0; i < nblocks; i ++) {
+        uint8_t * blk = buf + 16*i;
+#ifdef CB_AES_DEC
+        aes_dec(blk, blk, aes_rk);
+#else
+        aes_enc(blk, blk, aes_rk);
+#endif
+    }
+}
@@ -0,0 +1,47 @@
+
+#include "cryptobench.h"
+
+// Used by __puthex*
+static char * lut = "0123456789ABCDEF";
+
+volatile uint32_t * UART = (volatile uint32_t*)0x40600000;
+
+//! Write a character to the uart.
+void __putchar(char c) {
+    UART[0] = c;
+}
+
+//! Write a null terminated string to the uart.
+void __putstr(char *s) {
+    int i = 0;
+    if(s[0] == 0) {
+        return;
+    }
+    do {
+        uint32_t tw = s[i];
+        UART[0]     = tw;
+        i++;
+    } while(s[i] != 0) ;
+}
+
+//! Print an unsigned number in decimal.
+void __putdec(uint64_t w) {
+    char buf[21];
+    int  i = 20;
+    buf[i] = 0;
+    do {
+        buf[--i] = lut[w % 10];
+        w        = w / 10;
+    } while(w != 0);
+    __putstr(&buf[i]);
+}
+
+//! Print a 32-bit number as hex
+void __puthex32(uint32_t w) {
+    for(int i =  3; i >= 0; i --) {
+        uint8_t b_0 = (w >> (8*i    )) & 0xF;
+        uint8_t b_1 = (w >> (8*i + 4)) & 0xF;
+        __putchar(lut[b_1]);
+        __putchar(lut[b_0]);
+    }
+}
@@ -0,0 +1,58 @@
+
+#include <stdint.h>
+
+#ifndef CRYPTOBENCH_H
+#define CRYPTOBENCH_H
+
+// ----------- Defined in flow/embench/boot.S ------
+
+//! Called if the benchmark fails
+void test_fail();
+
+//! Called if the benchmark passes
+void test_pass();
+
+// ----------- Defined in flow/embench/util.S ------
+
+//! Intrisic for the `rdcycle` assembly instruction
+volatile uint64_t __rdcycle();
+
+//! Intrisic for the `rdinstret` assembly instruction
+volatile uint64_t __rdinstret();
+
+// ----------- Defined in cryptobench.c ------------
+
+//! Write a character to the uart.
+void __putchar(char c) ;
+
+//! Write a null terminated string to the uart.
+void __putstr(char *s) ;
+
+//! Print an unsigned number in decimal.
+void __putdec(uint64_t w);
+
+//! Print a 32-bit number as hex
+void __puthex32(uint32_t w);
+
+// ----------- Defined by each kernel --------------
+
+//! Name of the kernel, as printed in the results.
+extern char *    cb_name;
+
+//! Number of bytes processed per block by the kernel.
+extern const int cb_block_bytes;
+
+/*!
+@brief Known answer test and cross check of the implementation under test
+       against the plain ISA reference.
+@returns 0 on success, non-zero on failure.
+*/
+int  cb_check();
+
+//! Setup any key / state needed before cb_run is called.
+void cb_setup();
+
+//! Process nblocks blocks of buf in place, using the implementation under test.
+void cb_run(uint8_t * buf, int nblocks);
+
+#endif
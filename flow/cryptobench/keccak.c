@@ -0,0 +1,199 @@
+
+//
+// Keccak-f[1600] permutation, absorbing SHA3-256 rate (136 byte) blocks.
+//
+//  Both versions are the same compact, loop based implementation. Lanes
+//  are addressed by byte offset (x%5 + 5*(y%5)) * 8. The plain version
+//  computes these offsets with remainder operations, the xcrypto version
+//  with xc.sha3.xy / x1 / x2 / x4 / yx and a shift amount of 3.
+//
+
+#include "cryptobench.h"
+
+char *    cb_name        = "keccak-f1600";
+
+const int cb_block_bytes = 136;
+
+static const uint64_t keccak_rc[24] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808AULL,
+    0x8000000080008000ULL, 0x000000000000808BULL, 0x0000000080000001ULL,
+    0x8000000080008081ULL, 0x8000000000008009ULL, 0x000000000000008AULL,
+    0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000AULL,
+    0x000000008000808BULL, 0x800000000000008BULL, 0x8000000000008089ULL,
+    0x8000000000008003ULL, 0x8000000000008002ULL, 0x8000000000000080ULL,
+    0x000000000000800AULL, 0x800000008000000AULL, 0x8000000080008081ULL,
+    0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+
+//! Rotation offsets, indexed by x + 5*y.
+static const uint8_t keccak_rho[25] = {
+     0,  1, 62, 28, 27,
+    36, 44,  6, 55, 20,
+     3, 10, 43, 25, 39,
+    41, 45, 15, 21,  8,
+    18,  2, 61, 56, 14
+};
+
+//! Permutation state used by cb_run.
+static uint64_t keccak_a[25];
+
+#define ROL64(x,n) ((n) ? (((x) << (n)) | ((x) >> (64 - (n)))) : (x))
+
+#define LANE(A,off) (*(uint64_t*)((uint8_t*)(A) + (off)))
+
+//
+// Lane offset functions
+// ------------------------------------------------------------
+
+static inline uint32_t xy_plain(uint32_t x, uint32_t y) {
+    return ((x % 5) + 5*(y % 5)) << 3;
+}
+static inline uint32_t x1_plain(uint32_t x, uint32_t y) {
+    return (((x+1) % 5) + 5*(y % 5)) << 3;
+}
+static inline uint32_t x2_plain(uint32_t x, uint32_t y) {
+    return (((x+2) % 5) + 5*(y % 5)) << 3;
+}
+static inline uint32_t x4_plain(uint32_t x, uint32_t y) {
+    return (((x+4) % 5) + 5*(y % 5)) << 3;
+}
+static inline uint32_t yx_plain(uint32_t x, uint32_t y) {
+    return ((y % 5) + 5*((2*x + 3*y) % 5)) << 3;
+}
+
+#ifdef CB_XCRYPTO
+static inline uint32_t xy_xc(uint32_t x, uint32_t y) {
+    uint32_t rd; __asm__ ("xc.sha3.xy %0, %1, %2, 3" : "=r"(rd) : "r"(x), "r"(y));
+    return rd;
+}
+static inline uint32_t x1_xc(uint32_t x, uint32_t y) {
+    uint32_t rd; __asm__ ("xc.sha3.x1 %0, %1, %2, 3" : "=r"(rd) : "r"(x), "r"(y));
+    return rd;
+}
+static inline uint32_t x2_xc(uint32_t x, uint32_t y) {
+    uint32_t rd; __asm__ ("xc.sha3.x2 %0, %1, %2, 3" : "=r"(rd) : "r"(x), "r"(y));
+    return rd;
+}
+static inline uint32_t x4_xc(uint32_t x, uint32_t y) {
+    uint32_t rd; __asm__ ("xc.sha3.x4 %0, %1, %2, 3" : "=r"(rd) : "r"(x), "r"(y));
+    return rd;
+}
+static inline uint32_t yx_xc(uint32_t x, uint32_t y) {
+    uint32_t rd; __asm__ ("xc.sha3.yx %0, %1, %2, 3" : "=r"(rd) : "r"(x), "r"(y));
+    return rd;
+}
+#endif
+
+//
+// Permutation
+// ------------------------------------------------------------
+
+typedef uint32_t (*keccak_idx_t)(uint32_t, uint32_t);
+
+/*!
+@brief Apply Keccak-f[1600] to the state A.
+@details Always inlined, so the offset function pointers are constant
+         and are themselves inlined.
+*/
+static inline __attribute__((always_inline)) void keccak_f1600(
+    uint64_t     A[25],
+    keccak_idx_t xy   ,
+    keccak_idx_t x1   ,
+    keccak_idx_t x2   ,
+    keccak_idx_t x4   ,
+    keccak_idx_t yx
+) {
+    uint64_t B[25];
+    uint64_t C[ 5];
+
+    for(int round = 0; round < 24; round ++) {
+
+        // Theta
+        for(int x = 0; x < 5; x ++) {
+            C[x] = 0;
+            for(int y = 0; y < 5; y ++) {
+                C[x] ^= LANE(A, xy(x,y));
+            }
+        }
+        for(int x = 0; x < 5; x ++) {
+            uint64_t D = LANE(C, x4(x,0)) ^ ROL64(LANE(C, x1(x,0)), 1);
+            for(int y = 0; y < 5; y ++) {
+                LANE(A, xy(x,y)) ^= D;
+            }
+        }
+
+        // Rho and Pi
+        for(int x = 0; x < 5; x ++) {
+            for(int y = 0; y < 5; y ++) {
+                uint32_t i = xy(x,y);
+                LANE(B, yx(x,y)) = ROL64(LANE(A, i), keccak_rho[i >> 3]);
+            }
+        }
+
+        // Chi
+        for(int x = 0; x < 5; x ++) {
+            for(int y = 0; y < 5; y ++) {
+                LANE(A, xy(x,y)) = LANE(B, xy(x,y)) ^
+                                  (~LANE(B, x1(x,y)) & LANE(B, x2(x,y)));
+            }
+        }
+
+        // Iota
+        A[0] ^= keccak_rc[round];
+    }
+}
+
+static void keccak_f1600_plain(uint64_t A[25]) {
+    keccak_f1600(A, xy_plain, x1_plain, x2_plain, x4_plain, yx_plain);
+}
+
+#ifdef CB_XCRYPTO
+static void keccak_f1600_xc(uint64_t A[25]) {
+    keccak_f1600(A, xy_xc, x1_xc, x2_xc, x4_xc, yx_xc);
+}
+#define keccak_f1600_dut keccak_f1600_xc
+#else
+#define keccak_f1600_dut keccak_f1600_plain
+#endif
+
+//
+// Kernel interface
+// ------------------------------------------------------------
+
+// Keccak-f[1600] applied to the all zero state.
+static const uint64_t kat_lane0 = 0xF1258F7940E1DDE7ULL;
+static const uint64_t kat_lane1 = 0x84D5CCF933C0478AULL;
+
+int cb_check() {
+    uint64_t a_ref[25], a_dut[25];
+    int      fail = 0;
+
+    for(int i = 0; i < 25; i ++) { a_ref[i] = a_dut[i] = 0; }
+
+    keccak_f1600_plain(a_ref);
+    keccak_f1600_dut  (a_dut);
+
+    fail |= a_ref[0] != kat_lane0 || a_ref[1] != kat_lane1;
+
+    // Second permutation from a non-trivial state.
+    keccak_f1600_plain(a_ref);
+    keccak_f1600_dut  (a_dut);
+
+    for(int i = 0; i < 25; i ++) { fail |= a_ref[i] != a_dut[i]; }
+
+    return fail;
+}
+
+void cb_setup() {
+    for(int i = 0; i < 25; i ++) { keccak_a[i] = 0; }
+}
+
+void cb_run(uint8_t * buf, int nblocks) {
+    for(int i = 0; i < nblocks; i ++) {
+        const uint64_t * blk = (const uint64_t*)(buf + 136*i);
+        for(int j = 0; j < 136/8; j ++) {
+            keccak_a[j] ^= blk[j];
+        }
+        keccak_f1600_dut(keccak_a);
+    }
+}
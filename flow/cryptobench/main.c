@@ -0,0 +1,102 @@
+
+#include "cryptobench.h"
+
+#ifdef CB_XCRYPTO
+#define CB_IMPL "xcrypto"
+#else
+#define CB_IMPL "plain"
+#endif
+
+//! Message sizes to time, in blocks.
+static const int cb_sizes[]   = {1, 4, 16, 64};
+
+#define CB_NUM_SIZES ((int)(sizeof(cb_sizes) / sizeof(cb_sizes[0])))
+
+//! Largest block size of any kernel, in bytes.
+#define CB_MAX_BLOCK_BYTES  136
+
+//! Largest message size, in blocks.
+#define CB_MAX_BLOCKS       64
+
+//! Message buffer. Word aligned so kernels can access it as words.
+static uint32_t cb_buf[CB_MAX_BLOCKS * CB_MAX_BLOCK_BYTES / 4];
+
+//! Fill the message buffer with a fixed pseudo-random pattern.
+static void cb_fill(int nbytes) {
+    uint32_t x = 0x2545F491;
+    for(int i = 0; i < nbytes / 4; i ++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x <<  5;
+        cb_buf[i] = x;
+    }
+}
+
+//! Print a fixed point number with two decimal places.
+static void cb_putfixed(uint64_t num, uint64_t den) {
+    uint64_t f = (num * 100) / den;
+    uint64_t r = f % 100;
+    __putdec(f / 100);
+    __putchar('.');
+    if(r < 10) {
+        __putchar('0');
+    }
+    __putdec(r);
+}
+
+//! Main entry point, called from boot.S
+int main() {
+
+    uint64_t total_cycles = 0;
+
+    __putstr("Kernel: "); __putstr(cb_name);
+    __putstr(" (" CB_IMPL ")\n");
+
+    if(cb_check()) {
+        __putstr("Check: FAIL\n");
+        return 1;
+    }
+
+    __putstr("Check: pass\n");
+
+    cb_setup();
+
+    __putstr("blocks\tbytes\tcycles\tinstrs\tcycles/byte\tcycles/block\n");
+
+    for(int i = 0; i < CB_NUM_SIZES; i ++) {
+
+        int nblocks = cb_sizes[i];
+        int nbytes  = nblocks * cb_block_bytes;
+
+        cb_fill(nbytes);
+
+        uint64_t i_start = __rdinstret();
+        uint64_t c_start = __rdcycle();
+
+        cb_run((uint8_t*)cb_buf, nblocks);
+
+        uint64_t i_end   = __rdinstret();
+        uint64_t c_end   = __rdcycle();
+
+        uint64_t count_instrs = i_end - i_start;
+        uint64_t count_cycles = c_end - c_start;
+
+        total_cycles += count_cycles;
+
+        __putdec(nblocks)       ; __putchar('\t');
+        __putdec(nbytes)        ; __putchar('\t');
+        __putdec(count_cycles)  ; __putchar('\t');
+        __putdec(count_instrs)  ; __putchar('\t');
+        cb_putfixed(count_cycles, nbytes ); __putchar('\t');
+        cb_putfixed(count_cycles, nblocks); __putchar('\n');
+
+    }
+
+    // Summary line, in the same form as the embench flow prints.
+    __putstr("Cycles: "); __putdec(total_cycles); __putchar('\n');
+
+    __putstr("--- Finished --- \n");
+
+    return 0;
+
+}
@@ -0,0 +1,173 @@
+
+//
+// 256-bit Montgomery modular multiplication (CIOS), modulo the NIST P-256
+// prime. Each block is one 256-bit operand, which is replaced by its
+// product with a fixed operand.
+//
+//  The xcrypto version uses xc.mmul.3 for the inner multiply-accumulate.
+//
+
+#include "cryptobench.h"
+
+char *    cb_name        = "mpmul-256";
+
+const int cb_block_bytes = 32;
+
+#define MP_LIMBS 8
+
+//! P-256 prime, least significant limb first.
+static const uint32_t mp_p[MP_LIMBS] = {
+    0xffffffff, 0xffffffff, 0xffffffff, 0x00000000,
+    0x00000000, 0x00000000, 0x00000001, 0xffffffff
+};
+
+//! -p^-1 mod 2^32
+static const uint32_t mp_pinv = 0x00000001;
+
+//! Fixed operand used by cb_run.
+static const uint32_t mp_a[MP_LIMBS] = {
+    0x89abcdef, 0x01234567, 0xdeadbeef, 0x0badf00d,
+    0x13579bdf, 0x2468ace0, 0x55aa55aa, 0x7fffffff
+};
+
+//
+// Multiply-accumulate: a*b + c as a 64-bit result.
+// ------------------------------------------------------------
+
+static inline uint64_t mac_plain(uint32_t a, uint32_t b, uint32_t c) {
+    return (uint64_t)a * b + c;
+}
+
+#ifdef CB_XCRYPTO
+static inline uint64_t mac_xc(uint32_t a, uint32_t b, uint32_t c) {
+    // xc.mmul.3 writes the low half to an even register and the high
+    // half to the next one. Spelled with .insn so the register pair is
+    // explicit.
+    register uint32_t lo __asm__("t1");
+    register uint32_t hi __asm__("t2");
+    __asm__ (".insn r4 0x23, 4, 2, %0, %2, %3, %4  // xc.mmul.3"
+        : "=r"(lo), "=r"(hi) : "r"(a), "r"(b), "r"(c));
+    return ((uint64_t)hi << 32) | lo;
+}
+#endif
+
+//
+// Montgomery multiplication: r = a * b * 2^-256 mod p
+// ------------------------------------------------------------
+
+typedef uint64_t (*mp_mac_t)(uint32_t, uint32_t, uint32_t);
+
+/*!
+@brief Montgomery multiply, coarsely integrated operand scanning.
+@details Always inlined, so the mac function pointer is constant and is
+         itself inlined.
+*/
+static inline __attribute__((always_inline)) void mp_montmul(
+    uint32_t       r[MP_LIMBS],
+    const uint32_t a[MP_LIMBS],
+    const uint32_t b[MP_LIMBS],
+    mp_mac_t       mac
+) {
+    uint32_t t[MP_LIMBS + 2];
+    uint64_t acc;
+
+    for(int i = 0; i < MP_LIMBS + 2; i ++) { t[i] = 0; }
+
+    for(int i = 0; i < MP_LIMBS; i ++) {
+
+        uint32_t c = 0;
+
+        for(int j = 0; j < MP_LIMBS; j ++) {
+            acc  = mac(a[j], b[i], t[j]) + c;
+            t[j] = (uint32_t)acc;
+            c    = acc >> 32;
+        }
+        acc          = (uint64_t)t[MP_LIMBS] + c;
+        t[MP_LIMBS  ]= (uint32_t)acc;
+        t[MP_LIMBS+1]= acc >> 32;
+
+        uint32_t m = t[0] * mp_pinv;
+
+        acc = mac(m, mp_p[0], t[0]);
+        c   = acc >> 32;
+
+        for(int j = 1; j < MP_LIMBS; j ++) {
+            acc    = mac(m, mp_p[j], t[j]) + c;
+            t[j-1] = (uint32_t)acc;
+            c      = acc >> 32;
+        }
+        acc            = (uint64_t)t[MP_LIMBS] + c;
+        t[MP_LIMBS-1]  = (uint32_t)acc;
+        t[MP_LIMBS  ]  = t[MP_LIMBS+1] + (acc >> 32);
+    }
+
+    // Conditional final subtraction of p.
+    uint32_t s[MP_LIMBS];
+    uint32_t borrow = 0;
+    for(int i = 0; i < MP_LIMBS; i ++) {
+        uint64_t d = (uint64_t)t[i] - mp_p[i] - borrow;
+        s[i]   = (uint32_t)d;
+        borrow = (d >> 32) & 1;
+    }
+
+    int use_s = t[MP_LIMBS] || !borrow;
+
+    for(int i = 0; i < MP_LIMBS; i ++) {
+        r[i] = use_s ? s[i] : t[i];
+    }
+}
+
+static void mp_montmul_plain(uint32_t * r, const uint32_t * a,
+                             const uint32_t * b) {
+    mp_montmul(r, a, b, mac_plain);
+}
+
+#ifdef CB_XCRYPTO
+static void mp_montmul_xc(uint32_t * r, const uint32_t * a,
+                          const uint32_t * b) {
+    mp_montmul(r, a, b, mac_xc);
+}
+#define mp_montmul_dut mp_montmul_xc
+#else
+#define mp_montmul_dut mp_montmul_plain
+#endif
+
+//
+// Kernel interface
+// ------------------------------------------------------------
+
+static const uint32_t kat_b[MP_LIMBS] = {
+    0x76543210, 0xfedcba98, 0x0f1e2d3c, 0x4b5a6978,
+    0x87a5c3e1, 0x0c0ffee0, 0x31415926, 0x27182818
+};
+
+//! mp_a * kat_b * 2^-256 mod p
+static const uint32_t kat_r[MP_LIMBS] = {
+    0x2751dd41, 0xfd4d4fae, 0xca5e8c92, 0xb2363a5d,
+    0x48a418b5, 0x85110546, 0x7a10a3dc, 0x8915160f
+};
+
+int cb_check() {
+    uint32_t r_ref[MP_LIMBS], r_dut[MP_LIMBS];
+    int      fail = 0;
+
+    mp_montmul_plain(r_ref, mp_a, kat_b);
+    mp_montmul_dut  (r_dut, mp_a, kat_b);
+
+    for(int i = 0; i < MP_LIMBS; i ++) {
+        fail |= r_ref[i] != kat_r[i];
+        fail |= r_dut[i] != kat_r[i];
+    }
+
+    return fail;
+}
+
+void cb_setup() {
+}
+
+void cb_run(uint8_t * buf, int nblocks) {
+    for(int i = 0; i < nblocks; i ++) {
+        uint32_t * blk = (uint32_t*)(buf + 32*i);
+        mp_montmul_dut(blk, mp_a, blk);
+    }
+}
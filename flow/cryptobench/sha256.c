@@ -0,0 +1,175 @@
+
+//
+// SHA-256 compression function.
+//
+//  The xcrypto version uses xc.sha256.s0-s3 for the four sigma functions.
+//
+
+#include "cryptobench.h"
+
+char *    cb_name        = "sha256";
+
+const int cb_block_bytes = 64;
+
+static const uint32_t sha256_iv[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+static const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+//! Hash state used by cb_run.
+static uint32_t sha256_h[8];
+
+#define ROR32(x,n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+//
+// Sigma functions
+// ------------------------------------------------------------
+
+static inline uint32_t s0_plain(uint32_t x) {
+    return ROR32(x, 7) ^ ROR32(x,18) ^ (x >>  3);
+}
+static inline uint32_t s1_plain(uint32_t x) {
+    return ROR32(x,17) ^ ROR32(x,19) ^ (x >> 10);
+}
+static inline uint32_t s2_plain(uint32_t x) {
+    return ROR32(x, 2) ^ ROR32(x,13) ^ ROR32(x,22);
+}
+static inline uint32_t s3_plain(uint32_t x) {
+    return ROR32(x, 6) ^ ROR32(x,11) ^ ROR32(x,25);
+}
+
+#ifdef CB_XCRYPTO
+static inline uint32_t s0_xc(uint32_t x) {
+    uint32_t rd; __asm__ ("xc.sha256.s0 %0, %1" : "=r"(rd) : "r"(x));
+    return rd;
+}
+static inline uint32_t s1_xc(uint32_t x) {
+    uint32_t rd; __asm__ ("xc.sha256.s1 %0, %1" : "=r"(rd) : "r"(x));
+    return rd;
+}
+static inline uint32_t s2_xc(uint32_t x) {
+    uint32_t rd; __asm__ ("xc.sha256.s2 %0, %1" : "=r"(rd) : "r"(x));
+    return rd;
+}
+static inline uint32_t s3_xc(uint32_t x) {
+    uint32_t rd; __asm__ ("xc.sha256.s3 %0, %1" : "=r"(rd) : "r"(x));
+    return rd;
+}
+#endif
+
+//
+// Compression function
+// ------------------------------------------------------------
+
+typedef uint32_t (*sha256_sigma_t)(uint32_t);
+
+/*!
+@brief Compress one 64-byte block into the hash state.
+@details Always inlined, so the sigma function pointers are constant
+         and are themselves inlined.
+*/
+static inline __attribute__((always_inline)) void sha256_compress(
+    uint32_t        h[8],
+    const uint8_t * blk ,
+    sha256_sigma_t  s0  ,
+    sha256_sigma_t  s1  ,
+    sha256_sigma_t  s2  ,
+    sha256_sigma_t  s3
+) {
+    uint32_t w[64];
+
+    for(int i = 0; i < 16; i ++) {
+        w[i] = ((uint32_t)blk[4*i+0] << 24) | ((uint32_t)blk[4*i+1] << 16) |
+               ((uint32_t)blk[4*i+2] <<  8) | ((uint32_t)blk[4*i+3] <<  0) ;
+    }
+    for(int i = 16; i < 64; i ++) {
+        w[i] = s1(w[i-2]) + w[i-7] + s0(w[i-15]) + w[i-16];
+    }
+
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3];
+    uint32_t e = h[4], f = h[5], g = h[6], k = h[7];
+
+    for(int i = 0; i < 64; i ++) {
+        uint32_t t1 = k + s3(e) + ((e & f) ^ (~e & g)) + sha256_k[i] + w[i];
+        uint32_t t2 = s2(a) + ((a & b) ^ (a & c) ^ (b & c));
+        k = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+    h[4] += e; h[5] += f; h[6] += g; h[7] += k;
+}
+
+static void sha256_compress_plain(uint32_t h[8], const uint8_t * blk) {
+    sha256_compress(h, blk, s0_plain, s1_plain, s2_plain, s3_plain);
+}
+
+#ifdef CB_XCRYPTO
+static void sha256_compress_xc(uint32_t h[8], const uint8_t * blk) {
+    sha256_compress(h, blk, s0_xc, s1_xc, s2_xc, s3_xc);
+}
+#define sha256_compress_dut sha256_compress_xc
+#else
+#define sha256_compress_dut sha256_compress_plain
+#endif
+
+//
+// Kernel interface
+// ------------------------------------------------------------
+
+// SHA-256("abc"), FIPS 180-2 Appendix B.1
+static const uint32_t kat_digest[8] = {
+    0xba7816bf, 0x8f01cfea, 0x414140de, 0x5dae2223,
+    0xb00361a3, 0x96177a9c, 0xb410ff61, 0xf20015ad
+};
+
+int cb_check() {
+    uint8_t  blk[64];
+    uint32_t h_ref[8], h_dut[8];
+    int      fail = 0;
+
+    for(int i = 0; i < 64; i ++) { blk[i] = 0; }
+    blk[0] = 'a'; blk[1] = 'b'; blk[2] = 'c'; blk[3] = 0x80;
+    blk[63] = 24;
+
+    for(int i = 0; i < 8; i ++) { h_ref[i] = h_dut[i] = sha256_iv[i]; }
+
+    sha256_compress_plain(h_ref, blk);
+    sha256_compress_dut  (h_dut, blk);
+
+    for(int i = 0; i < 8; i ++) {
+        fail |= h_ref[i] != kat_digest[i];
+        fail |= h_dut[i] != kat_digest[i];
+    }
+
+    return fail;
+}
+
+void cb_setup() {
+    for(int i = 0; i < 8; i ++) { sha256_h[i] = sha256_iv[i]; }
+}
+
+void cb_run(uint8_t * buf, int nblocks) {
+    for(int i = 0; i < nblocks; i ++) {
+        sha256_compress_dut(sha256_h, buf + 64*i);
+    }
+}
@@ -0,0 +1,94 @@
+#!/usr/bin/python3
+
+"""
+Aggregate the instruction mix reports of embench-batch (+INSTR_MIX_JSON):
+the share of instructions and cycles of each instruction class, per
+benchmark and over all of them, and the most used mnemonics overall.
+"""
+
+import sys
+import json
+import argparse
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("reports", nargs="+",
+        help="Instruction mix JSON files, one per benchmark.")
+    parser.add_argument("--top", type=int, default=20,
+        help="Number of mnemonics to list.")
+    parser.add_argument("--json",
+        help="Also write the totals here.")
+    args = parser.parse_args()
+
+    names     = []
+    reports   = []
+    for path in args.reports:
+        with open(path, "r") as fh:
+            reports.append(json.load(fh))
+        # .../src/<benchmark>/benchmark.mix.json
+        parts = path.split("/")
+        names.append(parts[-2] if len(parts) > 1 else path)
+
+    classes   = list(reports[0]["classes"].keys()) if reports else []
+    total     = {"instrs": 0, "cycles": 0,
+                 "classes"  : {c: {"instrs": 0, "cycles": 0} for c in classes},
+                 "mnemonics": {}}
+
+    for rep in reports:
+        total["instrs"] += rep["instrs"]
+        total["cycles"] += rep["cycles"]
+        for c, n in rep["classes"].items():
+            total["classes"][c]["instrs"] += n["instrs"]
+            total["classes"][c]["cycles"] += n["cycles"]
+        for m, n in rep["mnemonics"].items():
+            t = total["mnemonics"].setdefault(m, {"instrs": 0, "cycles": 0})
+            t["instrs"] += n["instrs"]
+            t["cycles"] += n["cycles"]
+
+    # Only classes some benchmark uses get a column.
+    used   = [c for c in classes if total["classes"][c]["instrs"]]
+
+    def pct(n, d):
+        return "%.2f" % (100.0 * n / d) if d else "-"
+
+    header = ["benchmark", "instrs", "cycles"] + \
+             ["%s %%i/%%c" % c for c in used]
+    rows   = []
+
+    for name, rep in sorted(zip(names, reports),
+                            key=lambda r: r[0]) + [("total", total)]:
+        rows.append([name, str(rep["instrs"]), str(rep["cycles"])] + [
+            pct(rep["classes"][c]["instrs"], rep["instrs"]) + "/" +
+            pct(rep["classes"][c]["cycles"], rep["cycles"]) for c in used])
+
+    widths = [max(len(r[i]) for r in [header] + rows)
+              for i in range(len(header))]
+
+    def line(cols):
+        return "| " + " | ".join(
+            c.rjust(w) for c, w in zip(cols, widths)) + " |"
+
+    print(line(header))
+    print("|" + "|".join("-" * (w + 2) for w in widths) + "|")
+    for row in rows:
+        print(line(row))
+
+    print()
+    print("Most used mnemonics, by cycles:")
+    top = sorted(total["mnemonics"].items(),
+                 key=lambda m: m[1]["cycles"], reverse=True)[:args.top]
+    for m, n in top:
+        print("  %-20s %12d instrs (%6s%%) %12d cycles (%6s%%)" % (
+              m, n["instrs"], pct(n["instrs"], total["instrs"]),
+              n["cycles"], pct(n["cycles"], total["cycles"])))
+
+    if(args.json):
+        with open(args.json, "w") as fh:
+            json.dump(total, fh, indent=2)
+
+    return 0
+
+
+if(__name__ == "__main__"):
+    sys.exit(main())
@@ -16,6 +16,8 @@ int main() {
     
     __putstr("Run Bechmark...\n");
 
+    __roi_begin();
+
     uint64_t i_start = __rdinstret();
     uint64_t c_start = __rdcycle();
     
@@ -24,6 +26,8 @@ int main() {
     uint64_t i_end   = __rdinstret();
     uint64_t c_end   = __rdcycle();
 
+    __roi_end();
+
     uint64_t count_instrs = i_end - i_start;
     uint64_t count_cycles = c_end - c_start;
 
@@ -0,0 +1,91 @@
+#!/usr/bin/python3
+
+"""
+Compare sampled simulation cycle estimates (embench-sample) against full
+simulation runs (embench-batch): error, whether the full result is inside
+the 95% bound, and the wall clock speedup.
+"""
+
+import sys
+import json
+import argparse
+
+
+def load_results(path):
+    """
+    Return a dict of name -> record from a batch results file.
+    """
+    records = {}
+    with open(path, "r") as fh:
+        for line in fh:
+            line = line.strip()
+            if(line):
+                rec = json.loads(line)
+                records[rec["name"]] = rec
+    return records
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--full", required=True,
+        help="Batch results of full runs.")
+    parser.add_argument("--sampled", required=True,
+        help="Batch results of sampled runs.")
+    args = parser.parse_args()
+
+    full    = load_results(args.full)
+    sampled = load_results(args.sampled)
+
+    header  = ["benchmark", "full", "sampled", "bound", "error %",
+               "in bound", "full s", "sampled s", "speedup"]
+    rows    = []
+    errors  = []
+    inside  = 0
+    t_full  = 0.0
+    t_samp  = 0.0
+
+    for name in sorted(set(full) & set(sampled)):
+        f = full[name]
+        s = sampled[name]
+
+        if(f["status"] != "pass" or s["status"] != "pass"):
+            rows.append([name, f["status"], s["status"]] + ["-"] * 6)
+            continue
+
+        err = 100.0 * (s["cycles"] - f["cycles"]) / f["cycles"]
+        ok  = abs(s["cycles"] - f["cycles"]) <= s["cycles_bound"]
+
+        errors.append(abs(err))
+        inside += 1 if ok else 0
+        t_full += f["wall_time"]
+        t_samp += s["wall_time"]
+
+        rows.append([name, str(f["cycles"]), str(s["cycles"]),
+            str(s["cycles_bound"]), "%+.2f" % err, "yes" if ok else "no",
+            "%.1f" % f["wall_time"], "%.1f" % s["wall_time"],
+            "%.1fx" % (f["wall_time"] / max(s["wall_time"], 0.001))])
+
+    widths = [max(len(r[i]) for r in [header] + rows)
+              for i in range(len(header))]
+
+    def line(cols):
+        return "| " + " | ".join(
+            c.rjust(w) for c, w in zip(cols, widths)) + " |"
+
+    print(line(header))
+    print("|" + "|".join("-" * (w + 2) for w in widths) + "|")
+    for row in rows:
+        print(line(row))
+
+    if(errors):
+        print()
+        print("Mean |error|: %.2f%%, max |error|: %.2f%%, %d/%d in bound, "
+              "total speedup %.1fx" % (
+              sum(errors) / len(errors), max(errors), inside, len(errors),
+              t_full / max(t_samp, 0.001)))
+
+    return 0
+
+
+if(__name__ == "__main__"):
+    sys.exit(main())
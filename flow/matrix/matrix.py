@@ -0,0 +1,114 @@
+#!/usr/bin/python3
+
+"""
+Collect the results of the build matrix flow into a single table of
+benchmark cycle counts vs. synthesised area, one row per configuration.
+"""
+
+import os
+import re
+import sys
+import argparse
+
+RE_CYCLES = re.compile(r"^\$?\s*Cycles:\s*(\d+)")
+RE_PASS   = re.compile(r"^>> SIM PASS")
+RE_AREA   = re.compile(r"Chip area for (?:top )?module.*:\s*([0-9.]+)")
+RE_CELLS  = re.compile(r"Number of cells:\s*(\d+)")
+
+
+def parse_bench_report(path):
+    """
+    Return the cycle count from a benchmark run report, or None if the
+    report is missing or the run did not pass.
+    """
+    if(not os.path.isfile(path)):
+        return None
+
+    cycles = None
+    passed = False
+
+    with open(path, "r") as fh:
+        for line in fh:
+            m = RE_CYCLES.match(line)
+            if(m):
+                cycles = int(m.group(1))
+            if(RE_PASS.match(line)):
+                passed = True
+
+    return cycles if passed else None
+
+
+def parse_synth_report(path):
+    """
+    Return (area, cells) from a yosys stat report. The last match in the
+    file is used, since it corresponds to the top level module.
+    """
+    area  = None
+    cells = None
+
+    if(not os.path.isfile(path)):
+        return (area, cells)
+
+    with open(path, "r") as fh:
+        for line in fh:
+            m = RE_AREA.search(line)
+            if(m):
+                area = float(m.group(1))
+            m = RE_CELLS.search(line)
+            if(m):
+                cells = int(m.group(1))
+
+    return (area, cells)
+
+
+def fmt(value):
+    if(value is None):
+        return "-"
+    if(isinstance(value, float)):
+        return "%.0f" % value
+    return str(value)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--work", required=True,
+        help="Build matrix work directory.")
+    parser.add_argument("--configs", nargs="+", required=True,
+        help="Configuration names, in table order.")
+    parser.add_argument("--benchmarks", nargs="+", required=True,
+        help="Benchmark names, in column order.")
+    args = parser.parse_args()
+
+    header = ["config", "area", "cells"] + args.benchmarks
+    rows   = []
+
+    for config in args.configs:
+        cdir        = os.path.join(args.work, config)
+        area, cells = parse_synth_report(
+            os.path.join(cdir, "synth", "synth-gates.rpt"))
+
+        row = [config, fmt(area), fmt(cells)]
+
+        for bench in args.benchmarks:
+            row.append(fmt(parse_bench_report(
+                os.path.join(cdir, bench + ".rpt"))))
+
+        rows.append(row)
+
+    widths = [max(len(r[i]) for r in [header] + rows)
+              for i in range(len(header))]
+
+    def line(cols):
+        return "| " + " | ".join(
+            c.rjust(w) for c, w in zip(cols, widths)) + " |"
+
+    print(line(header))
+    print("|" + "|".join("-" * (w + 2) for w in widths) + "|")
+    for row in rows:
+        print(line(row))
+
+    return 0
+
+
+if(__name__ == "__main__"):
+    sys.exit(main())
@@ -0,0 +1,498 @@
+
+#include <atomic>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "batch.hpp"
+#include "testbench.hpp"
+
+//! Names of each batch_status_t, as written to the results file.
+static const char * batch_status_names[] = {
+    "pass", "timeout", "fail", "sig_fail", "error", "cosim_fail",
+    "hang"
+};
+
+std::string json_escape(std::string const & s) {
+    std::string tr;
+    for(char c : s) {
+        if(c == '"' || c == '\\') {
+            tr += '\\';
+            tr += c;
+        } else if((unsigned char)c < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", (unsigned char)c);
+            tr += buf;
+        } else {
+            tr += c;
+        }
+    }
+    return tr;
+}
+
+//! Format one result record as a single line of JSON.
+static std::string batch_format_result (
+    size_t                 index ,
+    batch_job_t    const & job   ,
+    batch_result_t const & result
+) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.3f", result.wall_time);
+
+    std::stringstream ss;
+    ss  << "{\"index\": "   << index
+        << ", \"name\": \"" << json_escape(job.name) << "\""
+        << ", \"imem\": \"" << json_escape(job.imem) << "\""
+        << ", \"status\": \"" << batch_status_names[result.status] << "\""
+        << ", \"exit_code\": " << (int)result.status
+        << ", \"program_exit\": " << result.program_exit
+        << ", \"cycles\": " << result.cycles
+        << ", \"cycles_bound\": " << result.cycles_bound
+        << ", \"roi_cycles\": " << result.roi_cycles
+        << ", \"roi_instrs\": " << result.roi_instrs
+        << ", \"wall_time\": " << buf
+        << "}";
+    return ss.str();
+}
+
+//! A job which runs as job does, with no outputs or checks.
+batch_job_t batch_job_inputs(batch_job_t const & job) {
+
+    batch_job_t in;
+
+    in.imem             = job.imem;
+    in.pass_address     = job.pass_address;
+    in.fail_address     = job.fail_address;
+    in.timeout          = job.timeout;
+    in.waves_depth      = job.waves_depth;
+    in.waves_scope      = job.waves_scope;
+    in.waves_start      = job.waves_start;
+    in.waves_stop       = job.waves_stop;
+    in.roi              = job.roi;
+    in.ct_input_addr    = job.ct_input_addr;
+    in.ct_input         = job.ct_input;
+    in.max_stall_imem   = job.max_stall_imem;
+    in.max_stall_dmem   = job.max_stall_dmem;
+    in.restore          = job.restore;
+    in.ff_to_pc         = job.ff_to_pc;
+    in.ff_pc            = job.ff_pc;
+    in.ff_instrs        = job.ff_instrs;
+    in.hang_limit       = job.hang_limit;
+    in.syscall_dir      = job.syscall_dir;
+    in.wfi_skip         = job.wfi_skip;
+    in.irq_schedule     = job.irq_schedule;
+    in.irq_random       = job.irq_random;
+    in.irq_lines        = job.irq_lines;
+    in.irq_seed         = job.irq_seed;
+
+    return in;
+
+}
+
+bool batch_parse_list (
+    std::string                path    ,
+    batch_job_t const        & defaults,
+    std::vector<batch_job_t> & jobs
+) {
+    std::ifstream fh(path);
+
+    if(!fh.is_open()) {
+        std::cerr << "Could not open batch list: " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int         lineno = 0;
+
+    while(std::getline(fh, line)) {
+
+        lineno ++;
+
+        std::stringstream ss(line);
+        std::string       tok;
+        batch_job_t       job = defaults;
+        bool              any = false;
+
+        while(ss >> tok) {
+
+            if(tok[0] == '#') {
+                break;
+            }
+
+            any = true;
+
+            size_t      eq  = tok.find('=');
+
+            if(eq == std::string::npos) {
+                job.imem = tok;
+                continue;
+            }
+
+            std::string key = tok.substr(0, eq);
+            std::string val = tok.substr(eq+1);
+
+            try {
+                if     (key == "name"          ) job.name = val;
+                else if(key == "imem"          ) job.imem = val;
+                else if(key == "pass"          ) job.pass_address = std::stoul(val,NULL,0);
+                else if(key == "fail"          ) job.fail_address = std::stoul(val,NULL,0);
+                else if(key == "timeout"       ) job.timeout      = std::stoul(val,NULL,0);
+                else if(key == "sig_start"     ) job.sig_start    = std::stoul(val,NULL,0);
+                else if(key == "sig_end"       ) job.sig_end      = std::stoul(val,NULL,0);
+                else if(key == "sig_path"      ) job.sig_path     = val;
+                else if(key == "sig_verif"     ) job.sig_verif    = val;
+                else if(key == "waves"         ) job.waves        = val;
+                else if(key == "waves_depth"   ) job.waves_depth  = std::stoi(val);
+                else if(key == "waves_scope"   ) job.waves_scope  = val;
+                else if(key == "waves_last"    ) job.waves_last   = std::stoull(val,NULL,0);
+                else if(key == "roi"           ) job.roi          = std::stoul(val) != 0;
+                else if(key == "pipe_trace"    ) job.pipe_trace   = val;
+                else if(key == "instr_mix"     ) job.instr_mix    = std::stoul(val) != 0;
+                else if(key == "instr_mix_json") job.instr_mix_json = val;
+                else if(key == "instr_log"     ) job.instr_log    = val;
+                else if(key == "dmem_profile"  ) job.dmem_profile = std::stoul(val) != 0;
+                else if(key == "dmem_profile_json") job.dmem_profile_json = val;
+                else if(key == "dmem_profile_elf" ) job.dmem_profile_elf  = val;
+                else if(key == "mem_stats"     ) job.mem_stats    = std::stoul(val) != 0;
+                else if(key == "mem_stats_json") job.mem_stats_json = val;
+                else if(key == "toggle"        ) job.toggle       = val;
+                else if(key == "ct_trace"      ) job.ct_trace     = val;
+                else if(key == "ct_input"      ) {
+                    if(!ct_input_parse(val, job.ct_input_addr,
+                                       job.ct_input)) {
+                        throw std::invalid_argument(val);
+                    }
+                }
+                else if(key == "dmem_profile_window") {
+                    job.dmem_profile_window = std::stoull(val,NULL,0);
+                    if(job.dmem_profile_window == 0) {
+                        throw std::invalid_argument(val);
+                    }
+                }
+                else if(key == "dmem_profile_line") {
+                    job.dmem_profile_line = std::stoul(val,NULL,0);
+                    if(!dmem_profile_line_ok(job.dmem_profile_line)) {
+                        throw std::invalid_argument(val);
+                    }
+                }
+                else if(key == "pipe_trace_json") job.pipe_trace_json = val;
+                else if(key == "pipe_trace_window") {
+                    if(!pipe_trace_window_parse(val, job.pipe_trace_start,
+                                                job.pipe_trace_end)) {
+                        throw std::invalid_argument(val);
+                    }
+                }
+                else if(key == "waves_start" || key == "waves_stop") {
+                    if(!dut_wave_trigger_parse(val, key == "waves_start" ?
+                                               job.waves_start :
+                                               job.waves_stop)) {
+                        throw std::invalid_argument(val);
+                    }
+                }
+                else if(key == "log"           ) job.log          = val;
+                else if(key == "imem_max_stall") job.max_stall_imem=std::stoul(val);
+                else if(key == "dmem_max_stall") job.max_stall_dmem=std::stoul(val);
+                else if(key == "restore"       ) job.restore      = val;
+                else if(key == "ff_instrs"     ) job.ff_instrs    = std::stoull(val,NULL,0);
+                else if(key == "sample"        ) job.sample_interval = std::stoull(val,NULL,0);
+                else if(key == "sample_report" ) job.sample_report= val;
+                else if(key == "cosim"         ) job.cosim        = std::stoul(val) != 0;
+                else if(key == "hang_limit"    ) job.hang_limit   = std::stoul(val,NULL,0);
+                else if(key == "syscall_dir"   ) job.syscall_dir  = val;
+                else if(key == "wfi_skip"      ) job.wfi_skip     = std::stoul(val) != 0;
+                else if(key == "irq_schedule"  ) job.irq_schedule = val;
+                else if(key == "irq_random"    ) job.irq_random   = std::stoull(val,NULL,0);
+                else if(key == "irq_seed"      ) job.irq_seed     = std::stoull(val,NULL,0);
+                else if(key == "irq_lines"     ) job.irq_lines    = irq_lines_from_names(val);
+                else if(key == "ff_pc"         ) {
+                    job.ff_pc     = std::stoul(val,NULL,0);
+                    job.ff_to_pc  = true;
+                }
+                else if(key == "save"          ) {
+                    size_t colon  = val.find(':');
+                    job.save_at   = std::stoul(val.substr(0,colon),NULL,0);
+                    job.save_path = colon == std::string::npos ? "" :
+                                                      val.substr(colon+1);
+                }
+                else {
+                    std::cerr << path << ":" << lineno
+                              << ": unknown key '" << key << "'" << std::endl;
+                    return false;
+                }
+            } catch(std::exception const & e) {
+                std::cerr << path << ":" << lineno
+                          << ": bad value for '" << key << "'" << std::endl;
+                return false;
+            }
+        }
+
+        if(!any) {
+            continue;
+        }
+
+        if(job.imem == "" && job.restore == "") {
+            std::cerr << path << ":" << lineno << ": no imem or restore given."
+                      << std::endl;
+            return false;
+        }
+
+        if(job.name == "") {
+            std::string & from = job.imem != "" ? job.imem : job.restore;
+            size_t slash = from.find_last_of('/');
+            job.name = slash == std::string::npos ? from :
+                                                    from.substr(slash+1);
+        }
+
+        jobs.push_back(job);
+    }
+
+    return true;
+}
+
+/*!
+@brief Body of a single worker process.
+@details Repeatedly takes the next job index from the shared queue and
+    runs it, writing one result line to the pipe per job. Lines are
+    shorter than PIPE_BUF, so writes from different workers never
+    interleave. Each worker builds one testbench and resets it between
+    jobs, rather than building a new model per test.
+*/
+static void batch_worker (
+    std::vector<batch_job_t> & jobs   ,
+    std::vector<size_t>      & order  ,
+    std::atomic<size_t>      * next   ,
+    int                        rsp_fd
+) {
+    int devnull = open("/dev/null", O_WRONLY);
+
+    testbench tb ("", false);
+
+    while(true) {
+
+        size_t n = next -> fetch_add(1);
+
+        if(n >= order.size()) {
+            break;
+        }
+
+        size_t           idx    = order[n];
+        batch_job_t    & job    = jobs[idx];
+        batch_result_t   result ;
+
+        // Send anything the test prints to its log, or nowhere.
+        std::cout.flush();
+        fflush(stdout);
+
+        int out_fd = devnull;
+        if(job.log != "") {
+            out_fd = open(job.log.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644);
+            if(out_fd < 0) {
+                out_fd = devnull;
+            }
+        }
+        dup2(out_fd, STDOUT_FILENO);
+
+        run_job(job, result, &tb);
+
+        std::cout.flush();
+        fflush(stdout);
+
+        if(out_fd != devnull) {
+            close(out_fd);
+        }
+
+        std::string line = std::to_string(idx) + " " +
+                           std::to_string((int)result.status) + " " +
+                           batch_format_result(idx, job, result) + "\n";
+
+        if(write(rsp_fd, line.c_str(), line.size()) < 0) {
+            break;
+        }
+    }
+
+    close(devnull);
+}
+
+int batch_run (
+    std::vector<batch_job_t> & jobs         ,
+    std::string                results_path ,
+    unsigned int               num_workers  ,
+    bool                       quiet
+) {
+    if(num_workers == 0) {
+        long ncpu   = sysconf(_SC_NPROCESSORS_ONLN);
+        num_workers = ncpu > 0 ? ncpu : 1;
+    }
+    num_workers = std::min<size_t>(num_workers, std::max<size_t>(jobs.size(),1));
+
+    // Longest (by timeout) first, so the slowest tests start straight away
+    // and the short ones fill in around them.
+    std::vector<size_t> order(jobs.size());
+    for(size_t i = 0; i < order.size(); i ++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(),
+        [&jobs](size_t a, size_t b) {return jobs[a].timeout > jobs[b].timeout;}
+    );
+
+    // Shared job queue head. Lives in memory shared by all workers.
+    void * shm = mmap(NULL, sizeof(std::atomic<size_t>),
+        PROT_READ|PROT_WRITE, MAP_SHARED|MAP_ANONYMOUS, -1, 0);
+
+    if(shm == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+
+    std::atomic<size_t> * next = new (shm) std::atomic<size_t>(0);
+
+    int rsp_pipe[2];
+    if(pipe(rsp_pipe) != 0) {
+        perror("pipe");
+        return 1;
+    }
+
+    FILE * results = fopen(results_path.c_str(), "w");
+    if(results == NULL) {
+        std::cerr << "Could not open batch results file: " << results_path
+                  << std::endl;
+        return 1;
+    }
+
+    if(!quiet) {
+        std::cout << ">> Running " << jobs.size() << " tests on "
+                  << num_workers << " workers." << std::endl;
+    }
+
+    std::cout.flush();
+    fflush(stdout);
+
+    std::vector<pid_t> workers;
+
+    auto spawn_worker = [&]() {
+        pid_t pid = fork();
+        if(pid == 0) {
+            close(rsp_pipe[0]);
+            batch_worker(jobs, order, next, rsp_pipe[1]);
+            close(rsp_pipe[1]);
+            _exit(0);
+        } else if(pid > 0) {
+            workers.push_back(pid);
+        } else {
+            perror("fork");
+        }
+    };
+
+    for(unsigned int i = 0; i < num_workers; i ++) {
+        spawn_worker();
+    }
+
+    std::vector<bool> done(jobs.size(), false);
+    size_t            num_done   = 0;
+    size_t            num_passed = 0;
+
+    // Handle one "<index> <status> <json record>" line from a worker.
+    auto take_result = [&](std::string const & line) {
+        char const * rec    = line.c_str();
+        char       * tail   = NULL;
+        size_t       idx    = std::strtoul(rec, &tail, 10);
+        int          status = std::strtol (tail, &tail, 10);
+        if(idx >= jobs.size() || status < BATCH_PASS ||
+           status > BATCH_HANG || *tail != ' ' || done[idx]) {
+            return;
+        }
+        done[idx] = true;
+        num_done ++;
+        if(status == BATCH_PASS) {
+            num_passed ++;
+        }
+        fputs(tail + 1, results);
+        fputs("\n", results);
+        fflush(results);
+        if(!quiet) {
+            std::cout << ">> [" << std::dec << num_done << "/"
+                      << jobs.size() << "] "
+                      << jobs[idx].name << ": "
+                      << batch_status_names[status] << std::endl;
+        }
+    };
+
+    std::string pending;
+
+    // Read what the workers have written, waiting up to timeout_ms for
+    // it. Returns false at end of file.
+    auto read_results = [&](int timeout_ms) {
+        struct pollfd pfd = {rsp_pipe[0], POLLIN, 0};
+        if(poll(&pfd, 1, timeout_ms) <= 0) {
+            return true;
+        }
+        char    buf[4096];
+        ssize_t n = read(rsp_pipe[0], buf, sizeof(buf));
+        if(n <= 0) {
+            return n < 0 && errno == EINTR;
+        }
+        pending.append(buf, n);
+        size_t nl;
+        while((nl = pending.find('\n')) != std::string::npos) {
+            take_result(pending.substr(0, nl));
+            pending.erase(0, nl + 1);
+        }
+        return true;
+    };
+
+    // Collect results until every worker has exited. A worker which dies
+    // part way through a job (e.g. a model crash) is replaced as soon as
+    // it is reaped, so the rest of the queue still runs on every slot.
+    while(workers.size() > 0) {
+
+        read_results(100);
+
+        int   wstatus;
+        pid_t pid;
+
+        while((pid = waitpid(-1, &wstatus, WNOHANG)) > 0) {
+            workers.erase(std::remove(workers.begin(), workers.end(), pid),
+                          workers.end());
+            if((!WIFEXITED(wstatus) || WEXITSTATUS(wstatus) != 0) &&
+               next -> load() < order.size()) {
+                spawn_worker();
+            }
+        }
+    }
+
+    // Every worker has gone: read what is left, up to end of file.
+    close(rsp_pipe[1]);
+    while(read_results(-1)) {}
+    close(rsp_pipe[0]);
+
+    // Anything not reported was lost with a crashed worker.
+    for(size_t i = 0; i < jobs.size(); i ++) {
+        if(!done[i]) {
+            batch_result_t result;
+            fputs((batch_format_result(i, jobs[i], result)+"\n").c_str(),
+                  results);
+        }
+    }
+
+    fclose(results);
+    munmap(shm, sizeof(std::atomic<size_t>));
+
+    if(!quiet) {
+        std::cout << ">> " << num_passed << "/" << jobs.size()
+                  << " tests passed." << std::endl;
+    }
+
+    return num_passed == jobs.size() ? 0 : 1;
+}
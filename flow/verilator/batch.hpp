@@ -0,0 +1,168 @@
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "irq_agent.hpp"
+#include "dut_wrapper.hpp"
+
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+//! Outcome of a single test. Values match the single-test exit codes.
+typedef enum batch_status {
+    BATCH_PASS      = 0,
+    BATCH_TIMEOUT   = 1,
+    BATCH_FAIL      = 2,
+    BATCH_SIG_FAIL  = 3,
+    BATCH_ERROR     = 4,    //!< Could not run, or the worker crashed.
+    BATCH_COSIM_FAIL= 5,    //!< The RTL did not match the ISS.
+    BATCH_HANG      = 6     //!< Stopped early in a self loop.
+} batch_status_t;
+
+//! Everything needed to run one test image.
+typedef struct batch_job {
+    std::string name           = "";    //!< Name used in the results.
+    std::string imem           = "";    //!< SREC image to load.
+    uint32_t    pass_address   = 0;
+    uint32_t    fail_address   = -1;
+    uint64_t    timeout        = 1000;  //!< Timeout, in clock cycles.
+    uint32_t    sig_start      = 0;     //!< Base address of test signature.
+    uint32_t    sig_end        = 0;     //!< End address of test signature.
+    std::string sig_path       = "";    //!< If set, dump signature here.
+    std::string sig_verif      = "";    //!< If set, check signature.
+    std::string waves          = "";    //!< If set, dump waves here.
+    int         waves_depth    = 99;    //!< Hierarchy levels to dump.
+    std::string waves_scope    = "";    //!< If set, only dump these.
+    dut_wave_trigger_t waves_start;     //!< See dut_wrapper::waves_start.
+    dut_wave_trigger_t waves_stop;
+    uint64_t    waves_last     = 0;     //!< See testbench::flight_period.
+    bool        roi            = false; //!< See dut_wrapper::roi_enable.
+    std::string pipe_trace     = "";    //!< If set, trace the pipeline to
+    std::string pipe_trace_json= "";    //!< here (Konata), and / or here.
+    uint64_t    pipe_trace_start = 0;   //!< See pipe_trace::window_start.
+    uint64_t    pipe_trace_end = UINT64_MAX;
+    bool        instr_mix      = false; //!< Report the instruction mix,
+    std::string instr_mix_json = "";    //!< and / or write it here.
+    std::string instr_log      = "";    //!< If set, disassemble to here.
+    bool        dmem_profile   = false; //!< Report the dmem profile,
+    std::string dmem_profile_json = ""; //!< and / or write it here.
+    uint32_t    dmem_profile_line = 64; //!< See dmem_profile::line_size.
+    uint64_t    dmem_profile_window = 10000;
+    std::string dmem_profile_elf = "";  //!< Symbols for data objects.
+    bool        mem_stats      = false; //!< Report memory port traffic,
+    std::string mem_stats_json = "";    //!< and / or write it here.
+    std::string toggle         = "";    //!< See dut_wrapper::toggle_path.
+    std::string ct_trace       = "";    //!< If set, trace timing to here.
+    uint32_t    ct_input_addr  = 0;     //!< Write ct_input here before
+    std::vector<uint8_t> ct_input;      //!< the run, e.g. a secret key.
+    std::string log            = "";    //!< If set, write stdout here.
+    uint32_t    max_stall_imem = 5;
+    uint32_t    max_stall_dmem = 5;
+    std::string save_path      = "";    //!< If set, checkpoint to here...
+    uint64_t    save_at        = 0;     //!< ...at this clock cycle.
+    std::string restore        = "";    //!< If set, start from checkpoint.
+    bool        ff_to_pc       = false; //!< Fast-forward on the ISS to...
+    uint32_t    ff_pc          = 0;     //!< ...this address, and / or...
+    uint64_t    ff_instrs      = 0;     //!< ...this many instructions.
+    uint64_t    sample_interval= 0;     //!< If set, run sampled. See
+    uint64_t    sample_warmup  = 2000;  //!< sampling.hpp.
+    unsigned    sample_phases  = 10;
+    unsigned    sample_per_phase=2;
+    std::string sample_report  = "";    //!< If set, write JSON report here.
+    bool        cosim          = false; //!< Check the RTL against the ISS.
+    uint32_t    hang_limit     = 1000;  //!< See testbench::hang_limit.
+    std::string syscall_dir    = "";    //!< Files the program may open.
+    bool        wfi_skip       = false; //!< See testbench::wfi_skip.
+    std::string irq_schedule   = "";    //!< If set, raise interrupts from
+    uint64_t    irq_random     = 0;     //!< here, else if set at random.
+    uint32_t    irq_lines      = 1 << IRQ_EXTERNAL; //!< Random ones on.
+    uint64_t    irq_seed       = 1;     //!< See irq_agent::set_random.
+} batch_job_t;
+
+/*!
+@brief A job which runs the same program, from the same state and with
+    the same stimulus, as job, but with nothing else: every output (waves,
+    traces, reports, logs, checkpoints) and check (signature, cosim) is
+    left off, as are sampling and the name.
+@details Used to re-run a job for one output only. Any field added to
+    batch_job_t is left off unless it is copied here.
+*/
+batch_job_t batch_job_inputs(batch_job_t const & job);
+
+//! Escape a string for use inside a JSON string literal.
+std::string json_escape(std::string const & s);
+
+//! The result of running one test.
+typedef struct batch_result {
+    batch_status_t status      = BATCH_ERROR;
+    uint64_t       cycles      = 0;     //!< Simulated clock cycles.
+    uint64_t       cycles_bound= 0;     //!< 95% bound on sampled cycles.
+    double         wall_time   = 0;     //!< Host seconds taken.
+    int64_t        program_exit= -1;    //!< Program exit code, if any.
+    uint64_t       roi_cycles  = 0;     //!< Cycles in the region of
+    uint64_t       roi_instrs  = 0;     //!< interest, and instructions.
+} batch_result_t;
+
+class testbench;
+
+/*!
+@brief Run a single test to completion in this process.
+@details Defined in main.cpp, so the single test and batch modes behave
+         identically.
+@param in reuse - If not NULL, reset_and_load() this testbench and run
+         on it rather than building a new one. Ignored for tests which
+         dump waves.
+*/
+batch_status_t run_job (
+    batch_job_t    & job    ,
+    batch_result_t & result ,
+    testbench      * reuse  = NULL
+);
+
+/*!
+@brief Parse a batch list file.
+@details One test per line. Blank lines and lines starting with '#' are
+    ignored. Each line is a whitespace separated list of key=value pairs:
+    name, imem, pass, fail, timeout, sig_start, sig_end, sig_path,
+    sig_verif, waves, log, imem_max_stall, dmem_max_stall, restore,
+    save=<cycle>:<file>, ff_pc, ff_instrs, sample, sample_report,
+    cosim (0 or 1), hang_limit, syscall_dir, wfi_skip (0 or 1),
+    irq_schedule, irq_random, irq_lines (e.g. external,software),
+    irq_seed, waves_depth, waves_scope, waves_start and waves_stop (e.g.
+    pc:0x80000100, see dut_wave_trigger_parse), waves_last, roi (0 or
+    1), pipe_trace, pipe_trace_json, pipe_trace_window (e.g.
+    10000:20000), instr_mix (0 or 1), instr_mix_json, instr_log,
+    dmem_profile (0 or 1), dmem_profile_json, dmem_profile_line,
+    dmem_profile_window, dmem_profile_elf, mem_stats (0 or 1),
+    mem_stats_json, toggle, ct_trace and ct_input (e.g.
+    0x80001000:00ff10, see ct_input_parse).
+    A token without an '=' is taken as the imem path. Keys which are not
+    given take their value from defaults.
+@returns false if the file cannot be read or contains a bad line.
+*/
+bool batch_parse_list (
+    std::string                path    ,
+    batch_job_t const        & defaults,
+    std::vector<batch_job_t> & jobs
+);
+
+/*!
+@brief Run a list of jobs across a pool of worker processes.
+@details Each worker is a forked copy of this process with its own model
+    instance, which is reset and re-used for every job it runs. Workers
+    take the next job from a shared queue as soon as they finish their
+    last one, longest timeout first, so the whole batch takes about as
+    long as the slowest test. One JSON record per test is appended to
+    results_path as each test finishes.
+@param in num_workers - Number of worker processes. 0 = one per CPU.
+@returns 0 if every test passed, 1 otherwise.
+*/
+int batch_run (
+    std::vector<batch_job_t> & jobs         ,
+    std::string                results_path ,
+    unsigned int               num_workers  ,
+    bool                       quiet
+);
+
+#endif
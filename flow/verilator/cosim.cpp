@@ -0,0 +1,407 @@
+
+#include <cstdio>
+#include <sstream>
+
+#include "cosim.hpp"
+#include "instr_disasm.hpp"
+
+#define BIT(x,n)    (((x) >> (n)) & 0x1)
+
+//! Start checking from the architectural state of start.
+cosim::cosim (
+    iss               const & start,
+    memory_device_ram const & ram
+) {
+
+    this -> ref_ram = new memory_device_ram(ram);
+    this -> ref_bus = new memory_bus();
+    this -> ref_bus -> add_device(this -> ref_ram);
+
+    this -> ref     = new iss(this -> ref_bus);
+    this -> ref -> reset(start.pc);
+    this -> ref -> copy_state(start);
+    this -> ref -> rng_responses = true;
+
+    this -> queue.resize(COSIM_QUEUE_DEPTH);
+
+    this -> queue_head  = 0;
+    this -> queue_tail  = 0;
+    this -> stopping    = false;
+    this -> mismatch    = false;
+    this -> num_checked = 0;
+
+    this -> worker = std::thread(&cosim::run, this);
+
+}
+
+
+//! Stop the checker thread.
+cosim::~cosim() {
+
+    this -> finish();
+
+    delete this -> ref;
+    delete this -> ref_bus;
+    delete this -> ref_ram;
+
+}
+
+
+//! Queue a packet for checking.
+void cosim::push(cosim_pkt_t const & pkt) {
+
+    uint64_t tail = this -> queue_tail.load(std::memory_order_relaxed);
+
+    while(tail - this -> queue_head.load(std::memory_order_acquire) >=
+          COSIM_QUEUE_DEPTH) {
+        if(this -> failed()) {
+            // The checker has stopped, so the queue will never drain.
+            return;
+        }
+        std::this_thread::yield();
+    }
+
+    if(this -> failed()) {
+        return;
+    }
+
+    this -> queue[tail % COSIM_QUEUE_DEPTH] = pkt;
+
+    this -> queue_tail.store(tail + 1, std::memory_order_release);
+
+}
+
+
+//! Queue a write of program memory by the testbench.
+void cosim::host_write(uint32_t addr, uint8_t data) {
+
+    cosim_pkt_t pkt = {};
+
+    pkt.host      = 1;
+    pkt.mem_addr  = addr & ~0x3u;
+    pkt.mem_wmask = 1 << (addr & 0x3);
+    pkt.mem_wdata = (uint32_t)data << (8*(addr & 0x3));
+
+    this -> push(pkt);
+
+}
+
+
+//! Wait for every queued packet to be checked.
+bool cosim::finish() {
+
+    this -> stopping.store(true, std::memory_order_release);
+
+    if(this -> worker.joinable()) {
+        this -> worker.join();
+    }
+
+    return !this -> failed();
+
+}
+
+
+//! Body of the checker thread.
+void cosim::run() {
+
+    while(true) {
+
+        uint64_t head = this -> queue_head.load(std::memory_order_relaxed);
+
+        if(head == this -> queue_tail.load(std::memory_order_acquire)) {
+
+            // Everything pushed before stopping was set is visible once
+            // it is, so the queue must be re-checked before leaving.
+            if(this -> stopping.load(std::memory_order_acquire) &&
+               head == this -> queue_tail.load(std::memory_order_acquire)) {
+                return;
+            }
+
+            std::this_thread::yield();
+            continue;
+        }
+
+        cosim_pkt_t const & pkt = this -> queue[head % COSIM_QUEUE_DEPTH];
+
+        if(pkt.host) {
+            for(int i = 0; i < 4; i ++) {
+                if(BIT(pkt.mem_wmask, i)) {
+                    this -> ref_bus -> write_byte(pkt.mem_addr + i,
+                                                  pkt.mem_wdata >> (8*i));
+                }
+            }
+            this -> queue_head.store(head + 1, std::memory_order_release);
+            continue;
+        }
+
+        if(this -> history.size() >= COSIM_HISTORY) {
+            this -> history.erase(this -> history.begin());
+        }
+        this -> history.push_back(pkt);
+
+        bool ok = this -> check(pkt);
+
+        this -> num_checked.fetch_add(1, std::memory_order_relaxed);
+        this -> queue_head.store(head + 1, std::memory_order_release);
+
+        if(!ok) {
+            return;
+        }
+    }
+
+}
+
+
+//! Apply the GPR writes reported by a packet to regs.
+static void cosim_apply_rd(uint32_t * regs, cosim_pkt_t const & pkt) {
+
+    if(pkt.rd_wide) {
+        // Wide writes always write the odd register of the pair, and the
+        // even one only if it is the destination.
+        if(!BIT(pkt.rd_addr, 0)) {
+            regs[pkt.rd_addr] = pkt.rd_wdata;
+        }
+        regs[pkt.rd_addr | 1] = pkt.rd_wdatahi;
+    } else if(pkt.rd_addr != 0) {
+        regs[pkt.rd_addr] = pkt.rd_wdata;
+    }
+
+    regs[0] = 0;
+
+}
+
+
+//! Check one packet, updating the reference model.
+bool cosim::check(cosim_pkt_t const & pkt) {
+
+    if(pkt.intr) {
+        // The RTL took an interrupt before this instruction, which is the
+        // first of the handler.
+        this -> enter_trap(this -> ref -> pc, pkt.pc_rdata);
+    }
+
+    if(pkt.pc_rdata != this -> ref -> pc) {
+        return this -> fail(pkt, "pc", pkt.pc_rdata, this -> ref -> pc);
+    }
+
+    if(pkt.trap) {
+        this -> enter_trap(pkt.pc_rdata, pkt.pc_wdata);
+        return true;
+    }
+
+    // Accesses to mcause and mtval after a trap: the ISS does not know
+    // the cause, so take the old value from what the RTL read.
+    uint32_t insn = pkt.insn;
+
+    if((insn & 0x7F) == 0x73 && ((insn >> 12) & 0x3) != 0) {
+
+        uint32_t csr   = insn >> 20;
+        uint32_t rd    = (insn >> 7) & 0x1F;
+        bool     wr    = ((insn >> 12) & 0x3) == 1;
+        bool   * unknown = csr == 0x342 ? &this -> mcause_unknown :
+                           csr == 0x343 ? &this -> mtval_unknown  : NULL;
+
+        if(unknown && *unknown && (rd != 0 || wr)) {
+            if(rd != 0) {
+                uint32_t & reg = csr == 0x342 ? this -> ref -> csr_mcause :
+                                                this -> ref -> csr_mtval  ;
+                reg = pkt.rd_wdata;
+            }
+            *unknown = false;
+        }
+    }
+
+    uint32_t expect[32];
+
+    for(int i = 0; i < 32; i ++) {
+        expect[i] = this -> ref -> x[i];
+    }
+
+    cosim_apply_rd(expect, pkt);
+
+    this -> ref -> rng_data = pkt.rng_data;
+    this -> ref -> rng_stat = pkt.rng_stat;
+
+    if(!this -> ref -> step()) {
+        this -> adopt(pkt);
+        return true;
+    }
+
+    for(int i = 1; i < 32; i ++) {
+        if(this -> ref -> x[i] != expect[i]) {
+            return this -> fail(pkt, "x" + std::to_string(i),
+                                expect[i], this -> ref -> x[i]);
+        }
+    }
+
+    // Data memory effects, in the lane positioned form of the RVFI.
+    uint8_t  ref_rmask = 0;
+    uint8_t  ref_wmask = 0;
+    uint32_t ref_word  = 0;
+    uint32_t ref_data  = 0;
+
+    if(this -> ref -> mem_size != 0) {
+        uint32_t lane  = this -> ref -> mem_addr & 0x3;
+        uint8_t  mask  = ((1 << this -> ref -> mem_size) - 1) << lane;
+        ref_word = this -> ref -> mem_addr & ~0x3u;
+        ref_data = this -> ref -> mem_data << (8*lane);
+        if(this -> ref -> mem_store) {
+            ref_wmask = mask;
+        } else {
+            ref_rmask = mask;
+        }
+    }
+
+    if(pkt.mem_rmask != ref_rmask) {
+        return this -> fail(pkt, "mem_rmask", pkt.mem_rmask, ref_rmask);
+    }
+
+    if(pkt.mem_wmask != ref_wmask) {
+        return this -> fail(pkt, "mem_wmask", pkt.mem_wmask, ref_wmask);
+    }
+
+    if(ref_rmask | ref_wmask) {
+
+        uint32_t bytes = 0;
+
+        for(int i = 0; i < 4; i ++) {
+            if(BIT(ref_rmask | ref_wmask, i)) {
+                bytes |= 0xFF << (8*i);
+            }
+        }
+
+        uint32_t rtl_data = ref_wmask ? pkt.mem_wdata : pkt.mem_rdata;
+
+        if(pkt.mem_addr != ref_word) {
+            return this -> fail(pkt, "mem_addr", pkt.mem_addr, ref_word);
+        }
+
+        if((rtl_data & bytes) != (ref_data & bytes)) {
+            return this -> fail(pkt, ref_wmask ? "mem_wdata" : "mem_rdata",
+                                rtl_data & bytes, ref_data & bytes);
+        }
+    }
+
+    if(pkt.pc_wdata != this -> ref -> pc) {
+        return this -> fail(pkt, "pc_wdata", pkt.pc_wdata, this -> ref -> pc);
+    }
+
+    return true;
+
+}
+
+
+//! Trap entry, as the core does it.
+void cosim::enter_trap(uint32_t epc, uint32_t target) {
+
+    uint32_t mie = BIT(this -> ref -> csr_mstatus, 3);
+
+    this -> ref -> csr_mepc    = epc;
+    this -> ref -> csr_mstatus = (this -> ref -> csr_mstatus & ~0x88u) |
+                                 mie << 7;
+    this -> ref -> pc          = target;
+
+    this -> mcause_unknown     = true;
+    this -> mtval_unknown      = true;
+
+}
+
+
+//! Copy the effects of an instruction the ISS does not model.
+void cosim::adopt(cosim_pkt_t const & pkt) {
+
+    cosim_apply_rd(this -> ref -> x, pkt);
+
+    // Writes outside the RAM (e.g. the UART or the core's MMIO) have no
+    // effect on the reference model.
+    for(int i = 0; i < 4; i ++) {
+        if(BIT(pkt.mem_wmask, i)) {
+            this -> ref_bus -> write_byte(pkt.mem_addr + i,
+                                          pkt.mem_wdata >> (8*i));
+        }
+    }
+
+    this -> ref -> pc = pkt.pc_wdata;
+    this -> ref -> instret ++;
+
+}
+
+
+//! Format one packet as a line of the mismatch report.
+static std::string cosim_format_pkt(cosim_pkt_t const & pkt) {
+
+    char line[224];
+
+    int n = snprintf(line, sizeof(line), "%8lu %08x %08x",
+                     (unsigned long)pkt.order, pkt.pc_rdata, pkt.insn);
+
+    if(pkt.trap) {
+        n += snprintf(line + n, sizeof(line) - n, " trap");
+    }
+    if(pkt.intr) {
+        n += snprintf(line + n, sizeof(line) - n, " intr");
+    }
+    if(pkt.rd_addr != 0 || pkt.rd_wide) {
+        n += snprintf(line + n, sizeof(line) - n, " x%u=%08x",
+                      pkt.rd_addr, pkt.rd_wdata);
+    }
+    if(pkt.rd_wide) {
+        n += snprintf(line + n, sizeof(line) - n, " x%u=%08x",
+                      pkt.rd_addr | 1, pkt.rd_wdatahi);
+    }
+    if(pkt.mem_rmask) {
+        n += snprintf(line + n, sizeof(line) - n, " load [%08x/%x]=%08x",
+                      pkt.mem_addr, pkt.mem_rmask, pkt.mem_rdata);
+    }
+    if(pkt.mem_wmask) {
+        n += snprintf(line + n, sizeof(line) - n, " store [%08x/%x]=%08x",
+                      pkt.mem_addr, pkt.mem_wmask, pkt.mem_wdata);
+    }
+
+    snprintf(line + n, sizeof(line) - n, " -> %08x  # %s", pkt.pc_wdata,
+             instr_disasm(pkt.insn, pkt.pc_rdata).c_str());
+
+    return line;
+
+}
+
+
+//! Record a mismatch and build the report.
+bool cosim::fail(
+    cosim_pkt_t const & pkt ,
+    std::string const & what,
+    uint32_t            rtl ,
+    uint32_t            ref
+) {
+
+    char values[64];
+
+    snprintf(values, sizeof(values), "RTL %08x, ISS %08x", rtl, ref);
+
+    std::stringstream ss;
+
+    ss << ">> Co-simulation mismatch in " << what << ": " << values
+       << std::endl
+       << ">> Last instructions retired by the RTL (order, pc, insn):"
+       << std::endl;
+
+    for(cosim_pkt_t const & p : this -> history) {
+        ss << ">>   " << cosim_format_pkt(p) << std::endl;
+    }
+
+    ss << ">> ISS registers:" << std::endl;
+
+    for(int i = 0; i < 32; i += 4) {
+        char regs[80];
+        snprintf(regs, sizeof(regs), ">>   x%-2d %08x %08x %08x %08x",
+                 i, this -> ref -> x[i  ], this -> ref -> x[i+1],
+                    this -> ref -> x[i+2], this -> ref -> x[i+3]);
+        ss << regs << std::endl;
+    }
+
+    this -> mismatch_report = ss.str();
+    this -> mismatch.store(true, std::memory_order_release);
+
+    return false;
+
+}
@@ -0,0 +1,183 @@
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "iss.hpp"
+#include "memory_bus.hpp"
+#include "memory_device_ram.hpp"
+
+#ifndef COSIM_HPP
+#define COSIM_HPP
+
+//! Number of retired instructions the checker can fall behind the RTL by.
+#define COSIM_QUEUE_DEPTH 4096
+
+//! Number of retired instructions printed when the checker stops.
+#define COSIM_HISTORY 8
+
+//! One retired instruction, as reported on the RVFI outputs of the core.
+typedef struct cosim_pkt {
+    uint64_t order      ;
+    uint32_t insn       ;
+    uint8_t  trap       ;
+    uint8_t  intr       ;
+    uint8_t  rd_addr    ;
+    uint8_t  rd_wide    ;
+    uint32_t rd_wdata   ;
+    uint32_t rd_wdatahi ;
+    uint32_t pc_rdata   ;
+    uint32_t pc_wdata   ;
+    uint32_t mem_addr   ; //!< Word aligned.
+    uint8_t  mem_rmask  ; //!< Byte lanes read.
+    uint8_t  mem_wmask  ; //!< Byte lanes written.
+    uint32_t mem_rdata  ; //!< Lane positioned.
+    uint32_t mem_wdata  ; //!< Lane positioned.
+    uint32_t rng_data   ; //!< Randomness interface response data.
+    uint8_t  rng_stat   ; //!< Randomness interface response status.
+    uint8_t  host       ; //!< Not an instruction: a write by the host.
+} cosim_pkt_t;
+
+/*!
+@brief Checks every instruction the RTL retires against the functional
+    ISS, in lockstep with the RVFI outputs of the core.
+@details The ISS runs on a thread of its own, fed from a single producer /
+    single consumer queue, so the RTL only pays for copying each RVFI
+    packet. Since the RTL runs ahead of it, the ISS has a private copy of
+    the memory it starts from, and only checks the memory effects the RTL
+    reports rather than reading the testbench memory.
+
+    For each packet, the ISS steps one instruction and the checker
+    compares the program counter, every GPR, the data memory access and
+    the next program counter. The RTL's randomness interface responses
+    are replayed into the ISS from rvfi_rng_data / rvfi_rng_stat.
+
+    Things the ISS does not model are taken from the RTL instead:
+    - instructions it leaves to the RTL (see iss::step()) have their
+      register result, memory writes and next pc copied from the packet;
+    - traps and interrupts update mepc and mstatus as the core does and
+      continue from the pc the RTL went to. mcause and mtval are then
+      unknown until the program next reads or writes them, at which point
+      they are taken from the RTL.
+
+    Checking stops at the first mismatch, and report() describes it along
+    with the last COSIM_HISTORY instructions.
+*/
+class cosim {
+
+public:
+
+    /*!
+    @brief Start checking from the architectural state of start, with a
+        private copy of ram as its memory.
+    */
+    cosim (
+        iss               const & start,
+        memory_device_ram const & ram
+    );
+
+    //! Stop the checker thread, once anything still queued is checked.
+    ~cosim();
+
+    /*!
+    @brief Queue a packet for checking. Called by the simulation thread.
+    @details Waits if the checker is COSIM_QUEUE_DEPTH packets behind.
+        Packets pushed after a mismatch are dropped.
+    */
+    void push(cosim_pkt_t const & pkt);
+
+    /*!
+    @brief Queue a write of program memory by the testbench (e.g. the
+        results of a proxied system call), so the private memory of the
+        reference model sees it in order with the RTL.
+    */
+    void host_write(uint32_t addr, uint8_t data);
+
+    /*!
+    @brief Wait for every queued packet to be checked, then stop the
+        checker thread.
+    @returns true if no mismatch was found.
+    */
+    bool finish();
+
+    //! Has the checker found a mismatch? Safe to poll while running.
+    bool failed() const {
+        return this -> mismatch.load(std::memory_order_acquire);
+    }
+
+    //! Number of instructions checked so far.
+    uint64_t checked() const {
+        return this -> num_checked.load(std::memory_order_relaxed);
+    }
+
+    //! Description of the mismatch. Only valid once failed() is true.
+    std::string const & report() const {
+        return this -> mismatch_report;
+    }
+
+protected:
+
+    //! The reference model.
+    iss                 * ref;
+
+    //! Private memory of the reference model.
+    memory_bus          * ref_bus;
+
+    //! Copy of the RAM image the reference model runs from.
+    memory_device_ram   * ref_ram;
+
+    //! Ring of packets waiting to be checked.
+    std::vector<cosim_pkt_t> queue;
+
+    //! Next slot to check. Written by the checker thread.
+    std::atomic<uint64_t>   queue_head;
+
+    //! Next slot to fill. Written by the simulation thread.
+    std::atomic<uint64_t>   queue_tail;
+
+    //! Set to make the checker thread exit once the queue is empty.
+    std::atomic<bool>       stopping;
+
+    //! Set once a mismatch is found. mismatch_report is written first.
+    std::atomic<bool>       mismatch;
+
+    std::atomic<uint64_t>   num_checked;
+
+    std::string             mismatch_report;
+
+    //! The last COSIM_HISTORY packets checked, oldest first.
+    std::vector<cosim_pkt_t> history;
+
+    //! Set by a trap or interrupt until the program next accesses mcause.
+    bool                    mcause_unknown = false;
+
+    //! Set by a trap or interrupt until the program next accesses mtval.
+    bool                    mtval_unknown  = false;
+
+    std::thread             worker;
+
+    //! Body of the checker thread.
+    void run();
+
+    //! Check one packet, updating the reference model.
+    bool check(cosim_pkt_t const & pkt);
+
+    //! Trap entry, as the core does it, to target.
+    void enter_trap(uint32_t epc, uint32_t target);
+
+    //! Copy the effects of an instruction the ISS does not model.
+    void adopt(cosim_pkt_t const & pkt);
+
+    //! Record a mismatch and build the report.
+    bool fail(
+        cosim_pkt_t const & pkt ,
+        std::string const & what,
+        uint32_t            rtl ,
+        uint32_t            ref
+    );
+
+};
+
+#endif
@@ -0,0 +1,539 @@
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <map>
+
+#include "ct_trace.hpp"
+#include "instr_disasm.hpp"
+
+//! Number of instructions the report lists, most different first.
+#define CT_TRACE_TOP_PCS 20
+
+//! Number of buckets in the report's histogram of cycle counts.
+#define CT_TRACE_BUCKETS 10
+
+
+//! Start a trace.
+ct_trace::ct_trace(uint64_t start_cycle) {
+
+    this -> last_cycle = start_cycle;
+
+}
+
+
+ct_trace::~ct_trace() {
+
+    if(this -> fh) {
+        fclose(this -> fh);
+    }
+
+}
+
+
+//! Open the file to trace to.
+bool ct_trace::open(std::string path) {
+
+    this -> fh = fopen(path.c_str(), "w");
+
+    return this -> fh != NULL;
+
+}
+
+
+//! An instruction retired.
+void ct_trace::retired (
+    uint32_t pc     ,
+    uint32_t instr  ,
+    uint64_t cycle  ,
+    uint8_t  rmask  ,
+    uint8_t  wmask  ,
+    uint32_t addr   ,
+    bool     count
+) {
+
+    uint64_t delta = cycle - this -> last_cycle;
+
+    this -> last_cycle = cycle;
+
+    if(!count || this -> fh == NULL) {
+        return;
+    }
+
+    if(wmask) {
+        fprintf(this -> fh, "%08x %08x %lu w %08x\n", pc, instr,
+                (unsigned long)delta, addr);
+    } else if(rmask) {
+        fprintf(this -> fh, "%08x %08x %lu r %08x\n", pc, instr,
+                (unsigned long)delta, addr);
+    } else {
+        fprintf(this -> fh, "%08x %08x %lu\n", pc, instr,
+                (unsigned long)delta);
+    }
+
+}
+
+
+//! Finish the trace with the run's cycles and status.
+void ct_trace::finish(uint64_t cycles, int status) {
+
+    if(this -> fh == NULL) {
+        return;
+    }
+
+    fprintf(this -> fh, "end %lu %d\n", (unsigned long)cycles, status);
+    fclose(this -> fh);
+
+    this -> fh = NULL;
+
+}
+
+
+//! Parse "<addr>:<hex bytes>".
+bool ct_input_parse (
+    std::string            spec ,
+    uint32_t             & addr ,
+    std::vector<uint8_t> & bytes
+) {
+
+    size_t colon = spec.find(':');
+
+    if(colon == std::string::npos || colon == 0) {
+        return false;
+    }
+
+    char * end;
+    addr = strtoul(spec.c_str(), &end, 0);
+
+    if(end != spec.c_str() + colon) {
+        return false;
+    }
+
+    std::string hex = spec.substr(colon + 1);
+
+    if(hex.empty() || hex.size() % 2) {
+        return false;
+    }
+
+    bytes.clear();
+
+    for(size_t i = 0; i < hex.size(); i += 2) {
+        std::string b = hex.substr(i, 2);
+        if(!isxdigit(b[0]) || !isxdigit(b[1])) {
+            return false;
+        }
+        bytes.push_back(strtoul(b.c_str(), NULL, 16));
+    }
+
+    return true;
+
+}
+
+
+//! What one instruction did across all of the runs compared.
+typedef struct ct_pc {
+    uint32_t    instr       = 0;
+    unsigned    runs        = 0;    //!< Runs which retired it at all.
+    uint64_t    visits_min  = UINT64_MAX;
+    uint64_t    visits_max  = 0;
+    uint64_t    cycles_min  = UINT64_MAX;
+    uint64_t    cycles_max  = 0;
+    unsigned    addr_runs   = 0;    //!< Runs whose addresses differ.
+    size_t      addr_run    = 0;    //!< First of them, ...
+    uint64_t    addr_index  = 0;    //!< ...the access which differs,
+    int64_t     addr_ref    = -1;   //!< and its address in the first run
+    int64_t     addr_diff   = -1;   //!< and in that one. -1 = none.
+} ct_pc_t;
+
+//! What one instruction did in one run.
+typedef struct ct_visit {
+    uint32_t    instr       = 0;
+    uint64_t    visits      = 0;
+    uint64_t    cycles      = 0;
+    uint64_t    accesses    = 0;
+    bool        addr_differ = false;
+    uint64_t    addr_index  = 0;    //!< As ct_pc_t, if addr_differ.
+    int64_t     addr_ref    = -1;
+    int64_t     addr_diff   = -1;
+} ct_visit_t;
+
+
+/*!
+@brief Read one run's trace, compare its addresses with ref's, and add
+    what each instruction did to pcs.
+@details Nothing is added for runs which did not pass.
+@param in first - Is this the first run compared? If so, its addresses
+                  fill ref in.
+@returns false if the trace could not be read or did not pass.
+*/
+static bool ct_read (
+    std::string                                  path   ,
+    size_t                                       run    ,
+    bool                                         first  ,
+    std::map<uint32_t, std::vector<uint32_t>>  & ref    ,
+    std::map<uint32_t, ct_pc_t>                & pcs    ,
+    uint64_t                                   & cycles
+) {
+
+    FILE * fh = fopen(path.c_str(), "r");
+
+    if(fh == NULL) {
+        return false;
+    }
+
+    std::map<uint32_t, ct_visit_t>            visits;
+    std::map<uint32_t, std::vector<uint32_t>> addrs;
+
+    char     line[128];
+    bool     ended  = false;
+    int      status = -1;
+
+    while(fgets(line, sizeof(line), fh)) {
+
+        unsigned long n;
+        uint32_t      pc, instr, addr;
+        char          rw;
+
+        if(sscanf(line, "end %lu %d", &n, &status) == 2) {
+            cycles = n;
+            ended  = true;
+            break;
+        }
+
+        int fields = sscanf(line, "%x %x %lu %c %x", &pc, &instr, &n, &rw,
+                            &addr);
+
+        if(fields < 3) {
+            continue;
+        }
+
+        ct_visit_t & v = visits[pc];
+        v.instr   = instr;
+        v.visits ++;
+        v.cycles += n;
+
+        if(fields < 5) {
+            continue;
+        }
+
+        uint64_t i = v.accesses ++;
+
+        if(first) {
+            addrs[pc].push_back(addr);
+            continue;
+        }
+
+        std::vector<uint32_t> const & r = ref[pc];
+
+        if(!v.addr_differ && (i >= r.size() || r[i] != addr)) {
+            v.addr_differ = true;
+            v.addr_index  = i;
+            v.addr_ref    = i < r.size() ? (int64_t)r[i] : -1;
+            v.addr_diff   = addr;
+        }
+    }
+
+    fclose(fh);
+
+    if(!ended || status != 0) {
+        return false;
+    }
+
+    if(first) {
+        ref = addrs;
+    }
+
+    // Fewer accesses than the first run is a difference too.
+    for(auto const & r : ref) {
+        ct_visit_t & v = visits[r.first];
+        if(!v.addr_differ && v.accesses < r.second.size()) {
+            v.addr_differ = true;
+            v.addr_index  = v.accesses;
+            v.addr_ref    = r.second[v.accesses];
+            v.addr_diff   = -1;
+        }
+    }
+
+    for(auto const & v : visits) {
+
+        ct_pc_t & p = pcs[v.first];
+
+        if(v.second.addr_differ && p.addr_runs ++ == 0) {
+            p.addr_run    = run;
+            p.addr_index  = v.second.addr_index;
+            p.addr_ref    = v.second.addr_ref;
+            p.addr_diff   = v.second.addr_diff;
+        }
+
+        if(v.second.visits == 0) {
+            continue;
+        }
+
+        p.instr       = v.second.instr;
+        p.runs       ++;
+        p.visits_min  = std::min(p.visits_min, v.second.visits);
+        p.visits_max  = std::max(p.visits_max, v.second.visits);
+        p.cycles_min  = std::min(p.cycles_min, v.second.cycles);
+        p.cycles_max  = std::max(p.cycles_max, v.second.cycles);
+    }
+
+    return true;
+
+}
+
+
+//! Compare the traces of runs of one program on different inputs.
+bool ct_analyse (
+    std::vector<std::string> const & paths    ,
+    std::ostream                   & os       ,
+    std::string                      json_path
+) {
+
+    std::map<uint32_t, std::vector<uint32_t>> ref;
+    std::map<uint32_t, ct_pc_t>               pcs;
+    std::vector<uint64_t>                     cycles;
+    size_t                                    ref_run = 0;
+
+    for(size_t i = 0; i < paths.size(); i ++) {
+        uint64_t c;
+        if(ct_read(paths[i], i, cycles.empty(), ref, pcs, c)) {
+            if(cycles.empty()) {
+                ref_run = i;
+            }
+            cycles.push_back(c);
+        }
+    }
+
+    size_t runs = cycles.size();
+
+    if(runs < paths.size()) {
+        os << ">> " << std::dec << paths.size() - runs << " of "
+           << paths.size() << " runs did not pass and are not compared"
+           << std::endl;
+    }
+
+    if(runs < 2) {
+        os << ">> Too few runs passed to compare" << std::endl;
+        return false;
+    }
+
+    // Instructions some runs did not retire at all visited them 0 times.
+    for(auto & p : pcs) {
+        if(p.second.runs < runs) {
+            p.second.visits_min = 0;
+            p.second.cycles_min = 0;
+        }
+    }
+
+    uint64_t lo  = *std::min_element(cycles.begin(), cycles.end());
+    uint64_t hi  = *std::max_element(cycles.begin(), cycles.end());
+    double   sum = 0;
+    double   sq  = 0;
+
+    std::map<uint64_t, size_t> distinct;
+
+    for(uint64_t c : cycles) {
+        sum += c;
+        distinct[c] ++;
+    }
+
+    double mean = sum / runs;
+
+    for(uint64_t c : cycles) {
+        sq += (c - mean) * (c - mean);
+    }
+
+    double stddev = std::sqrt(sq / (runs - 1));
+
+    os << ">> Cycles over " << runs << " runs: " << lo << " to " << hi
+       << ", mean " << std::fixed << std::setprecision(2) << mean
+       << ", std dev " << stddev << std::defaultfloat << ", "
+       << distinct.size() << " distinct" << std::endl;
+
+    if(distinct.size() > 1) {
+
+        // Each distinct count if there are few, else even buckets.
+        std::vector<std::pair<uint64_t, size_t>> hist;
+        uint64_t width = 1;
+
+        if(distinct.size() <= CT_TRACE_BUCKETS) {
+            hist.assign(distinct.begin(), distinct.end());
+        } else {
+            width = (hi - lo) / CT_TRACE_BUCKETS + 1;
+            for(uint64_t b = 0; b <= (hi - lo) / width; b ++) {
+                hist.push_back({lo + b * width, 0});
+            }
+            for(uint64_t c : cycles) {
+                hist[(c - lo) / width].second ++;
+            }
+        }
+
+        for(auto const & h : hist) {
+            std::string range = std::to_string(h.first);
+            if(width > 1) {
+                range += "-" + std::to_string(h.first + width - 1);
+            }
+            os << ">>   " << std::left << std::setw(24) << range
+               << std::right << std::setw(10) << h.second << " "
+               << std::string(60 * h.second / runs, '#') << std::endl;
+        }
+    }
+
+    // Instructions whose visits or cycles differ, most cycles apart first,
+    // and loads and stores whose addresses differ, in most runs first.
+    std::vector<std::pair<uint32_t, ct_pc_t>> timing;
+    std::vector<std::pair<uint32_t, ct_pc_t>> addrs;
+
+    for(auto const & p : pcs) {
+        if(p.second.visits_min != p.second.visits_max ||
+           p.second.cycles_min != p.second.cycles_max) {
+            timing.push_back(p);
+        }
+        if(p.second.addr_runs) {
+            addrs.push_back(p);
+        }
+    }
+
+    std::stable_sort(timing.begin(), timing.end(),
+        [](std::pair<uint32_t, ct_pc_t> const & a,
+           std::pair<uint32_t, ct_pc_t> const & b) {
+            return a.second.cycles_max - a.second.cycles_min >
+                   b.second.cycles_max - b.second.cycles_min;
+        });
+
+    std::stable_sort(addrs.begin(), addrs.end(),
+        [](std::pair<uint32_t, ct_pc_t> const & a,
+           std::pair<uint32_t, ct_pc_t> const & b) {
+            return a.second.addr_runs > b.second.addr_runs;
+        });
+
+    auto disasm = [](uint32_t pc, uint32_t instr) {
+        return instr_disasm(instr_is_32bit(instr) ? instr : instr & 0xFFFF,
+                            pc);
+    };
+
+    if(!timing.empty()) {
+        os << ">> " << timing.size()
+           << " instructions differ in visits or cycles between runs"
+           << std::endl;
+        os << ">>   " << std::left << std::setw(10) << "pc"
+           << std::setw(32) << "instruction" << std::right
+           << std::setw(16) << "visits" << std::setw(20) << "cycles"
+           << std::endl;
+    }
+
+    for(size_t i = 0; i < timing.size() && i < CT_TRACE_TOP_PCS; i ++) {
+        ct_pc_t const & p = timing[i].second;
+        char pc[16];
+        snprintf(pc, sizeof(pc), "%08x", timing[i].first);
+        os << ">>   " << std::left << std::setw(10) << pc
+           << std::setw(32) << disasm(timing[i].first, p.instr)
+           << std::right << std::setw(16)
+           << (std::to_string(p.visits_min) + "-" +
+               std::to_string(p.visits_max))
+           << std::setw(20)
+           << (std::to_string(p.cycles_min) + "-" +
+               std::to_string(p.cycles_max)) << std::endl;
+    }
+
+    auto hex = [](int64_t addr) {
+        char h[16];
+        snprintf(h, sizeof(h), "0x%08lx", (unsigned long)addr);
+        return addr < 0 ? std::string("none") : std::string(h);
+    };
+
+    if(!addrs.empty()) {
+        os << ">> " << addrs.size() << " loads / stores access addresses "
+           << "which depend on the input" << std::endl;
+        os << ">>   " << std::left << std::setw(10) << "pc"
+           << std::setw(32) << "instruction" << std::right
+           << std::setw(8) << "runs" << "  first difference" << std::endl;
+    }
+
+    for(size_t i = 0; i < addrs.size() && i < CT_TRACE_TOP_PCS; i ++) {
+        ct_pc_t const & p = addrs[i].second;
+        char pc[16];
+        snprintf(pc, sizeof(pc), "%08x", addrs[i].first);
+        std::string diff = "access " + std::to_string(p.addr_index) + ": " +
+                           hex(p.addr_ref) + " in run " +
+                           std::to_string(ref_run) + ", " +
+                           hex(p.addr_diff) + " in run " +
+                           std::to_string(p.addr_run);
+        os << ">>   " << std::left << std::setw(10) << pc
+           << std::setw(32) << disasm(addrs[i].first, p.instr)
+           << std::right << std::setw(8) << p.addr_runs << "  " << diff
+           << std::endl;
+    }
+
+    bool constant = distinct.size() == 1 && timing.empty() && addrs.empty();
+
+    if(constant) {
+        os << ">> Constant time: no differences between " << runs
+           << " runs" << std::endl;
+    } else {
+        os << ">> NOT constant time" << std::endl;
+    }
+
+    if(json_path == "") {
+        return constant;
+    }
+
+    FILE * fh = fopen(json_path.c_str(), "w");
+
+    if(fh == NULL) {
+        os << ">> Could not write " << json_path << std::endl;
+        return constant;
+    }
+
+    fprintf(fh, "{\n  \"runs\": %lu,\n  \"compared\": %lu,\n"
+                "  \"constant_time\": %s,\n  \"cycles\": {\"min\": %lu, "
+                "\"max\": %lu, \"mean\": %f, \"stddev\": %f, \"counts\": {",
+            (unsigned long)paths.size(), (unsigned long)runs,
+            constant ? "true" : "false", (unsigned long)lo,
+            (unsigned long)hi, mean, stddev);
+
+    bool first = true;
+
+    for(auto const & d : distinct) {
+        fprintf(fh, "%s\"%lu\": %lu", first ? "" : ", ",
+                (unsigned long)d.first, (unsigned long)d.second);
+        first = false;
+    }
+
+    fprintf(fh, "}},\n  \"timing\": [\n");
+
+    first = true;
+
+    for(auto const & t : timing) {
+        ct_pc_t const & p = t.second;
+        fprintf(fh, "%s    {\"pc\": %u, \"instr\": %u, \"visits_min\": %lu, "
+                    "\"visits_max\": %lu, \"cycles_min\": %lu, "
+                    "\"cycles_max\": %lu}",
+                first ? "" : ",\n", t.first, p.instr,
+                (unsigned long)p.visits_min, (unsigned long)p.visits_max,
+                (unsigned long)p.cycles_min, (unsigned long)p.cycles_max);
+        first = false;
+    }
+
+    fprintf(fh, "%s  ],\n  \"addresses\": [\n", first ? "" : "\n");
+
+    first = true;
+
+    for(auto const & a : addrs) {
+        ct_pc_t const & p = a.second;
+        fprintf(fh, "%s    {\"pc\": %u, \"instr\": %u, \"runs\": %u, "
+                    "\"run\": %lu, \"index\": %lu, \"expected\": %ld, "
+                    "\"actual\": %ld}",
+                first ? "" : ",\n", a.first, p.instr, p.addr_runs,
+                (unsigned long)p.addr_run, (unsigned long)p.addr_index,
+                (long)p.addr_ref, (long)p.addr_diff);
+        first = false;
+    }
+
+    fprintf(fh, "%s  ]\n}\n", first ? "" : "\n");
+    fclose(fh);
+
+    return constant;
+
+}
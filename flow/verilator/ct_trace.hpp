@@ -0,0 +1,90 @@
+
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#ifndef CT_TRACE_HPP
+#define CT_TRACE_HPP
+
+/*!
+@brief Records what a constant time analysis compares between runs of a
+    program on different secret inputs: when each instruction retired,
+    and the data address it accessed, if any.
+@details Written as the run goes, one line per instruction:
+    "<pc> <instr> <cycles>" in hex and decimal, plus " r <addr>" or
+    " w <addr>" for loads and stores. cycles are those since the previous
+    instruction retired. The last line is "end <cycles> <status>", with
+    the run's cycles and batch_status_t.
+*/
+class ct_trace {
+
+public:
+
+    /*!
+    @brief Start a trace.
+    @param in start_cycle - Simulation cycle now. The first instruction
+                            is charged the cycles since.
+    */
+    ct_trace(uint64_t start_cycle);
+
+    ~ct_trace();
+
+    //! Open the file to trace to. Returns false if it could not be.
+    bool open(std::string path);
+
+    /*!
+    @brief An instruction retired, as RVFI reports it.
+    @param in count - Trace it? Those which are not still start the
+                      cycles charged to the next one.
+    */
+    void retired (
+        uint32_t pc     ,
+        uint32_t instr  ,
+        uint64_t cycle  ,
+        uint8_t  rmask  ,
+        uint8_t  wmask  ,
+        uint32_t addr   ,
+        bool     count
+    );
+
+    //! Finish the trace with the run's cycles and status.
+    void finish(uint64_t cycles, int status);
+
+protected:
+
+    FILE      * fh          = NULL;
+
+    //! Cycle the last instruction retired in.
+    uint64_t    last_cycle  = 0;
+
+};
+
+/*!
+@brief Parse "<addr>:<hex bytes>", e.g. "0x80001000:00ff10", the secret
+    input to write to memory before a run. Bytes are in address order.
+@returns false if spec is not of that form.
+*/
+bool ct_input_parse (
+    std::string            spec ,
+    uint32_t             & addr ,
+    std::vector<uint8_t> & bytes
+);
+
+/*!
+@brief Compare the traces of runs of one program on different inputs.
+@details Reports the distribution of the runs' cycle counts, the
+    instructions whose visits or cycles differ between runs, and the
+    loads and stores whose sequence of addresses differs from the first
+    run's. Only runs which passed are compared.
+@param in json_path - If set, also write the results here as JSON.
+@returns true if no differences were found.
+*/
+bool ct_analyse (
+    std::vector<std::string> const & paths    ,
+    std::ostream                   & os       ,
+    std::string                      json_path
+);
+
+#endif
@@ -0,0 +1,82 @@
+
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include <string>
+
+#include "elf.hpp"
+#include "instr_disasm.hpp"
+
+/*!
+@brief Disassemble the executable sections of an ELF file.
+@details With -g, print one line per distinct instruction word,
+    "<word> <disassembly>" sorted by word, for use as a gtkwave translate
+    filter file. Otherwise print a listing, "<addr>: <word> <disassembly>".
+*/
+int main(int argc, char ** argv) {
+
+    bool        gtkwave = false;
+    std::string path    = "";
+
+    for(int i = 1; i < argc; i ++) {
+        if(!strcmp(argv[i], "-g")) {
+            gtkwave = true;
+        } else {
+            path    = argv[i];
+        }
+    }
+
+    if(path == "") {
+        fprintf(stderr, "Usage: %s [-g] <elf file>\n", argv[0]);
+        fprintf(stderr, "  -g   - Write a gtkwave translate filter file.\n");
+        return 1;
+    }
+
+    elf_file elf(path);
+
+    if(!elf.ok) {
+        fprintf(stderr, "ERROR: %s\n", elf.error.c_str());
+        return 1;
+    }
+
+    // Zero extended 16-bit words sort before any 32-bit word.
+    std::set<uint32_t> words;
+
+    for(elf_section_t const & s : elf.sections) {
+
+        if(!(s.flags & ELF_SHF_EXECINSTR) || s.nobits) {
+            continue;
+        }
+
+        if(!gtkwave) {
+            printf("\n%s:\n", s.name.c_str());
+        }
+
+        for(size_t i = 0; i + 1 < s.data.size(); ) {
+
+            uint32_t word = s.data[i] | s.data[i + 1] << 8;
+            size_t   len  = 2;
+
+            if(instr_is_32bit(word) && i + 3 < s.data.size()) {
+                word |= s.data[i + 2] << 16 | (uint32_t)s.data[i + 3] << 24;
+                len   = 4;
+            }
+
+            if(gtkwave) {
+                words.insert(word);
+            } else {
+                printf("%8x: %08x %s\n", s.addr + (uint32_t)i, word,
+                       instr_disasm(word, s.addr + (uint32_t)i).c_str());
+            }
+
+            i += len;
+        }
+    }
+
+    for(uint32_t word : words) {
+        printf("%08x %s\n", word, instr_disasm(word).c_str());
+    }
+
+    return 0;
+
+}
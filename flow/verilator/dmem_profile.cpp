@@ -0,0 +1,359 @@
+
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+
+#include "batch.hpp"
+#include "dmem_profile.hpp"
+
+//! Number of lines the report lists, hottest first.
+#define DMEM_PROFILE_HOT_LINES 16
+
+//! Number of bits set in a byte mask.
+static unsigned dmem_profile_popcount(uint8_t m) {
+    unsigned n = 0;
+    for(; m; m >>= 1) n += m & 0x1;
+    return n;
+}
+
+
+//! Start profiling.
+dmem_profile::dmem_profile (
+    uint64_t start_cycle,
+    uint32_t line_size  ,
+    uint64_t window
+) {
+
+    this -> line_size    = line_size;
+    this -> window       = window;
+    this -> window_start = start_cycle;
+
+}
+
+
+//! Close windows ending by cycle.
+void dmem_profile::windows_until(uint64_t cycle) {
+
+    while(cycle >= this -> window_start + this -> window) {
+        this -> working_set.push_back(this -> window_lines.size());
+        this -> window_lines.clear();
+        this -> window_start += this -> window;
+    }
+
+}
+
+
+//! The core asked for a data memory access.
+void dmem_profile::access (
+    uint32_t addr ,
+    bool     write,
+    uint8_t  strb ,
+    uint64_t cycle
+) {
+
+    this -> windows_until(cycle);
+
+    dmem_profile_count_t & w = this -> words[addr & ~0x3u];
+
+    if(write) {
+        w.writes      ++;
+        this -> writes++;
+    } else {
+        w.reads       ++;
+        this -> reads ++;
+    }
+
+    w.bytes |= strb ? strb & 0xF : 0xF;
+
+    this -> window_lines.insert(addr & ~(this -> line_size - 1));
+
+}
+
+
+//! An instruction wrote value to the stack pointer.
+void dmem_profile::sp_written(uint32_t value, bool count) {
+
+    if(count) {
+        if(this -> sp_known) {
+            this -> sp_max = std::max(this -> sp_max, this -> sp_last);
+            this -> sp_min = std::min(this -> sp_min, this -> sp_last);
+        }
+        this -> sp_max = std::max(this -> sp_max, value);
+        this -> sp_min = std::min(this -> sp_min, value);
+    }
+
+    this -> sp_last  = value;
+    this -> sp_known = true;
+
+}
+
+
+//! Stop profiling at cycle, closing the last working set window.
+void dmem_profile::finish(uint64_t cycle) {
+
+    this -> windows_until(cycle);
+
+    if(cycle > this -> window_start) {
+        this -> working_set.push_back(this -> window_lines.size());
+        this -> window_lines.clear();
+        this -> window_start = cycle;
+    }
+
+}
+
+
+//! Report usage of the STT_OBJECT symbols of this ELF file.
+bool dmem_profile::add_symbols(std::string elf_path) {
+
+    elf_file elf(elf_path);
+
+    if(!elf.ok) {
+        return false;
+    }
+
+    for(elf_symbol_t const & s : elf.symbols) {
+        if(s.type == ELF_STT_OBJECT && s.size) {
+            this -> objects.push_back(s);
+        }
+    }
+
+    std::stable_sort(this -> objects.begin(), this -> objects.end(),
+        [](elf_symbol_t const & a, elf_symbol_t const & b) {
+            return a.addr < b.addr;
+        });
+
+    return true;
+
+}
+
+
+//! Counts gathered per line, by line address.
+std::map<uint32_t, dmem_profile_count_t> dmem_profile::lines() {
+
+    std::map<uint32_t, dmem_profile_count_t> l;
+
+    for(auto const & w : this -> words) {
+        dmem_profile_count_t & n = l[w.first & ~(this -> line_size - 1)];
+        n.reads  += w.second.reads;
+        n.writes += w.second.writes;
+    }
+
+    return l;
+
+}
+
+
+//! Counts gathered for one object.
+dmem_profile_count_t dmem_profile::object (
+    elf_symbol_t const & o   ,
+    uint32_t           & used
+) {
+
+    dmem_profile_count_t n;
+
+    uint64_t end = (uint64_t)o.addr + o.size;
+
+    used = 0;
+
+    // Words which overlap the object at all are counted against it.
+    for(auto w  = this -> words.lower_bound(o.addr & ~0x3u);
+             w != this -> words.end() && w -> first < end; w ++) {
+
+        n.reads  += w -> second.reads;
+        n.writes += w -> second.writes;
+
+        for(int b = 3; b >= 0; b --) {
+            uint64_t a = w -> first + b;
+            if((w -> second.bytes >> b & 0x1) && a >= o.addr && a < end) {
+                used = std::max(used, (uint32_t)(a - o.addr + 1));
+                break;
+            }
+        }
+    }
+
+    return n;
+
+}
+
+
+//! Print the totals, stack, working set, hottest lines and objects.
+void dmem_profile::report(std::ostream & os) {
+
+    uint64_t touched = 0;
+
+    for(auto const & w : this -> words) {
+        touched += dmem_profile_popcount(w.second.bytes);
+    }
+
+    std::map<uint32_t, dmem_profile_count_t> l = this -> lines();
+
+    os << ">> Data memory: " << std::dec << this -> reads << " reads, "
+       << this -> writes << " writes";
+    if(this -> writes) {
+        os << " (" << std::fixed << std::setprecision(2)
+           << (double)this -> reads / this -> writes << " reads per write)"
+           << std::defaultfloat;
+    }
+    os << ", " << touched << " bytes in " << l.size() << " lines of "
+       << this -> line_size << " bytes accessed" << std::endl;
+
+    if(this -> sp_min <= this -> sp_max) {
+        os << ">> Stack: sp from 0x" << std::hex << this -> sp_max
+           << " down to 0x" << this -> sp_min << std::dec << ", "
+           << this -> sp_max - this -> sp_min << " bytes deep" << std::endl;
+    }
+
+    if(!this -> working_set.empty()) {
+
+        uint64_t lo  = UINT64_MAX;
+        uint64_t hi  = 0;
+        uint64_t sum = 0;
+
+        for(uint64_t n : this -> working_set) {
+            lo   = std::min(lo, n);
+            hi   = std::max(hi, n);
+            sum += n;
+        }
+
+        os << ">> Working set per " << this -> window << " cycles: "
+           << lo << " to " << hi << " lines, "
+           << sum / this -> working_set.size() << " on average, over "
+           << this -> working_set.size() << " windows (peak "
+           << hi * this -> line_size << " bytes)" << std::endl;
+    }
+
+    // Lines, most accesses first.
+    std::vector<std::pair<uint32_t, dmem_profile_count_t>> hot(l.begin(),
+                                                               l.end());
+
+    std::stable_sort(hot.begin(), hot.end(),
+        [](std::pair<uint32_t, dmem_profile_count_t> const & a,
+           std::pair<uint32_t, dmem_profile_count_t> const & b) {
+            return a.second.reads + a.second.writes >
+                   b.second.reads + b.second.writes;
+        });
+
+    if(hot.size() > DMEM_PROFILE_HOT_LINES) {
+        hot.resize(DMEM_PROFILE_HOT_LINES);
+    }
+
+    if(!hot.empty()) {
+        os << ">>   " << std::left << std::setw(24) << "line" << std::right
+           << std::setw(12) << "reads" << std::setw(12) << "writes"
+           << std::endl;
+    }
+
+    for(auto const & h : hot) {
+        char addr[16];
+        snprintf(addr, sizeof(addr), "%08x", h.first);
+        os << ">>   " << std::left << std::setw(24) << addr << std::right
+           << std::setw(12) << h.second.reads
+           << std::setw(12) << h.second.writes << std::endl;
+    }
+
+    if(this -> objects.empty()) {
+        return;
+    }
+
+    // Objects, in address order. Those never accessed are only totalled.
+    uint64_t unused       = 0;
+    uint64_t unused_bytes = 0;
+
+    os << ">>   " << std::left << std::setw(24) << "object" << std::right
+       << std::setw(12) << "reads" << std::setw(12) << "writes"
+       << std::setw(10) << "used" << std::setw(10) << "size" << std::endl;
+
+    for(elf_symbol_t const & o : this -> objects) {
+
+        uint32_t             used;
+        dmem_profile_count_t n = this -> object(o, used);
+
+        if(n.reads + n.writes == 0) {
+            unused       ++;
+            unused_bytes += o.size;
+            continue;
+        }
+
+        os << ">>   " << std::left << std::setw(24) << o.name << std::right
+           << std::setw(12) << n.reads << std::setw(12) << n.writes
+           << std::setw(10) << used << std::setw(10) << o.size << std::endl;
+    }
+
+    if(unused) {
+        os << ">>   " << unused << " objects (" << unused_bytes
+           << " bytes) were never accessed" << std::endl;
+    }
+
+}
+
+
+//! Write the profile as JSON.
+bool dmem_profile::write_json(std::string path) {
+
+    FILE * fh = fopen(path.c_str(), "w");
+
+    if(fh == NULL) {
+        return false;
+    }
+
+    uint64_t touched = 0;
+
+    for(auto const & w : this -> words) {
+        touched += dmem_profile_popcount(w.second.bytes);
+    }
+
+    fprintf(fh, "{\n  \"reads\": %lu,\n  \"writes\": %lu,\n"
+                "  \"line_size\": %u,\n  \"bytes_touched\": %lu,\n",
+            (unsigned long)this -> reads, (unsigned long)this -> writes,
+            this -> line_size, (unsigned long)touched);
+
+    if(this -> sp_min <= this -> sp_max) {
+        fprintf(fh, "  \"sp_min\": %u,\n  \"sp_max\": %u,\n",
+                this -> sp_min, this -> sp_max);
+    }
+
+    fprintf(fh, "  \"window\": %lu,\n  \"working_set\": [",
+            (unsigned long)this -> window);
+
+    for(size_t i = 0; i < this -> working_set.size(); i ++) {
+        fprintf(fh, "%s%lu", i ? ", " : "",
+                (unsigned long)this -> working_set[i]);
+    }
+
+    fprintf(fh, "],\n  \"lines\": {\n");
+
+    std::map<uint32_t, dmem_profile_count_t> l = this -> lines();
+
+    bool first = true;
+
+    for(auto const & n : l) {
+        fprintf(fh, "%s    \"0x%08x\": {\"reads\": %lu, \"writes\": %lu}",
+                first ? "" : ",\n", n.first,
+                (unsigned long)n.second.reads,
+                (unsigned long)n.second.writes);
+        first = false;
+    }
+
+    fprintf(fh, "%s  },\n  \"objects\": [\n", first ? "" : "\n");
+
+    first = true;
+
+    for(elf_symbol_t const & o : this -> objects) {
+
+        uint32_t             used;
+        dmem_profile_count_t n = this -> object(o, used);
+
+        fprintf(fh, "%s    {\"name\": \"%s\", \"addr\": %u, \"size\": %u, "
+                    "\"used\": %u, \"reads\": %lu, \"writes\": %lu}",
+                first ? "" : ",\n", json_escape(o.name).c_str(), o.addr,
+                o.size, used,
+                (unsigned long)n.reads, (unsigned long)n.writes);
+        first = false;
+    }
+
+    fprintf(fh, "%s  ]\n}\n", first ? "" : "\n");
+    fclose(fh);
+
+    return true;
+
+}
@@ -0,0 +1,140 @@
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "elf.hpp"
+
+#ifndef DMEM_PROFILE_HPP
+#define DMEM_PROFILE_HPP
+
+//! Accesses counted against one word, line or data object.
+typedef struct dmem_profile_count {
+    uint64_t    reads       = 0;
+    uint64_t    writes      = 0;
+    uint8_t     bytes       = 0; //!< Bytes of a word ever accessed.
+} dmem_profile_count_t;
+
+//! Is bytes a usable line size: a power of two, at least a word?
+inline bool dmem_profile_line_ok(uint32_t bytes) {
+    return bytes >= 4 && (bytes & (bytes - 1)) == 0;
+}
+
+/*!
+@brief Profiles the data memory accesses of a run, to show how much
+    memory a program needs and which of it is hot.
+@details Counts reads and writes per word, which the report gathers per
+    line of line_size bytes (a heatmap) and per data object of the
+    program's symbol table. Also follows the stack pointer down to its
+    lowest value, and the working set: distinct lines accessed in each
+    window of window cycles. Cycles are simulation cycles, as +TIMEOUT.
+*/
+class dmem_profile {
+
+public:
+
+    /*!
+    @brief Start profiling.
+    @param in start_cycle - Simulation cycle now. The first window
+                            starts here.
+    @param in line_size   - Bytes per heatmap line, a power of two.
+    @param in window      - Cycles per working set window.
+    */
+    dmem_profile(uint64_t start_cycle, uint32_t line_size, uint64_t window);
+
+    /*!
+    @brief The core asked for a data memory access.
+    @param in addr  - Word address, as dmem_addr.
+    @param in write - As dmem_wen.
+    @param in strb  - Bytes of the word accessed, as dmem_strb.
+    @param in cycle - Simulation cycle of the request.
+    */
+    void access(uint32_t addr, bool write, uint8_t strb, uint64_t cycle);
+
+    /*!
+    @brief An instruction wrote value to the stack pointer.
+    @param in count - Count it? If so the value it had before is counted
+                      too, so the stack depth is from where it was when
+                      counting started.
+    */
+    void sp_written(uint32_t value, bool count);
+
+    //! Stop profiling at cycle, closing the last working set window.
+    void finish(uint64_t cycle);
+
+    /*!
+    @brief Report usage of the STT_OBJECT symbols of this ELF file.
+    @returns false if it could not be read.
+    */
+    bool add_symbols(std::string elf_path);
+
+    //! Reads counted.
+    uint64_t    reads       = 0;
+
+    //! Writes counted.
+    uint64_t    writes      = 0;
+
+    //! Highest and lowest values the stack pointer was given.
+    uint32_t    sp_max      = 0;
+    uint32_t    sp_min      = UINT32_MAX;
+
+    /*!
+    @brief Print the totals, the stack depth, the working set, the
+        hottest lines and the data objects accessed.
+    */
+    void report(std::ostream & os);
+
+    /*!
+    @brief Write the profile as JSON: {"reads": N, "writes": N,
+        "line_size": N, "bytes_touched": N, "sp_min": N, "sp_max": N,
+        "window": N, "working_set": [<lines per window>, ...],
+        "lines": {"<addr>": {"reads": N, "writes": N}, ...},
+        "objects": [{"name": "<name>", "addr": N, "size": N, "used": N,
+        "reads": N, "writes": N}, ...]}. Objects are listed in address
+        order, whether accessed or not.
+    @returns false if the file could not be written.
+    */
+    bool write_json(std::string path);
+
+protected:
+
+    uint32_t    line_size   ;
+    uint64_t    window      ;
+
+    //! Counts for each word accessed, by word address.
+    std::map<uint32_t, dmem_profile_count_t> words;
+
+    //! Data objects to report on, by address.
+    std::vector<elf_symbol_t> objects;
+
+    //! Last value written to the stack pointer, if sp_known.
+    uint32_t    sp_last     = 0;
+    bool        sp_known    = false;
+
+    //! Lines accessed so far in the current window.
+    std::unordered_set<uint32_t> window_lines;
+
+    //! Start of the current window.
+    uint64_t    window_start;
+
+    //! Lines accessed in each window so far.
+    std::vector<uint64_t> working_set;
+
+    //! Close windows ending by cycle.
+    void windows_until(uint64_t cycle);
+
+    //! Counts gathered per line, by line address.
+    std::map<uint32_t, dmem_profile_count_t> lines();
+
+    /*!
+    @brief Counts gathered for one object. bytes is not set: used is the
+        offset of the highest byte accessed, plus one.
+    */
+    dmem_profile_count_t object(elf_symbol_t const & o, uint32_t & used);
+
+};
+
+#endif
@@ -1,14 +1,81 @@
 
 #include <assert.h>
+#include <iostream>
+
+#include "Vfrv_core__Dpi.h"
 
 #include "dut_wrapper.hpp"
+#include "tb_random.hpp"
+#include "instr_disasm.hpp"
+
+//! Parse a wave trigger: cycle:<N>, pc:<addr>, write:<addr> or marker:<N>.
+bool dut_wave_trigger_parse(std::string spec, dut_wave_trigger_t & trigger) {
+
+    size_t colon = spec.find(':');
+
+    if(colon == std::string::npos) {
+        return false;
+    }
+
+    std::string kind = spec.substr(0, colon);
+
+    if     (kind == "cycle" ) trigger.kind = WAVE_TRIGGER_CYCLE ;
+    else if(kind == "pc"    ) trigger.kind = WAVE_TRIGGER_PC    ;
+    else if(kind == "write" ) trigger.kind = WAVE_TRIGGER_WRITE ;
+    else if(kind == "marker") trigger.kind = WAVE_TRIGGER_MARKER;
+    else {
+        return false;
+    }
+
+    try {
+        trigger.value = std::stoull(spec.substr(colon + 1), NULL, 0);
+    } catch(std::exception const &) {
+        return false;
+    }
+
+    return true;
+
+}
+
+
+//! Restrict a wave file to a comma separated list of scopes.
+static void dut_wave_scopes(dut_wave_file_t * fh, std::string scopes) {
+
+    size_t start = 0;
+
+    while(start < scopes.size()) {
+
+        size_t end = scopes.find(',', start);
+
+        if(end == std::string::npos) {
+            end = scopes.size();
+        }
+
+        std::string scope = scopes.substr(start, end - start);
+
+        if(scope != "") {
+#if defined(VERILATOR_VERSION_INTEGER) && VERILATOR_VERSION_INTEGER >= 5000000
+            fh -> dumpvars(0, scope);
+#else
+            std::cout << ">> Ignoring wave scope " << scope
+                      << ": needs Verilator 5 or later." << std::endl;
+#endif
+        }
+
+        start = end + 1;
+    }
+
+}
+
 
 /*!
 */
 dut_wrapper::dut_wrapper (
     memory_bus    * mem         ,
     bool            dump_waves  ,
-    std::string     wavefile
+    std::string     wavefile    ,
+    int             waves_depth ,
+    std::string     waves_scope
 ){
 
 
@@ -53,17 +120,41 @@ dut_wrapper::dut_wrapper (
         &this -> dut -> rng_rsp_ready  
     );
 
+    this -> irq_if_agent = new irq_agent (
+        &this -> dut -> int_nmi         ,
+        &this -> dut -> int_external    ,
+        &this -> dut -> int_extern_cause,
+        &this -> dut -> int_software
+    );
+
     Verilated::traceEverOn(this -> dump_waves);
 
     if(this -> dump_waves){
-        this -> trace_fh = new VerilatedVcdC;
-        this -> dut -> trace(this -> trace_fh, 99);
+        this -> trace_fh = new dut_wave_file_t;
+        this -> dut -> trace(this -> trace_fh, waves_depth);
+        dut_wave_scopes(this -> trace_fh, waves_scope);
         this -> trace_fh -> open(this ->vcd_wavefile_path.c_str());
     }
 
     this -> sim_time               = 0;
 
 }
+
+
+//! Free the model, agents and wave file handle.
+dut_wrapper::~dut_wrapper() {
+
+    if(this -> dump_waves) {
+        delete this -> trace_fh;
+    }
+
+    delete this -> imem_agent;
+    delete this -> dmem_agent;
+    delete this -> rng_if_agent;
+    delete this -> irq_if_agent;
+    delete this -> dut;
+
+}
     
 //! Put the dut in reset.
 void dut_wrapper::dut_set_reset() {
@@ -75,6 +166,7 @@ void dut_wrapper::dut_set_reset() {
     this -> imem_agent -> set_reset();
     this -> dmem_agent -> set_reset();
     this -> rng_if_agent -> set_reset();
+    this -> irq_if_agent -> set_reset();
 
 }
     
@@ -86,6 +178,100 @@ void dut_wrapper::dut_clear_reset() {
     this -> imem_agent -> clear_reset();
     this -> dmem_agent -> clear_reset();
     this -> rng_if_agent -> clear_reset();
+    this -> irq_if_agent -> clear_reset();
+
+}
+
+
+//! Prepare an already used model for a new run.
+void dut_wrapper::dut_restart() {
+
+    this -> sim_time = 0;
+
+    std::queue<dut_trace_pkt_t>().swap(this -> dut_trace);
+
+    this -> waves_active = this -> waves_start.kind == WAVE_TRIGGER_NONE;
+    this -> waves_stopped= false;
+    this -> waves_cycle  = 0;
+
+    this -> roi_inside   = false;
+    this -> roi_begin    = 0;
+    this -> roi_ticks    = 0;
+    this -> roi_entries  = 0;
+    this -> roi_instrs   = 0;
+
+    this -> imem_agent -> stats = sram_agent_stats_t();
+    this -> dmem_agent -> stats = sram_agent_stats_t();
+
+    if(this -> dump_waves) {
+        this -> trace_fh -> close();
+        this -> trace_fh -> open(this -> vcd_wavefile_path.c_str());
+    }
+
+}
+
+
+//! Write the model, agents, trace queue, PRNG and simulation time.
+void dut_wrapper::save_state (VerilatedSerialize & os) {
+
+    uint64_t rand_state = tb_rand_get_state();
+
+    os << this -> sim_time << rand_state;
+
+    os << this -> waves_active << this -> waves_stopped << this -> waves_cycle;
+
+    os << this -> roi_inside << this -> roi_begin << this -> roi_ticks
+       << this -> roi_entries << this -> roi_instrs;
+
+    os << *this -> dut;
+
+    this -> imem_agent   -> save_state(os);
+    this -> dmem_agent   -> save_state(os);
+    this -> rng_if_agent -> save_state(os);
+    this -> irq_if_agent -> save_state(os);
+
+    uint64_t num_trace = this -> dut_trace.size();
+    os << num_trace;
+
+    std::queue<dut_trace_pkt_t> trace = this -> dut_trace;
+    while(trace.size() > 0) {
+        os << trace.front().program_counter << trace.front().instr_word;
+        trace.pop();
+    }
+
+}
+
+
+//! Restore everything written by save_state.
+void dut_wrapper::restore_state (VerilatedDeserialize & is) {
+
+    uint64_t rand_state = 0;
+
+    is >> this -> sim_time >> rand_state;
+
+    tb_rand_set_state(rand_state);
+
+    is >> this -> waves_active >> this -> waves_stopped >> this -> waves_cycle;
+
+    is >> this -> roi_inside >> this -> roi_begin >> this -> roi_ticks
+       >> this -> roi_entries >> this -> roi_instrs;
+
+    is >> *this -> dut;
+
+    this -> imem_agent   -> restore_state(is);
+    this -> dmem_agent   -> restore_state(is);
+    this -> rng_if_agent -> restore_state(is);
+    this -> irq_if_agent -> restore_state(is);
+
+    uint64_t num_trace = 0;
+    is >> num_trace;
+
+    std::queue<dut_trace_pkt_t>().swap(this -> dut_trace);
+    for(uint64_t i = 0; i < num_trace; i ++) {
+        dut_trace_pkt_t pkt;
+        is >> pkt.program_counter >> pkt.instr_word;
+        this -> dut_trace.push(pkt);
+    }
 
 }
 
@@ -116,12 +302,16 @@ void dut_wrapper::dut_step_clk() {
         this -> imem_agent -> drive_signals();
         this -> dmem_agent -> drive_signals();
         this -> rng_if_agent  -> drive_signals();
+        this -> irq_if_agent  -> drive_signals();
 
         this -> dut -> eval();
 
         this -> sim_time ++;
 
-        if(this -> dump_waves) {
+        // Nothing but the clock edge changes the design, so once settled
+        // after it is the only time worth dumping.
+        if(this -> dump_waves && this -> waves_active && this -> in_roi() &&
+           i == this -> evals_per_clock / 2) {
             this -> trace_fh -> dump(this -> sim_time);
         }
 
@@ -130,11 +320,294 @@ void dut_wrapper::dut_step_clk() {
 }
 
 
+//! Scope of the DPI hooks in frv_counters.
+static void dut_counters_scope() {
+    svSetScope(svGetScopeFromName("TOP.frv_core.i_counters"));
+}
+
+
+//! Scope of the DPI hooks in frv_csrs.
+static void dut_csrs_scope() {
+    svSetScope(svGetScopeFromName("TOP.frv_core.i_pipeline.i_csrs"));
+}
+
+
+//! Scope of the DPI hooks in frv_pipeline.
+static void dut_pipeline_scope() {
+    svSetScope(svGetScopeFromName("TOP.frv_core.i_pipeline"));
+}
+
+
+//! Simulate one period of g_clk which also skips over cycles idle ones.
+void dut_wrapper::dut_skip_clk(uint64_t cycles) {
+
+    dut_counters_scope();
+    frv_counters_skip(cycles);
+
+    // Each step is half a period of g_clk, so two always see one rising
+    // edge.
+    this -> dut_step_clk();
+    this -> dut_step_clk();
+
+    dut_counters_scope();
+    frv_counters_skip(0);
+
+    this -> sim_time += 2 * cycles * this -> evals_per_clock;
+
+    this -> irq_if_agent -> skip(cycles);
+
+}
+
+
+//! Current value of the core's mtime register.
+uint64_t dut_wrapper::dut_mtime() {
+
+    dut_counters_scope();
+
+    return frv_counters_mtime();
+
+}
+
+
+//! Print the traffic counted on the imem and dmem ports.
+void dut_wrapper::mem_stats_report (std::ostream & os) {
+
+    this -> imem_agent -> report(os, "imem");
+    this -> dmem_agent -> report(os, "dmem");
+
+}
+
+
+//! Write the traffic counted on each port as JSON.
+bool dut_wrapper::mem_stats_json (std::string path) {
+
+    FILE * fh = fopen(path.c_str(), "w");
+
+    if(fh == NULL) {
+        return false;
+    }
+
+    fprintf(fh, "{\n  \"imem\": ");
+    this -> imem_agent -> write_json(fh);
+    fprintf(fh, ",\n  \"dmem\": ");
+    this -> dmem_agent -> write_json(fh);
+    fprintf(fh, "\n}\n");
+    fclose(fh);
+
+    return true;
+
+}
+
+
+//! Start counting toggles from zero, now.
+void dut_wrapper::toggle_start() {
+
+#if VM_COVERAGE
+    VerilatedCov::zero();
+#endif
+
+    this -> toggle_begin = this -> sim_time;
+    this -> toggle_end   = this -> sim_time;
+    this -> toggle_written = false;
+
+}
+
+
+//! Write the toggle counts to toggle_path, if the run has covered any.
+bool dut_wrapper::toggle_finish() {
+
+#if !VM_COVERAGE
+    std::cout << ">> The model does not count toggles. Build it with"
+              << " VL_TOGGLE=1." << std::endl;
+    return false;
+#endif
+
+    if(this -> roi_enable && this -> roi_entries == 0) {
+        std::cout << ">> No region of interest was entered, so no toggles"
+                  << " were counted." << std::endl;
+        return false;
+    }
+
+    // Already written at the last ROI end.
+    if(this -> roi_enable && !this -> roi_inside) {
+        return this -> toggle_written;
+    }
+
+    this -> toggle_end = this -> sim_time;
+
+    return this -> toggle_write();
+
+}
+
+
+//! Write the toggle counts from toggle_begin to toggle_end.
+bool dut_wrapper::toggle_write() {
+
+#if VM_COVERAGE
+
+    VerilatedCov::write(this -> toggle_path.c_str());
+
+    // An item of our own, in the same format, for the duration.
+    FILE * fh = fopen(this -> toggle_path.c_str(), "a");
+
+    if(fh == NULL) {
+        return false;
+    }
+
+    fprintf(fh, "C '\001page\002v_harness\001o\002gclk_cycles\001' %lu\n",
+            (unsigned long)((this -> toggle_end - this -> toggle_begin) /
+                            (2 * this -> evals_per_clock)));
+    fclose(fh);
+
+    return true;
+
+#else
+
+    return false;
+
+#endif
+
+}
+
+
+//! Current value of the core's mtimecmp register.
+uint64_t dut_wrapper::dut_mtimecmp() {
+
+    dut_counters_scope();
+
+    return frv_counters_mtimecmp();
+
+}
+
+
+//! Are mstatus.MIE and mie.MTIE both set?
+bool dut_wrapper::dut_timer_irq_enabled() {
+
+    dut_csrs_scope();
+
+    return (frv_csrs_mstatus() >> 3 & 0x1) && (frv_csrs_mie() >> 7 & 0x1);
+
+}
+
+
+//! Current value of the core's mcause register.
+uint32_t dut_wrapper::dut_mcause() {
+
+    dut_csrs_scope();
+
+    return frv_csrs_mcause();
+
+}
+
+
 void dut_wrapper::posedge_gclk () {
 
+    this -> dmem_agent -> count_stats = this -> in_roi();
+    this -> imem_agent -> count_stats = this -> in_roi();
+
     this -> dmem_agent -> posedge_clk();
     this -> imem_agent -> posedge_clk();
     this -> rng_if_agent -> posedge_clk();
+    this -> irq_if_agent -> posedge_clk();
+
+    if(this -> dut -> rvfi_valid && this -> roi_inside) {
+        this -> roi_instrs ++;
+    }
+
+    if(this -> dut -> rvfi_valid) {
+        this -> irq_if_agent -> retired (
+            this -> dut -> rvfi_intr,
+            this -> dut -> rvfi_trap,
+            this -> dut -> rvfi_insn,
+            this -> dut -> rvfi_intr ? this -> dut_mcause() : 0
+        );
+    }
+
+    if(this -> waves_start.kind != WAVE_TRIGGER_NONE ||
+       this -> waves_stop .kind != WAVE_TRIGGER_NONE) {
+
+        uint64_t now = this -> sim_time / this -> evals_per_clock;
+
+        this -> waves_update(WAVE_TRIGGER_CYCLE, this -> waves_cycle + 1, now);
+        this -> waves_cycle = now;
+
+        if(this -> dut -> trs_valid) {
+            this -> waves_update(WAVE_TRIGGER_PC, this -> dut -> trs_pc,
+                                                  this -> dut -> trs_pc);
+        }
+
+        uint8_t wmask = this -> dut -> rvfi_mem_wmask;
+
+        if(this -> dut -> rvfi_valid && wmask) {
+            uint32_t lo = this -> dut -> rvfi_mem_addr & ~0x3u;
+            uint32_t hi = lo + 3;
+            for(uint8_t m = wmask; !(m & 0x1); m >>= 1) lo ++;
+            for(uint8_t m = wmask; !(m & 0x8); m <<= 1) hi --;
+            this -> waves_update(WAVE_TRIGGER_WRITE, lo, hi);
+        }
+    }
+
+    if(this -> pipe_tracer) {
+        dut_pipeline_scope();
+        this -> pipe_tracer -> posedge (
+            this -> sim_time / (2 * this -> evals_per_clock),
+            this -> sim_time / this -> evals_per_clock,
+            this -> in_roi(),
+            frv_pipeline_progress(),
+            frv_pipeline_s1_data(),
+            this -> dut -> trs_valid,
+            this -> dut -> trs_pc
+        );
+    }
+
+    if(this -> mix && this -> dut -> trs_valid) {
+        this -> mix -> retired (
+            this -> dut -> trs_instr,
+            this -> sim_time / this -> evals_per_clock,
+            this -> in_roi()
+        );
+    }
+
+    if(this -> instr_log && this -> dut -> trs_valid && this -> in_roi()) {
+        uint32_t word = this -> dut -> trs_instr;
+        if(!instr_is_32bit(word)) {
+            word &= 0xFFFF;
+        }
+        fprintf(this -> instr_log, "%10lu %08x %08x %s\n",
+            (unsigned long)(this -> sim_time / this -> evals_per_clock),
+            this -> dut -> trs_pc, word,
+            instr_disasm(word, this -> dut -> trs_pc).c_str());
+    }
+
+    if(this -> dmem_prof) {
+        if(this -> dut -> dmem_req && this -> dut -> dmem_gnt &&
+           this -> in_roi()) {
+            this -> dmem_prof -> access (
+                this -> dut -> dmem_addr,
+                this -> dut -> dmem_wen,
+                this -> dut -> dmem_strb,
+                this -> sim_time / this -> evals_per_clock
+            );
+        }
+        if(this -> dut -> rvfi_valid && this -> dut -> rvfi_rd_addr == 2) {
+            this -> dmem_prof -> sp_written (
+                this -> dut -> rvfi_rd_wdata,
+                this -> in_roi()
+            );
+        }
+    }
+
+    if(this -> ct && this -> dut -> rvfi_valid) {
+        this -> ct -> retired (
+            this -> dut -> rvfi_pc_rdata,
+            this -> dut -> rvfi_insn,
+            this -> sim_time / this -> evals_per_clock,
+            this -> dut -> rvfi_mem_rmask,
+            this -> dut -> rvfi_mem_wmask,
+            this -> dut -> rvfi_mem_addr,
+            this -> in_roi()
+        );
+    }
 
     // Do we need to capture a trace item?
     if(this -> dut -> trs_valid) {
@@ -145,11 +618,35 @@ void dut_wrapper::posedge_gclk () {
             }
         );
     }
+
+    if(this -> checker && this -> dut -> rvfi_valid) {
+        this -> checker -> push (
+            {
+                this -> dut -> rvfi_order     ,
+                this -> dut -> rvfi_insn      ,
+                this -> dut -> rvfi_trap      ,
+                this -> dut -> rvfi_intr      ,
+                this -> dut -> rvfi_rd_addr   ,
+                this -> dut -> rvfi_rd_wide   ,
+                this -> dut -> rvfi_rd_wdata  ,
+                this -> dut -> rvfi_rd_wdatahi,
+                this -> dut -> rvfi_pc_rdata  ,
+                this -> dut -> rvfi_pc_wdata  ,
+                this -> dut -> rvfi_mem_addr  ,
+                this -> dut -> rvfi_mem_rmask ,
+                this -> dut -> rvfi_mem_wmask ,
+                this -> dut -> rvfi_mem_rdata ,
+                this -> dut -> rvfi_mem_wdata ,
+                this -> dut -> rvfi_rng_data  ,
+                this -> dut -> rvfi_rng_stat
+            }
+        );
+    }
 }
 
 
 bool dut_wrapper::rand_chance(int x, int y) {
-    return (rand() % y) < x;
+    return (int)(tb_rand() % y) < x;
 }
 
 
@@ -163,3 +660,50 @@ bool dut_wrapper::rand_set_uint8(int x, int y, vluint8_t * d) {
     }
 }
 
+
+//! Start or stop dumping waves if a trigger fires on a value in [lo, hi].
+void dut_wrapper::waves_update (
+    dut_wave_trigger_kind_t kind,
+    uint64_t                lo  ,
+    uint64_t                hi
+) {
+
+    if(this -> waves_stopped) {
+        return;
+    }
+
+    dut_wave_trigger_t & trigger = this -> waves_active ? this -> waves_stop
+                                                        : this -> waves_start;
+
+    if(trigger.kind == kind && trigger.value >= lo && trigger.value <= hi) {
+        this -> waves_stopped = this -> waves_active;
+        this -> waves_active  = !this -> waves_active;
+    }
+
+}
+
+
+//! The program wrote value to the MARKER register of the exit device.
+void dut_wrapper::marker_written(uint32_t value) {
+
+    if(value == DUT_MARKER_ROI_BEGIN && !this -> roi_inside) {
+        this -> roi_inside  = true;
+        this -> roi_begin   = this -> sim_time;
+        this -> roi_entries ++;
+        if(this -> roi_enable && this -> roi_entries == 1 &&
+           this -> toggle_path != "") {
+            this -> toggle_start();
+        }
+    } else if(value == DUT_MARKER_ROI_END && this -> roi_inside) {
+        this -> roi_inside  = false;
+        this -> roi_ticks  += this -> sim_time - this -> roi_begin;
+        if(this -> roi_enable && this -> toggle_path != "") {
+            // Toggles are counted on after the ROI, so write them now.
+            this -> toggle_end     = this -> sim_time;
+            this -> toggle_written = this -> toggle_write();
+        }
+    }
+
+    this -> waves_update(WAVE_TRIGGER_MARKER, value, value);
+
+}
@@ -1,19 +1,87 @@
 
+#include <cstdio>
 #include <queue>
 #include <vector>
 
 #include "verilated.h"
+#include "verilated_save.h"
+
+// Set by the verilated makefile, for a model built with --trace-fst.
+#ifndef VM_TRACE_FST
+#define VM_TRACE_FST 0
+#endif
+
+#if VM_TRACE_FST
+#include "verilated_fst_c.h"
+#else
 #include "verilated_vcd_c.h"
+#endif
+
+// Set by the verilated makefile, for a model built with --coverage-toggle.
+#ifndef VM_COVERAGE
+#define VM_COVERAGE 0
+#endif
+
+#if VM_COVERAGE
+#include "verilated_cov.h"
+#endif
 
 #include "Vfrv_core.h"
 
 #include "memory_device.hpp"
 #include "sram_agent.hpp"
 #include "rng_agent.hpp"
+#include "irq_agent.hpp"
+#include "cosim.hpp"
+#include "pipe_trace.hpp"
+#include "instr_mix.hpp"
+#include "dmem_profile.hpp"
+#include "ct_trace.hpp"
 
 #ifndef DUT_WRAPPER_HPP
 #define DUT_WRAPPER_HPP
 
+/*!
+@brief Wave file writer. Verilator builds a model for one format only,
+    chosen by VL_TRACE_FORMAT in flow/verilator/Makefile.in.
+*/
+#if VM_TRACE_FST
+typedef VerilatedFstC dut_wave_file_t;
+#else
+typedef VerilatedVcdC dut_wave_file_t;
+#endif
+
+//! What starts or stops the dumping of waves.
+typedef enum dut_wave_trigger_kind {
+    WAVE_TRIGGER_NONE   = 0, //!< Never fires.
+    WAVE_TRIGGER_CYCLE  = 1, //!< Reaching a simulation cycle.
+    WAVE_TRIGGER_PC     = 2, //!< Tracing out an instruction address.
+    WAVE_TRIGGER_WRITE  = 3, //!< Retiring a store to an address.
+    WAVE_TRIGGER_MARKER = 4  //!< Writing a value to the exit device's
+                             //   MARKER register.
+} dut_wave_trigger_kind_t;
+
+//! One wave start or stop condition.
+typedef struct dut_wave_trigger {
+    dut_wave_trigger_kind_t kind  = WAVE_TRIGGER_NONE;
+    uint64_t                value = 0;
+} dut_wave_trigger_t;
+
+/*!
+@brief Parse a wave trigger: cycle:<N>, pc:<addr>, write:<addr> or
+    marker:<N>. Numbers may be given in hex with a 0x prefix.
+@returns false if spec is none of these.
+*/
+bool dut_wave_trigger_parse(std::string spec, dut_wave_trigger_t & trigger);
+
+//! Value a program writes to the MARKER register to begin its region of
+//  interest ("ROIB"). See __roi_begin in verif/unit/share/util.S.
+#define DUT_MARKER_ROI_BEGIN 0x524F4942
+
+//! Value a program writes to the MARKER register to end its region of
+//  interest ("ROIE").
+#define DUT_MARKER_ROI_END   0x524F4945
+
 //! A trace packet emitted by the core post-writeback.
 typedef struct dut_trace_pkt {
     uint32_t program_counter;
@@ -35,13 +103,22 @@ public:
     @brief Create a new dut_wrapper object
     @param in ctx - Pointer to a memory context obejct.
     @param in dump_waves - If true, write wave file.
+    @param in waves_depth - Levels of hierarchy to dump below the top.
+    @param in waves_scope - If set, a comma separated list of the scopes
+        (e.g. TOP.frv_core.i_pipeline) to dump. Everything else is left
+        out.
     */
     dut_wrapper (
         memory_bus    * mem         ,
         bool            dump_waves  ,
-        std::string     wavefile
+        std::string     wavefile    ,
+        int             waves_depth = 99,
+        std::string     waves_scope = ""
     );
 
+    //! Free the model, agents and wave file handle.
+    ~dut_wrapper();
+
     
     //! Put the dut in reset.
     void dut_set_reset();
@@ -49,20 +126,147 @@ public:
     //! Take the DUT out of reset.
     void dut_clear_reset();
 
+    /*!
+    @brief Prepare an already used model for a new run.
+    @details Zeros the simulation time, empties the trace queue, re-arms
+        the wave triggers, leaves the region of interest and re-opens the
+        wave file. The model itself is put back into reset
+        by the following dut_set_reset() / dut_step_clk() calls.
+    */
+    void dut_restart();
+
+    /*!
+    @brief Write the model, agents, trace queue, PRNG, simulation time,
+        wave trigger and region of interest state to a checkpoint.
+    @details Needs a model verilated with --savable.
+    */
+    void save_state (VerilatedSerialize & os);
+
+    /*!
+    @brief Restore everything written by save_state.
+    @details The model must have been verilated from the same RTL with the
+        same parameters as the one which was saved.
+    */
+    void restore_state (VerilatedDeserialize & is);
+
     //! Simulate the DUT for a single clock cycle
     void dut_step_clk();
+
+    /*!
+    @brief Simulate one period of g_clk (two calls to dut_step_clk()),
+        which advances mtime and the cycle counter by 1 + cycles, and the
+        simulation time by as many periods.
+    @details Used to skip over cycles in which the core is idle. Needs the
+        DPI hooks in frv_counters.
+    */
+    void dut_skip_clk(uint64_t cycles);
+
+    //! Current value of the core's mtime register.
+    uint64_t dut_mtime();
+
+    //! Current value of the core's mtimecmp register.
+    uint64_t dut_mtimecmp();
+
+    //! Are mstatus.MIE and mie.MTIE both set? Needs the frv_csrs hooks.
+    bool dut_timer_irq_enabled();
+
+    //! Current value of the core's mcause register.
+    uint32_t dut_mcause();
     
     //! Return the number of simulation ticks so far.
     uint64_t get_sim_time() {
         return this -> sim_time;
     }
     
-    //! Handle to the VCD file for dumping waveforms.
-    VerilatedVcdC* trace_fh;
+    //! Handle to the VCD or FST file for dumping waveforms.
+    dut_wave_file_t* trace_fh;
     
     //! Trace of post-writeback PC and instructions.
     std::queue<dut_trace_pkt_t> dut_trace;
 
+    //! Interrupt agent. Raises nothing unless given a schedule.
+    irq_agent  * irq_if_agent;
+
+    //! If not NULL, every RVFI packet is pushed to this checker.
+    cosim      * checker = NULL;
+
+    //! If not NULL, pipeline occupancy is traced to this.
+    pipe_trace * pipe_tracer = NULL;
+
+    //! If not NULL, retired instructions are counted by this.
+    instr_mix  * mix = NULL;
+
+    //! If not NULL, retired instructions are disassembled to this.
+    FILE       * instr_log = NULL;
+
+    //! If not NULL, data memory accesses are profiled by this.
+    dmem_profile * dmem_prof = NULL;
+
+    //! If not NULL, retired instructions are traced to this.
+    ct_trace   * ct = NULL;
+
+    /*!
+    @brief If set, write the toggle counts of each signal here, for a
+        model built with VL_TOGGLE=1. They cover the run from
+        toggle_start(), or with roi_enable from the first ROI begin to
+        the last ROI end, including any gaps between ROIs.
+    */
+    std::string  toggle_path    = "";
+
+    //! Start counting toggles from zero, now.
+    void toggle_start();
+
+    /*!
+    @brief Write the toggle counts to toggle_path, with the g_clk cycles
+        they cover, if the run has covered any.
+    @details The cycles are written as the gclk_cycles item, in whole
+        g_clk periods: half the sim_time / 10 counts the rest of the
+        harness reports, which are in half periods.
+    @returns false if the model does not count toggles, roi_enable is set
+        but no ROI was entered, or the file could not be written.
+    */
+    bool toggle_finish();
+
+    //! Start dumping waves once this fires. None: from reset.
+    dut_wave_trigger_t waves_start;
+
+    //! Stop dumping waves once this fires, for good. None: never.
+    dut_wave_trigger_t waves_stop;
+
+    /*!
+    @brief The program wrote value to the MARKER register of the exit
+        device: a wave trigger, or the beginning or end of its region of
+        interest.
+    */
+    void marker_written(uint32_t value);
+
+    /*!
+    @brief If set, waves and statistics only cover the program's region
+        of interest, between DUT_MARKER_ROI_BEGIN and DUT_MARKER_ROI_END.
+        Nothing is covered if the program never marks one.
+    */
+    bool         roi_enable     = false;
+
+    //! Should waves and statistics cover the current cycle?
+    bool in_roi() {
+        return !this -> roi_enable || this -> roi_inside;
+    }
+
+    //! Times the program has begun its region of interest since reset.
+    uint64_t     roi_entries    = 0;
+
+    //! Instructions retired inside the region of interest.
+    uint64_t     roi_instrs     = 0;
+
+    //! Simulation cycles spent inside the region of interest.
+    uint64_t roi_cycles() {
+        uint64_t ticks = this -> roi_ticks;
+        if(this -> roi_inside) {
+            ticks += this -> sim_time - this -> roi_begin;
+        }
+        return ticks / this -> evals_per_clock;
+    }
+
     void set_imem_max_stall (uint32_t stall) {
         imem_agent -> max_req_stall = stall;
         imem_agent -> max_rsp_stall = stall;
@@ -72,11 +276,31 @@ public:
         dmem_agent -> max_rsp_stall = stall;
     }
 
+    //! Print the traffic counted on the imem and dmem ports.
+    void mem_stats_report (std::ostream & os);
+
+    /*!
+    @brief Write the traffic counted on each port as JSON: {"imem": {...},
+        "dmem": {...}}. See sram_agent::write_json.
+    @returns false if the file could not be written.
+    */
+    bool mem_stats_json (std::string path);
+
 protected:
     
     //! Set of available memories. Fed to memory agents.
     memory_bus   * mem;
 
+    //! sim_time toggles were counted from, and to.
+    uint64_t       toggle_begin = 0;
+    uint64_t       toggle_end   = 0;
+
+    //! Did writing the toggle counts at the last ROI end succeed?
+    bool           toggle_written = false;
+
+    //! Write the toggle counts from toggle_begin to toggle_end.
+    bool toggle_write();
+
     //! Instruction memory SRAM agent
     sram_agent * imem_agent;
 
@@ -98,6 +322,30 @@ protected:
     //! Called on every rising edge of the main clock.
     void posedge_gclk();
 
+    //! Set while waves are being dumped, between the triggers.
+    bool     waves_active = true;
+
+    //! Set once waves_stop has fired.
+    bool     waves_stopped= false;
+
+    //! Simulation cycle at which the cycle triggers were last checked.
+    uint64_t waves_cycle  = 0;
+
+    //! Set between the ROI begin and end markers.
+    bool     roi_inside   = false;
+
+    //! Simulation time at which the region of interest last began.
+    uint64_t roi_begin    = 0;
+
+    //! Simulation time spent in earlier passes of the region of interest.
+    uint64_t roi_ticks    = 0;
+
+    /*!
+    @brief Start or stop dumping waves if the trigger of that kind fires
+        on a value in [lo, hi].
+    */
+    void waves_update(dut_wave_trigger_kind_t kind, uint64_t lo, uint64_t hi);
+
     /*!
     @brief Return a random boolean sample with an x in y chance of being
         true.
@@ -0,0 +1,124 @@
+
+#include <fstream>
+#include <iterator>
+
+#include "elf.hpp"
+
+//! Section types.
+#define ELF_SHT_SYMTAB      2
+#define ELF_SHT_NOBITS      8
+
+//! Little endian field of width bytes at offset.
+static uint32_t elf_field(std::vector<uint8_t> const & f, size_t offset,
+                          int width) {
+    uint32_t v = 0;
+    for(int i = width - 1; i >= 0; i --) {
+        v = v << 8 | f[offset + i];
+    }
+    return v;
+}
+
+//! The NUL terminated string at offset in a string table section.
+static std::string elf_string(elf_section_t const & strtab, uint32_t offset) {
+    std::string s;
+    for(uint32_t c = offset; c < strtab.data.size() && strtab.data[c]; c++) {
+        s += (char)strtab.data[c];
+    }
+    return s;
+}
+
+
+//! Open and parse the ELF file at path.
+elf_file::elf_file(std::string path) {
+
+    std::ifstream fh(path, std::ios::binary);
+
+    if(!fh.is_open()) {
+        this -> error = "could not open " + path;
+        return;
+    }
+
+    std::vector<uint8_t> f((std::istreambuf_iterator<char>(fh)),
+                            std::istreambuf_iterator<char>());
+
+    // 32-bit (class 1), little endian (data 1).
+    if(f.size() < 52 || f[0] != 0x7F || f[1] != 'E' || f[2] != 'L' ||
+       f[3] != 'F' || f[4] != 1 || f[5] != 1) {
+        this -> error = path + " is not a 32-bit little endian ELF file";
+        return;
+    }
+
+    uint32_t shoff     = elf_field(f, 32, 4);
+    uint32_t shentsize = elf_field(f, 46, 2);
+    uint32_t shnum     = elf_field(f, 48, 2);
+    uint32_t shstrndx  = elf_field(f, 50, 2);
+
+    if(shentsize < 40 || shstrndx >= shnum ||
+       (uint64_t)shoff + (uint64_t)shnum * shentsize > f.size()) {
+        this -> error = path + " has bad section headers";
+        return;
+    }
+
+    std::vector<uint32_t> name_offsets;
+    uint32_t              symtab = 0;
+    uint32_t              strtab = 0;
+
+    for(uint32_t i = 0; i < shnum; i ++) {
+
+        size_t        h = shoff + i * shentsize;
+        elf_section_t s;
+
+        name_offsets.push_back(elf_field(f, h, 4));
+
+        s.flags  = elf_field(f, h +  8, 4);
+        s.addr   = elf_field(f, h + 12, 4);
+        s.size   = elf_field(f, h + 20, 4);
+        s.nobits = elf_field(f, h +  4, 4) == ELF_SHT_NOBITS;
+
+        uint32_t offset = elf_field(f, h + 16, 4);
+
+        if(elf_field(f, h + 4, 4) == ELF_SHT_SYMTAB) {
+            symtab = i;
+            strtab = elf_field(f, h + 24, 4);
+        }
+
+        if(!s.nobits && i != 0) {
+            if((uint64_t)offset + s.size > f.size()) {
+                this -> error = path + " has a section past its end";
+                return;
+            }
+            s.data.assign(f.begin() + offset, f.begin() + offset + s.size);
+        }
+
+        this -> sections.push_back(s);
+    }
+
+    // Names are offsets into the section holding them.
+    for(uint32_t i = 0; i < shnum; i ++) {
+        this -> sections[i].name = elf_string(this -> sections[shstrndx],
+                                              name_offsets[i]);
+    }
+
+    if(symtab && strtab < shnum) {
+
+        std::vector<uint8_t> const & t = this -> sections[symtab].data;
+
+        // Entry 0 is the undefined symbol.
+        for(size_t e = 16; e + 16 <= t.size(); e += 16) {
+
+            elf_symbol_t s;
+
+            s.name = elf_string(this -> sections[strtab], elf_field(t, e, 4));
+            s.addr = elf_field(t, e +  4, 4);
+            s.size = elf_field(t, e +  8, 4);
+            s.type = t[e + 12] & 0xF;
+
+            if(s.name != "") {
+                this -> symbols.push_back(s);
+            }
+        }
+    }
+
+    this -> ok = true;
+
+}
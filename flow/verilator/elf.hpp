@@ -0,0 +1,66 @@
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifndef ELF_HPP
+#define ELF_HPP
+
+//! One section of an ELF file.
+typedef struct elf_section {
+    std::string             name    ;
+    uint32_t                addr    ; //!< Address it is loaded at.
+    uint32_t                size    ;
+    uint32_t                flags   ; //!< SHF_* flags.
+    bool                    nobits  ; //!< .bss like: takes no file space.
+    std::vector<uint8_t>    data    ; //!< Contents, unless nobits.
+} elf_section_t;
+
+//! One entry of an ELF file's symbol table.
+typedef struct elf_symbol {
+    std::string             name    ;
+    uint32_t                addr    ;
+    uint32_t                size    ;
+    uint8_t                 type    ; //!< STT_* type.
+} elf_symbol_t;
+
+//! Symbol types.
+#define ELF_STT_OBJECT      1
+#define ELF_STT_FUNC        2
+
+//! Section flags.
+#define ELF_SHF_WRITE       0x1
+#define ELF_SHF_ALLOC       0x2
+#define ELF_SHF_EXECINSTR   0x4
+
+/*!
+@brief The sections and symbols of a 32-bit little endian ELF file, as the
+    linker puts out for the core.
+*/
+class elf_file {
+
+public:
+
+    /*!
+    @brief Open and parse the ELF file at path.
+    @details Check ok afterwards. Only the section headers, their contents
+        and the symbol table are read: relocations and program headers are
+        ignored.
+    */
+    elf_file(std::string path);
+
+    //! Was the file read and understood?
+    bool                        ok      = false;
+
+    //! Why not, if it was not.
+    std::string                 error   ;
+
+    //! Every section, in file order. Index 0 is the null section.
+    std::vector<elf_section_t>  sections;
+
+    //! Named symbols of the symbol table, if it has one.
+    std::vector<elf_symbol_t>   symbols ;
+
+};
+
+#endif
@@ -0,0 +1,206 @@
+
+#include "instr_decode.hpp"
+
+//! Names of each instr_class_t.
+static const char * instr_class_names[INSTR_NUM_CLASSES] = {
+    "RV32I",
+    "RV32M",
+    "RV32C",
+    "BITMANIP",
+    "XC_CLASS_BASELINE",
+    "XC_CLASS_RANDOMNESS",
+    "XC_CLASS_MEMORY",
+    "XC_CLASS_BIT",
+    "XC_CLASS_PACKED",
+    "XC_CLASS_MULTIARITH",
+    "XC_CLASS_AES",
+    "XC_CLASS_SHA2",
+    "XC_CLASS_SHA3",
+    "XC_CLASS_LEAK",
+    "unknown"
+};
+
+
+//! Name of an instruction class.
+const char * instr_class_name(instr_class_t c) {
+    return instr_class_names[c < INSTR_NUM_CLASSES ? c : INSTR_CLASS_UNKNOWN];
+}
+
+
+/*
+Every instruction the core decodes, from frv_pipeline_decode.vh. The first
+entry which matches is taken, so encodings which are special cases of
+others (c.nop of c.addi, c.jr of c.mv, ...) come first. Reserved encodings
+(e.g. c.addi4spn with a zero immediate) are not told apart from the
+instructions they alias.
+*/
+const instr_encoding_t instr_encodings[] = {
+    {"lui"              , 0x0000007f, 0x00000037, INSTR_CLASS_RV32I, "d,u"     },
+    {"auipc"            , 0x0000007f, 0x00000017, INSTR_CLASS_RV32I, "d,u"     },
+    {"jal"              , 0x0000007f, 0x0000006f, INSTR_CLASS_RV32I, "d,a"     },
+    {"jalr"             , 0x0000707f, 0x00000067, INSTR_CLASS_RV32I, "d,o"     },
+    {"beq"              , 0x0000707f, 0x00000063, INSTR_CLASS_RV32I, "s,t,b"   },
+    {"bne"              , 0x0000707f, 0x00001063, INSTR_CLASS_RV32I, "s,t,b"   },
+    {"blt"              , 0x0000707f, 0x00004063, INSTR_CLASS_RV32I, "s,t,b"   },
+    {"bge"              , 0x0000707f, 0x00005063, INSTR_CLASS_RV32I, "s,t,b"   },
+    {"bltu"             , 0x0000707f, 0x00006063, INSTR_CLASS_RV32I, "s,t,b"   },
+    {"bgeu"             , 0x0000707f, 0x00007063, INSTR_CLASS_RV32I, "s,t,b"   },
+    {"lb"               , 0x0000707f, 0x00000003, INSTR_CLASS_RV32I, "d,o"     },
+    {"lh"               , 0x0000707f, 0x00001003, INSTR_CLASS_RV32I, "d,o"     },
+    {"lw"               , 0x0000707f, 0x00002003, INSTR_CLASS_RV32I, "d,o"     },
+    {"lbu"              , 0x0000707f, 0x00004003, INSTR_CLASS_RV32I, "d,o"     },
+    {"lhu"              , 0x0000707f, 0x00005003, INSTR_CLASS_RV32I, "d,o"     },
+    {"sb"               , 0x0000707f, 0x00000023, INSTR_CLASS_RV32I, "t,q"     },
+    {"sh"               , 0x0000707f, 0x00001023, INSTR_CLASS_RV32I, "t,q"     },
+    {"sw"               , 0x0000707f, 0x00002023, INSTR_CLASS_RV32I, "t,q"     },
+    {"addi"             , 0x0000707f, 0x00000013, INSTR_CLASS_RV32I, "d,s,i"   },
+    {"slti"             , 0x0000707f, 0x00002013, INSTR_CLASS_RV32I, "d,s,i"   },
+    {"sltiu"            , 0x0000707f, 0x00003013, INSTR_CLASS_RV32I, "d,s,i"   },
+    {"xori"             , 0x0000707f, 0x00004013, INSTR_CLASS_RV32I, "d,s,i"   },
+    {"ori"              , 0x0000707f, 0x00006013, INSTR_CLASS_RV32I, "d,s,i"   },
+    {"andi"             , 0x0000707f, 0x00007013, INSTR_CLASS_RV32I, "d,s,i"   },
+    {"slli"             , 0xfe00707f, 0x00001013, INSTR_CLASS_RV32I, "d,s,>"   },
+    {"srli"             , 0xfe00707f, 0x00005013, INSTR_CLASS_RV32I, "d,s,>"   },
+    {"srai"             , 0xfe00707f, 0x40005013, INSTR_CLASS_RV32I, "d,s,>"   },
+    {"add"              , 0xfe00707f, 0x00000033, INSTR_CLASS_RV32I, "d,s,t"   },
+    {"sub"              , 0xfe00707f, 0x40000033, INSTR_CLASS_RV32I, "d,s,t"   },
+    {"sll"              , 0xfe00707f, 0x00001033, INSTR_CLASS_RV32I, "d,s,t"   },
+    {"slt"              , 0xfe00707f, 0x00002033, INSTR_CLASS_RV32I, "d,s,t"   },
+    {"sltu"             , 0xfe00707f, 0x00003033, INSTR_CLASS_RV32I, "d,s,t"   },
+    {"xor"              , 0xfe00707f, 0x00004033, INSTR_CLASS_RV32I, "d,s,t"   },
+    {"srl"              , 0xfe00707f, 0x00005033, INSTR_CLASS_RV32I, "d,s,t"   },
+    {"sra"              , 0xfe00707f, 0x40005033, INSTR_CLASS_RV32I, "d,s,t"   },
+    {"or"               , 0xfe00707f, 0x00006033, INSTR_CLASS_RV32I, "d,s,t"   },
+    {"and"              , 0xfe00707f, 0x00007033, INSTR_CLASS_RV32I, "d,s,t"   },
+    {"fence"            , 0x0000707f, 0x0000000f, INSTR_CLASS_RV32I, ""        },
+    {"fence.i"          , 0x0000707f, 0x0000100f, INSTR_CLASS_RV32I, ""        },
+    {"ecall"            , 0xffffffff, 0x00000073, INSTR_CLASS_RV32I, ""        },
+    {"ebreak"           , 0xffffffff, 0x00100073, INSTR_CLASS_RV32I, ""        },
+    {"mret"             , 0xffffffff, 0x30200073, INSTR_CLASS_RV32I, ""        },
+    {"wfi"              , 0xffffffff, 0x10500073, INSTR_CLASS_RV32I, ""        },
+    {"csrrw"            , 0x0000707f, 0x00001073, INSTR_CLASS_RV32I, "d,c,s"   },
+    {"csrrs"            , 0x0000707f, 0x00002073, INSTR_CLASS_RV32I, "d,c,s"   },
+    {"csrrc"            , 0x0000707f, 0x00003073, INSTR_CLASS_RV32I, "d,c,s"   },
+    {"csrrwi"           , 0x0000707f, 0x00005073, INSTR_CLASS_RV32I, "d,c,Z"   },
+    {"csrrsi"           , 0x0000707f, 0x00006073, INSTR_CLASS_RV32I, "d,c,Z"   },
+    {"csrrci"           , 0x0000707f, 0x00007073, INSTR_CLASS_RV32I, "d,c,Z"   },
+    {"mul"              , 0xfe00707f, 0x02000033, INSTR_CLASS_RV32M, "d,s,t"   },
+    {"mulh"             , 0xfe00707f, 0x02001033, INSTR_CLASS_RV32M, "d,s,t"   },
+    {"mulhsu"           , 0xfe00707f, 0x02002033, INSTR_CLASS_RV32M, "d,s,t"   },
+    {"mulhu"            , 0xfe00707f, 0x02003033, INSTR_CLASS_RV32M, "d,s,t"   },
+    {"div"              , 0xfe00707f, 0x02004033, INSTR_CLASS_RV32M, "d,s,t"   },
+    {"divu"             , 0xfe00707f, 0x02005033, INSTR_CLASS_RV32M, "d,s,t"   },
+    {"rem"              , 0xfe00707f, 0x02006033, INSTR_CLASS_RV32M, "d,s,t"   },
+    {"remu"             , 0xfe00707f, 0x02007033, INSTR_CLASS_RV32M, "d,s,t"   },
+    {"c.addi4spn"       , 0x0000e003, 0x00000000, INSTR_CLASS_RV32C, "D,g"     },
+    {"c.lw"             , 0x0000e003, 0x00004000, INSTR_CLASS_RV32C, "D,m"     },
+    {"c.sw"             , 0x0000e003, 0x0000c000, INSTR_CLASS_RV32C, "D,m"     },
+    {"c.nop"            , 0x0000ffff, 0x00000001, INSTR_CLASS_RV32C, ""        },
+    {"c.addi"           , 0x0000e003, 0x00000001, INSTR_CLASS_RV32C, "e,j"     },
+    {"c.jal"            , 0x0000e003, 0x00002001, INSTR_CLASS_RV32C, "J"       },
+    {"c.li"             , 0x0000e003, 0x00004001, INSTR_CLASS_RV32C, "e,j"     },
+    {"c.addi16sp"       , 0x0000ef83, 0x00006101, INSTR_CLASS_RV32C, "h"       },
+    {"c.lui"            , 0x0000e003, 0x00006001, INSTR_CLASS_RV32C, "e,k"     },
+    {"c.srli"           , 0x0000fc03, 0x00008001, INSTR_CLASS_RV32C, "S,l"     },
+    {"c.srai"           , 0x0000fc03, 0x00008401, INSTR_CLASS_RV32C, "S,l"     },
+    {"c.andi"           , 0x0000ec03, 0x00008801, INSTR_CLASS_RV32C, "S,j"     },
+    {"c.sub"            , 0x0000fc63, 0x00008c01, INSTR_CLASS_RV32C, "S,D"     },
+    {"c.xor"            , 0x0000fc63, 0x00008c21, INSTR_CLASS_RV32C, "S,D"     },
+    {"c.or"             , 0x0000fc63, 0x00008c41, INSTR_CLASS_RV32C, "S,D"     },
+    {"c.and"            , 0x0000fc63, 0x00008c61, INSTR_CLASS_RV32C, "S,D"     },
+    {"c.j"              , 0x0000e003, 0x0000a001, INSTR_CLASS_RV32C, "J"       },
+    {"c.beqz"           , 0x0000e003, 0x0000c001, INSTR_CLASS_RV32C, "S,B"     },
+    {"c.bnez"           , 0x0000e003, 0x0000e001, INSTR_CLASS_RV32C, "S,B"     },
+    {"c.slli"           , 0x0000f003, 0x00000002, INSTR_CLASS_RV32C, "e,l"     },
+    {"c.lwsp"           , 0x0000e003, 0x00004002, INSTR_CLASS_RV32C, "e,n"     },
+    {"c.jr"             , 0x0000f07f, 0x00008002, INSTR_CLASS_RV32C, "e"       },
+    {"c.mv"             , 0x0000f003, 0x00008002, INSTR_CLASS_RV32C, "e,f"     },
+    {"c.ebreak"         , 0x0000ffff, 0x00009002, INSTR_CLASS_RV32C, ""        },
+    {"c.jalr"           , 0x0000f07f, 0x00009002, INSTR_CLASS_RV32C, "e"       },
+    {"c.add"            , 0x0000f003, 0x00009002, INSTR_CLASS_RV32C, "e,f"     },
+    {"c.swsp"           , 0x0000e003, 0x0000c002, INSTR_CLASS_RV32C, "f,p"     },
+    {"xc.ldr.b"         , 0xfe00707f, 0x00007003, INSTR_CLASS_XC_BASELINE, "d,s,t"   },
+    {"xc.ldr.h"         , 0xfe00707f, 0x02007003, INSTR_CLASS_XC_BASELINE, "d,s,t"   },
+    {"xc.ldr.w"         , 0xfe00707f, 0x04007003, INSTR_CLASS_XC_BASELINE, "d,s,t"   },
+    {"xc.ldr.bu"        , 0xfe00707f, 0x08007003, INSTR_CLASS_XC_BASELINE, "d,s,t"   },
+    {"xc.ldr.hu"        , 0xfe00707f, 0x0a007003, INSTR_CLASS_XC_BASELINE, "d,s,t"   },
+    {"xc.str.b"         , 0x06007fff, 0x00004023, INSTR_CLASS_XC_BASELINE, "r,s,t"   },
+    {"xc.str.h"         , 0x06007fff, 0x000040a3, INSTR_CLASS_XC_BASELINE, "r,s,t"   },
+    {"xc.str.w"         , 0x06007fff, 0x00004123, INSTR_CLASS_XC_BASELINE, "r,s,t"   },
+    {"xc.mmul.3"        , 0x060070ff, 0x04004023, INSTR_CLASS_XC_MULTIARITH, "d,s,t,r" },
+    {"xc.macc.1"        , 0x060070ff, 0x040040a3, INSTR_CLASS_XC_MULTIARITH, "d,s,t,r" },
+    {"xc.madd.3"        , 0x060070ff, 0x06004023, INSTR_CLASS_XC_MULTIARITH, "d,s,t,r" },
+    {"xc.msub.3"        , 0x060070ff, 0x060050a3, INSTR_CLASS_XC_MULTIARITH, "d,s,t,r" },
+    {"xc.mror"          , 0x060070ff, 0x00005023, INSTR_CLASS_XC_MULTIARITH, "d,s,t,r" },
+    {"xc.lkgfence"      , 0xffffffff, 0x00308073, INSTR_CLASS_XC_LEAK, ""        },
+    {"xc.rngtest"       , 0xfffff07f, 0x00300073, INSTR_CLASS_XC_RANDOMNESS, "d"       },
+    {"xc.rngsamp"       , 0xfffff07f, 0x00500073, INSTR_CLASS_XC_RANDOMNESS, "d"       },
+    {"xc.rngseed"       , 0xfff07fff, 0x00700073, INSTR_CLASS_XC_RANDOMNESS, "s"       },
+    {"xc.lut"           , 0xfe00707f, 0x62006033, INSTR_CLASS_XC_BIT, "d,s,t"   },
+    {"xc.bop"           , 0x7e00707f, 0x64006033, INSTR_CLASS_XC_BIT, "d,s,t"   },
+    {"xc.padd"          , 0x3e00707f, 0x02000073, INSTR_CLASS_XC_PACKED, "P,d,s,t" },
+    {"xc.psub"          , 0x3e00707f, 0x04000073, INSTR_CLASS_XC_PACKED, "P,d,s,t" },
+    {"xc.pror"          , 0x3e00707f, 0x06000073, INSTR_CLASS_XC_PACKED, "P,d,s,t" },
+    {"xc.psll"          , 0x3e00707f, 0x08000073, INSTR_CLASS_XC_PACKED, "P,d,s,t" },
+    {"xc.psrl"          , 0x3e00707f, 0x0a000073, INSTR_CLASS_XC_PACKED, "P,d,s,t" },
+    {"xc.pror.i"        , 0x3c00707f, 0x30007003, INSTR_CLASS_XC_PACKED, "P,d,s,>" },
+    {"xc.psll.i"        , 0x3c00707f, 0x2c007003, INSTR_CLASS_XC_PACKED, "P,d,s,>" },
+    {"xc.psrl.i"        , 0x3c00707f, 0x28007003, INSTR_CLASS_XC_PACKED, "P,d,s,>" },
+    {"xc.pmul.l"        , 0x3e00707f, 0x0c000073, INSTR_CLASS_XC_PACKED, "P,d,s,t" },
+    {"xc.pmul.h"        , 0x3e00707f, 0x0e000073, INSTR_CLASS_XC_PACKED, "P,d,s,t" },
+    {"xc.pclmul.l"      , 0x3e00707f, 0x10000033, INSTR_CLASS_XC_PACKED, "P,d,s,t" },
+    {"xc.pclmul.h"      , 0x3e00707f, 0x12000033, INSTR_CLASS_XC_PACKED, "P,d,s,t" },
+    {"xc.scatter.b"     , 0x06007fff, 0x00004223, INSTR_CLASS_XC_MEMORY, "r,s,t"   },
+    {"xc.scatter.h"     , 0x06007fff, 0x000042a3, INSTR_CLASS_XC_MEMORY, "r,s,t"   },
+    {"xc.gather.b"      , 0xfe00707f, 0x3c001013, INSTR_CLASS_XC_MEMORY, "d,s,t"   },
+    {"xc.gather.h"      , 0xfe00707f, 0x3e001013, INSTR_CLASS_XC_MEMORY, "d,s,t"   },
+    {"xc.aessub.enc"    , 0xfe00707f, 0x1a007003, INSTR_CLASS_XC_AES, "d,s,t"   },
+    {"xc.aessub.encrot" , 0xfe00707f, 0x1c007003, INSTR_CLASS_XC_AES, "d,s,t"   },
+    {"xc.aessub.dec"    , 0xfe00707f, 0x1e007003, INSTR_CLASS_XC_AES, "d,s,t"   },
+    {"xc.aessub.decrot" , 0xfe00707f, 0x20007003, INSTR_CLASS_XC_AES, "d,s,t"   },
+    {"xc.aesmix.enc"    , 0xfe00707f, 0x22007003, INSTR_CLASS_XC_AES, "d,s,t"   },
+    {"xc.aesmix.dec"    , 0xfe00707f, 0x24007003, INSTR_CLASS_XC_AES, "d,s,t"   },
+    {"xc.sha3.xy"       , 0x3e00707f, 0x10007003, INSTR_CLASS_XC_SHA3, "d,s,t,3" },
+    {"xc.sha3.x1"       , 0x3e00707f, 0x12007003, INSTR_CLASS_XC_SHA3, "d,s,t,3" },
+    {"xc.sha3.x2"       , 0x3e00707f, 0x14007003, INSTR_CLASS_XC_SHA3, "d,s,t,3" },
+    {"xc.sha3.x4"       , 0x3e00707f, 0x16007003, INSTR_CLASS_XC_SHA3, "d,s,t,3" },
+    {"xc.sha3.yx"       , 0x3e00707f, 0x18007003, INSTR_CLASS_XC_SHA3, "d,s,t,3" },
+    {"xc.sha256.s0"     , 0xfff0707f, 0x0e007003, INSTR_CLASS_XC_SHA2, "d,s"     },
+    {"xc.sha256.s1"     , 0xfff0707f, 0x0e107003, INSTR_CLASS_XC_SHA2, "d,s"     },
+    {"xc.sha256.s2"     , 0xfff0707f, 0x0e207003, INSTR_CLASS_XC_SHA2, "d,s"     },
+    {"xc.sha256.s3"     , 0xfff0707f, 0x0e307003, INSTR_CLASS_XC_SHA2, "d,s"     },
+    {"cmov"             , 0x0600707f, 0x06005033, INSTR_CLASS_B, "d,t,s,r" },
+    {"ror"              , 0xfe00707f, 0x60005033, INSTR_CLASS_B, "d,s,t"   },
+    {"rori"             , 0xfc00707f, 0x60005013, INSTR_CLASS_B, "d,s,>"   },
+    {"fsl"              , 0x0600707f, 0x04001033, INSTR_CLASS_B, "d,s,r,t" },
+    {"fsr"              , 0x0600707f, 0x04005033, INSTR_CLASS_B, "d,s,r,t" },
+    {"fsri"             , 0x0400707f, 0x04005013, INSTR_CLASS_B, "d,s,r,w" },
+    {"clmul"            , 0xfe00707f, 0x0a001033, INSTR_CLASS_B, "d,s,t"   },
+    {"clmulr"           , 0xfe00707f, 0x0a002033, INSTR_CLASS_B, "d,s,t"   },
+    {"clmulh"           , 0xfe00707f, 0x0a003033, INSTR_CLASS_B, "d,s,t"   },
+    {"bdep"             , 0xfe00707f, 0x08002033, INSTR_CLASS_B, "d,s,t"   },
+    {"bext"             , 0xfe00707f, 0x08006033, INSTR_CLASS_B, "d,s,t"   },
+    {"grev"             , 0xfe00707f, 0x40001033, INSTR_CLASS_B, "d,s,t"   },
+    {"grevi"            , 0xfc00707f, 0x40001013, INSTR_CLASS_B, "d,s,>"   },
+};
+
+const unsigned instr_num_encodings =
+    sizeof(instr_encodings) / sizeof(instr_encodings[0]);
+
+
+//! Decode an instruction word as the core's decoder does.
+unsigned instr_decode(uint32_t word) {
+
+    if((word & 0x3) != 0x3) {
+        word &= 0xFFFF;
+    }
+
+    for(unsigned i = 0; i < instr_num_encodings; i ++) {
+        if((word & instr_encodings[i].mask) == instr_encodings[i].match) {
+            return i;
+        }
+    }
+
+    return instr_num_encodings;
+
+}
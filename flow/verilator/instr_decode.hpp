@@ -0,0 +1,58 @@
+
+#include <cstdint>
+
+#ifndef INSTR_DECODE_HPP
+#define INSTR_DECODE_HPP
+
+/*!
+@brief Groups of instructions, as the core's decoder enables them: the
+    base ISA and its standard extensions, the bitmanip subset, and one per
+    XC_CLASS_* parameter of the xcrypto extension.
+*/
+typedef enum instr_class {
+    INSTR_CLASS_RV32I         = 0,
+    INSTR_CLASS_RV32M         ,
+    INSTR_CLASS_RV32C         ,
+    INSTR_CLASS_B             , //!< BITMANIP_BASELINE
+    INSTR_CLASS_XC_BASELINE   ,
+    INSTR_CLASS_XC_RANDOMNESS ,
+    INSTR_CLASS_XC_MEMORY     ,
+    INSTR_CLASS_XC_BIT        ,
+    INSTR_CLASS_XC_PACKED     ,
+    INSTR_CLASS_XC_MULTIARITH ,
+    INSTR_CLASS_XC_AES        ,
+    INSTR_CLASS_XC_SHA2       ,
+    INSTR_CLASS_XC_SHA3       ,
+    INSTR_CLASS_XC_LEAK       ,
+    INSTR_CLASS_UNKNOWN       , //!< Not decoded.
+    INSTR_NUM_CLASSES
+} instr_class_t;
+
+//! Name of an instruction class, e.g. "XC_CLASS_AES".
+const char * instr_class_name(instr_class_t c);
+
+//! One instruction encoding: words with (word & mask) == match.
+typedef struct instr_encoding {
+    const char    * name    ; //!< Mnemonic, e.g. "xc.aessub.enc".
+    uint32_t        mask    ;
+    uint32_t        match   ;
+    instr_class_t   iclass  ;
+    const char    * args    ; //!< Operands, for instr_disasm().
+} instr_encoding_t;
+
+//! Number of entries in the table instr_decode() searches.
+extern const unsigned instr_num_encodings;
+
+//! The table instr_decode() searches.
+extern const instr_encoding_t instr_encodings[];
+
+/*!
+@brief Decode an instruction word as the core's decoder
+    (frv_pipeline_decode.vh) does. Compressed instructions are only looked
+    at in the low 16 bits.
+@returns The index of its entry in instr_encodings, or
+    instr_num_encodings if it is not an instruction.
+*/
+unsigned instr_decode(uint32_t word);
+
+#endif
@@ -0,0 +1,205 @@
+
+#include <cstdio>
+
+#include "instr_decode.hpp"
+#include "instr_disasm.hpp"
+
+//! ABI names of the general purpose registers.
+static const char * disasm_regs[32] = {
+    "zero", "ra", "sp", "gp", "tp", "t0", "t1", "t2",
+    "s0"  , "s1", "a0", "a1", "a2", "a3", "a4", "a5",
+    "a6"  , "a7", "s2", "s3", "s4", "s5", "s6", "s7",
+    "s8"  , "s9", "s10","s11","t3", "t4", "t5", "t6"
+};
+
+//! Names of the CSRs frv_csrs implements.
+static const struct { uint32_t addr; const char * name; } disasm_csrs[] = {
+    {0xC00, "cycle"    }, {0xC01, "time"     }, {0xC02, "instret"  },
+    {0xC80, "cycleh"   }, {0xC81, "timeh"    }, {0xC82, "instreth" },
+    {0xB00, "mcycle"   }, {0xB02, "minstret" }, {0xB80, "mcycleh"  },
+    {0xB82, "minstreth"}, {0x320, "mcountinhibit"},
+    {0x300, "mstatus"  }, {0x301, "misa"     }, {0x302, "medeleg"  },
+    {0x303, "mideleg"  }, {0x304, "mie"      }, {0x305, "mtvec"    },
+    {0x340, "mscratch" }, {0x341, "mepc"     }, {0x342, "mcause"   },
+    {0x343, "mtval"    }, {0x344, "mip"      }, {0xF11, "mvendorid"},
+    {0xF12, "marchid"  }, {0xF13, "mimpid"   }, {0xF14, "mhartid"  },
+    {0x800, "uxcrypto" }, {0x801, "lkgcfg"   }
+};
+
+//! Bits hi..lo of word, at the bottom.
+#define BITS(w, hi, lo) (((w) >> (lo)) & ((1u << ((hi) - (lo) + 1)) - 1))
+
+//! Bit b of word, moved to bit to.
+#define BIT_TO(w, b, to) ((((w) >> (b)) & 0x1) << (to))
+
+//! Sign extend the low bits of value.
+static int32_t disasm_sext(uint32_t value, int bits) {
+    uint32_t m = 1u << (bits - 1);
+    return (int32_t)((value ^ m) - m);
+}
+
+//! Print a signed immediate in decimal.
+static int disasm_imm(char * buf, size_t len, int32_t imm) {
+    return snprintf(buf, len, "%d", imm);
+}
+
+//! Print a branch or jump target.
+static int disasm_target (
+    char   * buf    ,
+    size_t   len    ,
+    int32_t  offset ,
+    bool     has_pc ,
+    uint32_t pc
+) {
+    if(has_pc) {
+        return snprintf(buf, len, "0x%x", pc + offset);
+    }
+    return snprintf(buf, len, "pc%c0x%x", offset < 0 ? '-' : '+',
+                    offset < 0 ? -(uint32_t)offset : (uint32_t)offset);
+}
+
+
+//! Disassemble, with or without the instruction's address.
+static std::string disasm(uint32_t word, bool has_pc, uint32_t pc) {
+
+    unsigned e = instr_decode(word);
+
+    char   out[96];
+
+    if(e >= instr_num_encodings) {
+        snprintf(out, sizeof(out), ".word 0x%08x",
+                 instr_is_32bit(word) ? word : word & 0xFFFF);
+        return out;
+    }
+
+    instr_encoding_t const & enc = instr_encodings[e];
+
+    uint32_t w   = word;
+    size_t   len = sizeof(out);
+    int      n   = snprintf(out, len, "%s", enc.name);
+
+    if(enc.args[0]) {
+        n += snprintf(out + n, len - n, " ");
+    }
+
+    for(const char * a = enc.args; *a && n < (int)len; a ++) {
+
+        char * p = out + n;
+        size_t l = len - n;
+
+        switch(*a) {
+
+        // 32-bit operands.
+        case 'd': n += snprintf(p, l, "%s", disasm_regs[BITS(w,11, 7)]); break;
+        case 's': n += snprintf(p, l, "%s", disasm_regs[BITS(w,19,15)]); break;
+        case 't': n += snprintf(p, l, "%s", disasm_regs[BITS(w,24,20)]); break;
+        case 'r': n += snprintf(p, l, "%s", disasm_regs[BITS(w,31,27)]); break;
+        case 'i':
+            n += disasm_imm(p, l, disasm_sext(w >> 20, 12));
+            break;
+        case 'o':
+            n += disasm_imm(p, l, disasm_sext(w >> 20, 12));
+            n += snprintf(out + n, len - n, "(%s)", disasm_regs[BITS(w,19,15)]);
+            break;
+        case 'q':
+            n += disasm_imm(p, l, disasm_sext(BITS(w,31,25) << 5 |
+                                              BITS(w,11, 7), 12));
+            n += snprintf(out + n, len - n, "(%s)", disasm_regs[BITS(w,19,15)]);
+            break;
+        case 'u': n += snprintf(p, l, "0x%x", w >> 12); break;
+        case 'b':
+            n += disasm_target(p, l, disasm_sext(
+                    BIT_TO(w,31,12) | BIT_TO(w,7,11) |
+                    BITS(w,30,25) << 5 | BITS(w,11,8) << 1, 13), has_pc, pc);
+            break;
+        case 'a':
+            n += disasm_target(p, l, disasm_sext(
+                    BIT_TO(w,31,20) | BITS(w,19,12) << 12 |
+                    BIT_TO(w,20,11) | BITS(w,30,21) << 1, 21), has_pc, pc);
+            break;
+        case '>': n += snprintf(p, l, "%u", BITS(w,24,20)); break;
+        case 'w': n += snprintf(p, l, "%u", BITS(w,25,20)); break;
+        case 'Z': n += snprintf(p, l, "%u", BITS(w,19,15)); break;
+        case 'c': {
+            const char * name = NULL;
+            for(auto const & c : disasm_csrs) {
+                if(c.addr == w >> 20) {
+                    name = c.name;
+                }
+            }
+            n += name ? snprintf(p, l, "%s", name) :
+                        snprintf(p, l, "0x%x", w >> 20);
+            break;
+        }
+        case 'P': n += snprintf(p, l, "%u", 2u << BITS(w,31,30)); break;
+        case '3': n += snprintf(p, l, "%u", BITS(w,31,30)); break;
+
+        // 16-bit operands.
+        case 'D': n += snprintf(p, l, "%s", disasm_regs[8+BITS(w,4,2)]); break;
+        case 'S': n += snprintf(p, l, "%s", disasm_regs[8+BITS(w,9,7)]); break;
+        case 'e': n += snprintf(p, l, "%s", disasm_regs[BITS(w,11,7)]); break;
+        case 'f': n += snprintf(p, l, "%s", disasm_regs[BITS(w, 6,2)]); break;
+        case 'j':
+            n += disasm_imm(p, l, disasm_sext(BIT_TO(w,12,5) |
+                                              BITS(w,6,2), 6));
+            break;
+        case 'k':
+            n += snprintf(p, l, "0x%x", (uint32_t)disasm_sext(
+                    BIT_TO(w,12,5) | BITS(w,6,2), 6) & 0xFFFFF);
+            break;
+        case 'l': n += snprintf(p, l, "%u", BIT_TO(w,12,5)|BITS(w,6,2)); break;
+        case 'm':
+            n += snprintf(p, l, "%u(%s)", BITS(w,12,10) << 3 |
+                          BIT_TO(w,6,2) | BIT_TO(w,5,6),
+                          disasm_regs[8+BITS(w,9,7)]);
+            break;
+        case 'n':
+            n += snprintf(p, l, "%u(sp)", BIT_TO(w,12,5) |
+                          BITS(w,6,4) << 2 | BITS(w,3,2) << 6);
+            break;
+        case 'p':
+            n += snprintf(p, l, "%u(sp)", BITS(w,12,9) << 2 |
+                          BITS(w,8,7) << 6);
+            break;
+        case 'g':
+            n += snprintf(p, l, "sp,%u", BITS(w,12,11) << 4 |
+                          BITS(w,10,7) << 6 | BIT_TO(w,6,2) | BIT_TO(w,5,3));
+            break;
+        case 'h':
+            n += snprintf(p, l, "sp,%d", disasm_sext(
+                    BIT_TO(w,12,9) | BIT_TO(w,6,4) | BIT_TO(w,5,6) |
+                    BITS(w,4,3) << 7 | BIT_TO(w,2,5), 10));
+            break;
+        case 'J':
+            n += disasm_target(p, l, disasm_sext(
+                    BIT_TO(w,12,11) | BIT_TO(w,11,4) | BITS(w,10,9) << 8 |
+                    BIT_TO(w,8,10) | BIT_TO(w,7,6) | BIT_TO(w,6,7) |
+                    BITS(w,5,3) << 1 | BIT_TO(w,2,5), 12), has_pc, pc);
+            break;
+        case 'B':
+            n += disasm_target(p, l, disasm_sext(
+                    BIT_TO(w,12,8) | BITS(w,11,10) << 3 | BITS(w,6,5) << 6 |
+                    BITS(w,4,3) << 1 | BIT_TO(w,2,5), 9), has_pc, pc);
+            break;
+
+        default:
+            n += snprintf(p, l, "%c", *a);
+            break;
+        }
+    }
+
+    return out;
+
+}
+
+
+//! Disassemble one instruction.
+std::string instr_disasm(uint32_t word) {
+    return disasm(word, false, 0);
+}
+
+
+//! Disassemble one instruction at a known address.
+std::string instr_disasm(uint32_t word, uint32_t pc) {
+    return disasm(word, true, pc);
+}
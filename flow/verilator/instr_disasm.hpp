@@ -0,0 +1,28 @@
+
+#include <cstdint>
+#include <string>
+
+#ifndef INSTR_DISASM_HPP
+#define INSTR_DISASM_HPP
+
+/*!
+@brief Disassemble one instruction of RV32IMC, the bitmanip subset or
+    xcrypto, as objdump -M no-aliases would: "addi a0,a0,1".
+@details Branch and jump targets are shown relative to the instruction
+    ("pc+0x10"), since the same word may sit at any address. Words which
+    are not instructions come out as ".word 0x...".
+*/
+std::string instr_disasm(uint32_t word);
+
+/*!
+@brief Disassemble one instruction at a known address. The same as
+    instr_disasm(word), but branch and jump targets are absolute.
+*/
+std::string instr_disasm(uint32_t word, uint32_t pc);
+
+//! Is this the low half of a 32-bit instruction (or a 16-bit one)?
+inline bool instr_is_32bit(uint32_t word) {
+    return (word & 0x3) == 0x3;
+}
+
+#endif
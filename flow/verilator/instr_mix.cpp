@@ -0,0 +1,165 @@
+
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+
+#include "instr_mix.hpp"
+
+//! Start counting.
+instr_mix::instr_mix(uint64_t start_cycle) {
+
+    this -> by_encoding.resize(instr_num_encodings + 1);
+    this -> last_cycle = start_cycle;
+
+}
+
+
+//! An instruction retired.
+void instr_mix::retired(uint32_t word, uint64_t cycle, bool count) {
+
+    uint64_t cycles    = cycle - this -> last_cycle;
+    this -> last_cycle = cycle;
+
+    if(!count) {
+        return;
+    }
+
+    auto     it = this -> decoded.find(word);
+    unsigned e;
+
+    if(it == this -> decoded.end()) {
+        e = instr_decode(word);
+        this -> decoded[word] = e;
+    } else {
+        e = it -> second;
+    }
+
+    instr_class_t c = e < instr_num_encodings ? instr_encodings[e].iclass :
+                                                INSTR_CLASS_UNKNOWN;
+
+    this -> by_encoding[e].instrs ++;
+    this -> by_encoding[e].cycles += cycles;
+    this -> by_class[c].instrs    ++;
+    this -> by_class[c].cycles    += cycles;
+    this -> total_instrs          ++;
+    this -> total_cycles          += cycles;
+
+}
+
+
+//! Print one row of a report table.
+static void instr_mix_row (
+    std::ostream            & os    ,
+    std::string const       & name  ,
+    instr_mix_count_t const & n     ,
+    uint64_t                  instrs,
+    uint64_t                  cycles
+) {
+
+    os << ">>   " << std::left << std::setw(20) << name << std::right
+       << std::setw(12) << n.instrs << std::fixed << std::setprecision(2)
+       << std::setw(8)  << (instrs ? 100.0 * n.instrs / instrs : 0.0) << "%"
+       << std::setw(14) << n.cycles
+       << std::setw(8)  << (cycles ? 100.0 * n.cycles / cycles : 0.0) << "%"
+       << std::setw(8)  << (n.instrs ? (double)n.cycles / n.instrs : 0.0)
+       << std::endl;
+
+}
+
+
+//! Print a table of the classes, then of the mnemonics, in use.
+void instr_mix::report(std::ostream & os) {
+
+    uint64_t in = this -> total_instrs;
+    uint64_t cy = this -> total_cycles;
+
+    os << ">> Instruction mix: " << std::dec << in << " instructions, "
+       << cy << " cycles" << std::endl;
+    os << ">>   " << std::left << std::setw(20) << "class" << std::right
+       << std::setw(12) << "instrs" << std::setw(9) << "%"
+       << std::setw(14) << "cycles" << std::setw(9) << "%"
+       << std::setw(8)  << "CPI" << std::endl;
+
+    for(int c = 0; c < INSTR_NUM_CLASSES; c ++) {
+        if(this -> by_class[c].instrs) {
+            instr_mix_row(os, instr_class_name((instr_class_t)c),
+                          this -> by_class[c], in, cy);
+        }
+    }
+
+    // Mnemonics, most cycles first.
+    std::vector<unsigned> order;
+
+    for(unsigned e = 0; e <= instr_num_encodings; e ++) {
+        if(this -> by_encoding[e].instrs) {
+            order.push_back(e);
+        }
+    }
+
+    std::stable_sort(order.begin(), order.end(),
+        [this](unsigned a, unsigned b) {
+            return this -> by_encoding[a].cycles >
+                   this -> by_encoding[b].cycles;
+        });
+
+    os << ">>   mnemonic" << std::endl;
+
+    for(unsigned e : order) {
+        instr_mix_row(os, e < instr_num_encodings ? instr_encodings[e].name :
+                          "unknown", this -> by_encoding[e], in, cy);
+    }
+
+    os << std::defaultfloat;
+
+}
+
+
+//! Write the counts as JSON.
+bool instr_mix::write_json(std::string path) {
+
+    FILE * fh = fopen(path.c_str(), "w");
+
+    if(fh == NULL) {
+        return false;
+    }
+
+    fprintf(fh, "{\n  \"instrs\": %lu,\n  \"cycles\": %lu,\n",
+            (unsigned long)this -> total_instrs,
+            (unsigned long)this -> total_cycles);
+
+    fprintf(fh, "  \"classes\": {\n");
+
+    for(int c = 0; c < INSTR_NUM_CLASSES; c ++) {
+        fprintf(fh, "    \"%s\": {\"instrs\": %lu, \"cycles\": %lu}%s\n",
+                instr_class_name((instr_class_t)c),
+                (unsigned long)this -> by_class[c].instrs,
+                (unsigned long)this -> by_class[c].cycles,
+                c + 1 < INSTR_NUM_CLASSES ? "," : "");
+    }
+
+    fprintf(fh, "  },\n  \"mnemonics\": {\n");
+
+    bool first = true;
+
+    for(unsigned e = 0; e <= instr_num_encodings; e ++) {
+
+        instr_mix_count_t const & n = this -> by_encoding[e];
+
+        if(n.instrs == 0) {
+            continue;
+        }
+
+        fprintf(fh, "%s    \"%s\": {\"instrs\": %lu, \"cycles\": %lu}",
+                first ? "" : ",\n",
+                e < instr_num_encodings ? instr_encodings[e].name : "unknown",
+                (unsigned long)n.instrs, (unsigned long)n.cycles);
+
+        first = false;
+    }
+
+    fprintf(fh, "%s  }\n}\n", first ? "" : "\n");
+    fclose(fh);
+
+    return true;
+
+}
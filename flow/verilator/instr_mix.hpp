@@ -0,0 +1,81 @@
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "instr_decode.hpp"
+
+#ifndef INSTR_MIX_HPP
+#define INSTR_MIX_HPP
+
+//! Retired instructions and cycles counted against one mnemonic or class.
+typedef struct instr_mix_count {
+    uint64_t    instrs      = 0;
+    uint64_t    cycles      = 0;
+} instr_mix_count_t;
+
+/*!
+@brief Counts the instructions a run retires by mnemonic and by class
+    (instr_class_t), to show how much each extension is used.
+@details Each instruction is also charged the cycles since the one
+    before it retired, so stalls are put down to the instruction which
+    waited for them and the cycles of all classes add up to the run's.
+    Cycles are simulation cycles, as +TIMEOUT.
+*/
+class instr_mix {
+
+public:
+
+    /*!
+    @brief Start counting.
+    @param in start_cycle - Simulation cycle now. The first instruction
+                            is charged the cycles since.
+    */
+    instr_mix(uint64_t start_cycle);
+
+    /*!
+    @brief An instruction retired.
+    @param in word  - The instruction, as trs_instr.
+    @param in cycle - Simulation cycle it retired in.
+    @param in count - Count it? Those which are not still start the
+                      cycles charged to the next one.
+    */
+    void retired(uint32_t word, uint64_t cycle, bool count);
+
+    //! Instructions counted.
+    uint64_t    total_instrs    = 0;
+
+    //! Cycles charged to those instructions.
+    uint64_t    total_cycles    = 0;
+
+    //! Print a table of the classes, then of the mnemonics, in use.
+    void report(std::ostream & os);
+
+    /*!
+    @brief Write the counts as JSON: {"instrs": N, "cycles": N,
+        "classes": {"<class>": {"instrs": N, "cycles": N}, ...},
+        "mnemonics": {"<name>": {...}, ...}}. Classes are all listed,
+        mnemonics only if used.
+    @returns false if the file could not be written.
+    */
+    bool write_json(std::string path);
+
+protected:
+
+    //! Counts for each entry of instr_encodings, then for unknown words.
+    std::vector<instr_mix_count_t> by_encoding;
+
+    //! Counts for each instr_class_t.
+    instr_mix_count_t by_class[INSTR_NUM_CLASSES];
+
+    //! Words decoded so far, so each is only looked up once.
+    std::unordered_map<uint32_t, unsigned> decoded;
+
+    //! Cycle the last instruction retired in.
+    uint64_t    last_cycle      = 0;
+
+};
+
+#endif
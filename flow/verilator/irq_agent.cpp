@@ -0,0 +1,560 @@
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "irq_agent.hpp"
+
+//! Encoding of the mret instruction.
+#define IRQ_MRET_INSTR 0x30200073
+
+//! Marks a handler entered for something other than one of our lines.
+#define IRQ_NOT_OURS   IRQ_NUM_LINES
+
+static const char * irq_line_names[IRQ_NUM_LINES] = {
+    "nmi", "external", "software"
+};
+
+
+//! Parse a comma separated list of line names into a mask.
+uint32_t irq_lines_from_names(std::string names) {
+
+    uint32_t    lines = 0;
+    std::string name;
+    std::stringstream ss(names);
+
+    while(std::getline(ss, name, ',')) {
+        for(int i = 0; i < IRQ_NUM_LINES; i ++) {
+            if(name == irq_line_names[i]) {
+                lines |= 1 << i;
+            }
+        }
+    }
+
+    return lines;
+
+}
+
+
+//! The line an interrupt with this mcause came in on, or IRQ_NOT_OURS.
+static int irq_line_of_cause(uint32_t mcause) {
+
+    uint32_t cause = mcause & 0x3F;
+
+    if(!(mcause >> 31)) {
+        return IRQ_NOT_OURS;
+    } else if(cause == 16) {
+        return IRQ_NMI;
+    } else if(cause == 11 || cause > 16) {
+        // Machine external, or one of int_extern_cause's codes.
+        return IRQ_EXTERNAL;
+    } else if(cause == 3) {
+        return IRQ_SOFTWARE;
+    }
+
+    return IRQ_NOT_OURS;
+
+}
+
+
+//! Add one sample.
+void irq_stats::add(uint64_t latency) {
+
+    if(this -> count == 0 || latency < this -> min) {
+        this -> min = latency;
+    }
+    if(latency > this -> max) {
+        this -> max = latency;
+    }
+
+    this -> count ++;
+    this -> total += latency;
+
+    uint64_t bin = latency / IRQ_HIST_BIN_WIDTH;
+
+    this -> hist[std::min<uint64_t>(bin, IRQ_HIST_BINS - 1)] ++;
+
+}
+
+
+//! Load a schedule of interrupts, replacing any other.
+bool irq_agent::load_schedule(std::string path) {
+
+    std::ifstream fh(path);
+
+    if(!fh.is_open()) {
+        std::cout << ">> Could not open interrupt schedule " << path
+                  << std::endl;
+        return false;
+    }
+
+    this -> schedule.clear();
+
+    std::string line;
+    int         lineno = 0;
+
+    while(std::getline(fh, line)) {
+
+        lineno ++;
+
+        std::stringstream ss(line);
+        std::string       cycle, name;
+
+        if(!(ss >> cycle) || cycle[0] == '#') {
+            continue;
+        }
+
+        irq_event_t ev = {};
+        unsigned    cause = 0;
+
+        bool ok = (bool)(ss >> name);
+
+        for(int i = 0; ok && i <= IRQ_NUM_LINES; i ++) {
+            if(i == IRQ_NUM_LINES) {
+                ok = false;
+            } else if(name == irq_line_names[i]) {
+                ev.line = (irq_line_t)i;
+                break;
+            }
+        }
+
+        if(ok && !(ss >> cause)) {
+            cause = 0;
+        }
+
+        try {
+            ev.cycle = std::stoull(cycle, NULL, 0);
+        } catch(std::exception const & e) {
+            ok = false;
+        }
+
+        if(!ok || cause > 15) {
+            std::cout << ">> " << path << ":" << lineno
+                      << ": expected <cycle> <nmi|external|software> [cause]"
+                      << std::endl;
+            return false;
+        }
+
+        ev.cause = cause;
+
+        this -> schedule.push_back(ev);
+    }
+
+    std::stable_sort(this -> schedule.begin(), this -> schedule.end(),
+        [](irq_event_t const & a, irq_event_t const & b) {
+            return a.cycle < b.cycle;
+        });
+
+    return true;
+
+}
+
+
+//! Raise interrupts at random instead.
+void irq_agent::set_random(uint64_t mean_gap, uint32_t lines, uint64_t seed) {
+
+    this -> schedule.clear();
+
+    this -> random_gap   = mean_gap;
+    this -> random_lines = lines & ((1 << IRQ_NUM_LINES) - 1);
+    this -> random_seed  = seed;
+
+    if(this -> random_lines == 0) {
+        this -> random_gap = 0;
+    }
+
+}
+
+
+//! Next random sample. xorshift64*.
+uint32_t irq_agent::random() {
+
+    this -> random_state ^= this -> random_state >> 12;
+    this -> random_state ^= this -> random_state << 25;
+    this -> random_state ^= this -> random_state >> 27;
+
+    return (this -> random_state * 0x2545F4914F6CDD1DULL) >> 32;
+
+}
+
+
+//! Schedule the next random interrupt, from now.
+void irq_agent::random_schedule() {
+
+    this -> random_next = this -> cycle + 1 +
+                          this -> random() % (2 * this -> random_gap - 1);
+
+}
+
+
+//! Put the interface in reset, back at the start of the schedule.
+void irq_agent::set_reset() {
+
+    *int_nmi          = 0;
+    *int_external     = 0;
+    *int_extern_cause = 0;
+    *int_software     = 0;
+
+    n_int_nmi          = 0;
+    n_int_external     = 0;
+    n_int_extern_cause = 0;
+    n_int_software     = 0;
+
+    this -> cycle   = 0;
+    this -> raised  = 0;
+    this -> dropped = 0;
+    this -> entry_latency  = irq_stats_t();
+    this -> return_latency = irq_stats_t();
+
+    this -> pending.assign(this -> schedule.begin(), this -> schedule.end());
+    this -> in_handler.clear();
+
+    for(int i = 0; i < IRQ_NUM_LINES; i ++) {
+        this -> is_held[i] = false;
+    }
+
+    // Never zero, or the generator only ever returns zero.
+    this -> random_state = this -> random_seed | 0x1;
+    this -> random_next  = UINT64_MAX;
+    this -> random_held  = IRQ_NUM_LINES;
+
+    if(this -> random_gap) {
+        this -> random_schedule();
+    }
+
+}
+
+
+//! Take the interface out of reset
+void irq_agent::clear_reset() {
+
+    // Nothing is raised until the first posedge_clk.
+
+}
+
+
+//! Compute any *next* signal values
+void irq_agent::posedge_clk() {
+
+    this -> cycle ++;
+
+    while(!this -> pending.empty() &&
+          this -> pending.front().cycle <= this -> cycle &&
+          !this -> is_held[this -> pending.front().line]) {
+
+        irq_event_t ev = this -> pending.front();
+        this -> pending.pop_front();
+
+        ev.raised = this -> cycle;
+
+        this -> held   [ev.line] = ev;
+        this -> is_held[ev.line] = true;
+        this -> raised ++;
+    }
+
+    if(this -> random_held != IRQ_NUM_LINES &&
+       this -> cycle >= this -> held[this -> random_held].raised +
+                        IRQ_RANDOM_TIMEOUT) {
+
+        // Not taken, e.g. the program has masked the line.
+        this -> is_held[this -> random_held] = false;
+        this -> random_held = IRQ_NUM_LINES;
+        this -> dropped ++;
+        this -> random_schedule();
+    }
+
+    if(this -> random_gap && this -> cycle >= this -> random_next) {
+
+        uint32_t pick;
+
+        do {
+            pick = this -> random() % IRQ_NUM_LINES;
+        } while(!((this -> random_lines >> pick) & 0x1));
+
+        irq_event_t ev = {};
+
+        ev.cycle  = this -> cycle;
+        ev.raised = this -> cycle;
+        ev.line   = (irq_line_t)pick;
+
+        this -> held   [pick] = ev;
+        this -> is_held[pick] = true;
+        this -> raised ++;
+
+        // The next is scheduled once this one is taken, or dropped.
+        this -> random_next = UINT64_MAX;
+        this -> random_held = pick;
+    }
+
+    n_int_nmi          = this -> is_held[IRQ_NMI     ];
+    n_int_external     = this -> is_held[IRQ_EXTERNAL];
+    n_int_software     = this -> is_held[IRQ_SOFTWARE];
+
+    n_int_extern_cause = this -> is_held[IRQ_NMI     ] ?
+                             this -> held[IRQ_NMI     ].cause :
+                         this -> is_held[IRQ_EXTERNAL] ?
+                             this -> held[IRQ_EXTERNAL].cause : 0;
+
+}
+
+
+//! Drive any signal updates
+void irq_agent::drive_signals() {
+
+    *int_nmi          = n_int_nmi         ;
+    *int_external     = n_int_external    ;
+    *int_extern_cause = n_int_extern_cause;
+    *int_software     = n_int_software    ;
+
+}
+
+
+//! Watch the instruction retired at this rising clock edge.
+void irq_agent::retired (
+    bool     intr   ,
+    bool     trap   ,
+    uint32_t insn   ,
+    uint32_t mcause
+) {
+
+    if(intr) {
+
+        irq_event_t ev = {};
+
+        ev.line = (irq_line_t)IRQ_NOT_OURS;
+
+        int line = irq_line_of_cause(mcause);
+
+        if(line != IRQ_NOT_OURS && this -> is_held[line]) {
+            ev = this -> held[line];
+            ev.taken = this -> cycle;
+            this -> is_held[line] = false;
+            this -> entry_latency.add(ev.taken - ev.raised);
+            if(line == this -> random_held) {
+                this -> random_held = IRQ_NUM_LINES;
+                this -> random_schedule();
+            }
+        }
+
+        // Let go of the line before the handler can return.
+        n_int_nmi      = this -> is_held[IRQ_NMI     ];
+        n_int_external = this -> is_held[IRQ_EXTERNAL];
+        n_int_software = this -> is_held[IRQ_SOFTWARE];
+
+        this -> in_handler.push_back(ev);
+    }
+
+    if(trap) {
+
+        // Exception handlers return with mret too.
+        irq_event_t ev = {};
+        ev.line = (irq_line_t)IRQ_NOT_OURS;
+        this -> in_handler.push_back(ev);
+
+    } else if(insn == IRQ_MRET_INSTR && !this -> in_handler.empty()) {
+
+        irq_event_t ev = this -> in_handler.back();
+        this -> in_handler.pop_back();
+
+        if(ev.line != IRQ_NOT_OURS) {
+            this -> return_latency.add(this -> cycle - ev.raised);
+        }
+    }
+
+}
+
+
+//! Account for cycles skipped over without being simulated.
+void irq_agent::skip(uint64_t cycles) {
+
+    this -> cycle += cycles;
+
+}
+
+
+//! Clock cycles until the agent next raises a line.
+uint64_t irq_agent::cycles_to_next() {
+
+    uint64_t next = this -> random_next;
+
+    if(this -> random_held != IRQ_NUM_LINES) {
+        next = this -> held[this -> random_held].raised + IRQ_RANDOM_TIMEOUT;
+    }
+
+    if(!this -> pending.empty() &&
+       !this -> is_held[this -> pending.front().line]) {
+        next = std::min(next, this -> pending.front().cycle);
+    }
+
+    if(next == UINT64_MAX) {
+        return UINT64_MAX;
+    }
+
+    return next > this -> cycle ? next - this -> cycle : 0;
+
+}
+
+
+static void irq_save_event(VerilatedSerialize & os, irq_event_t & ev) {
+    uint8_t line = ev.line;
+    os << ev.cycle << line << ev.cause << ev.raised << ev.taken;
+}
+
+
+static void irq_restore_event(VerilatedDeserialize & is, irq_event_t & ev) {
+    uint8_t line = 0;
+    is >> ev.cycle >> line >> ev.cause >> ev.raised >> ev.taken;
+    ev.line = (irq_line_t)line;
+}
+
+
+static void irq_save_stats(VerilatedSerialize & os, irq_stats_t & st) {
+    os << st.count << st.min << st.max << st.total;
+    for(int i = 0; i < IRQ_HIST_BINS; i ++) {
+        os << st.hist[i];
+    }
+}
+
+
+static void irq_restore_stats(VerilatedDeserialize & is, irq_stats_t & st) {
+    is >> st.count >> st.min >> st.max >> st.total;
+    for(int i = 0; i < IRQ_HIST_BINS; i ++) {
+        is >> st.hist[i];
+    }
+}
+
+
+//! Write the schedule position, held lines and statistics.
+void irq_agent::save_state (VerilatedSerialize & os) {
+
+    os << cycle << raised << dropped << random_state << random_next
+       << random_held;
+    os << n_int_nmi << n_int_external << n_int_extern_cause << n_int_software;
+
+    uint64_t num_pending = pending.size();
+    os << num_pending;
+    for(irq_event_t & ev : pending) {
+        irq_save_event(os, ev);
+    }
+
+    for(int i = 0; i < IRQ_NUM_LINES; i ++) {
+        uint8_t h = is_held[i];
+        os << h;
+        irq_save_event(os, held[i]);
+    }
+
+    uint64_t num_handlers = in_handler.size();
+    os << num_handlers;
+    for(irq_event_t & ev : in_handler) {
+        irq_save_event(os, ev);
+    }
+
+    irq_save_stats(os, entry_latency);
+    irq_save_stats(os, return_latency);
+
+}
+
+
+//! Restore everything written by save_state.
+void irq_agent::restore_state (VerilatedDeserialize & is) {
+
+    is >> cycle >> raised >> dropped >> random_state >> random_next
+       >> random_held;
+    is >> n_int_nmi >> n_int_external >> n_int_extern_cause >> n_int_software;
+
+    uint64_t num_pending = 0;
+    is >> num_pending;
+    pending.clear();
+    for(uint64_t i = 0; i < num_pending; i ++) {
+        irq_event_t ev = {};
+        irq_restore_event(is, ev);
+        pending.push_back(ev);
+    }
+
+    for(int i = 0; i < IRQ_NUM_LINES; i ++) {
+        uint8_t h = 0;
+        is >> h;
+        is_held[i] = h;
+        irq_restore_event(is, held[i]);
+    }
+
+    uint64_t num_handlers = 0;
+    is >> num_handlers;
+    in_handler.clear();
+    for(uint64_t i = 0; i < num_handlers; i ++) {
+        irq_event_t ev = {};
+        irq_restore_event(is, ev);
+        in_handler.push_back(ev);
+    }
+
+    irq_restore_stats(is, entry_latency);
+    irq_restore_stats(is, return_latency);
+
+}
+
+
+//! Print min / avg / max and a histogram of one measurement.
+static void irq_report_stats(
+    std::ostream      & os  ,
+    std::string const & name,
+    irq_stats_t const & st
+) {
+
+    if(st.count == 0) {
+        os << ">> " << name << " latency: no samples" << std::endl;
+        return;
+    }
+
+    std::stringstream avg;
+
+    avg << std::fixed << std::setprecision(1) << (double)st.total / st.count;
+
+    os << ">> " << name << " latency (cycles): min " << st.min
+       << ", avg " << avg.str() << ", max " << st.max << std::endl;
+
+    uint64_t most = *std::max_element(st.hist, st.hist + IRQ_HIST_BINS);
+
+    for(int i = 0; i < IRQ_HIST_BINS; i ++) {
+
+        if(st.hist[i] == 0) {
+            continue;
+        }
+
+        std::stringstream range;
+
+        range << i * IRQ_HIST_BIN_WIDTH;
+
+        if(i == IRQ_HIST_BINS - 1) {
+            range << "+";
+        } else {
+            range << "-" << (i + 1) * IRQ_HIST_BIN_WIDTH - 1;
+        }
+
+        os << ">>   " << std::setw(7) << range.str() << " : "
+           << std::setw(6) << st.hist[i] << " "
+           << std::string((40 * st.hist[i] + most - 1) / most, '#')
+           << std::endl;
+    }
+
+}
+
+
+//! Print the number of interrupts and both latency measurements.
+void irq_agent::report(std::ostream & os) {
+
+    os << ">> Interrupts raised: " << std::dec << this -> raised
+       << ", taken: " << this -> entry_latency.count
+       << ", returned from: " << this -> return_latency.count << std::endl;
+
+    if(this -> dropped) {
+        os << ">> Random interrupts dropped, not taken within "
+           << IRQ_RANDOM_TIMEOUT << " cycles: " << this -> dropped
+           << std::endl;
+    }
+
+    irq_report_stats(os, "Entry" , this -> entry_latency );
+    irq_report_stats(os, "Return", this -> return_latency);
+
+}
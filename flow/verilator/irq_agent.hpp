@@ -0,0 +1,223 @@
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "verilated_save.h"
+
+#ifndef IRQ_AGENT_HPP
+#define IRQ_AGENT_HPP
+
+//! Interrupt lines driven by the agent, highest priority first.
+typedef enum irq_line {
+    IRQ_NMI         = 0,
+    IRQ_EXTERNAL    = 1,
+    IRQ_SOFTWARE    = 2,
+    IRQ_NUM_LINES   = 3
+} irq_line_t;
+
+/*!
+@brief Parse a comma separated list of line names (nmi, external,
+    software) into a mask with bit irq_line_t n set for each.
+*/
+uint32_t irq_lines_from_names(std::string names);
+
+//! Width, in clock cycles, of each bin of the latency histograms.
+#define IRQ_HIST_BIN_WIDTH 4
+
+//! Number of bins in the latency histograms. The last takes the rest.
+#define IRQ_HIST_BINS      16
+
+//! Cycles a random interrupt is held for before it is dropped.
+#define IRQ_RANDOM_TIMEOUT 10000
+
+//! One interrupt to raise.
+typedef struct irq_event {
+    uint64_t    cycle       ; //!< Clock cycle (after reset) to raise it at.
+    irq_line_t  line        ;
+    uint8_t     cause       ; //!< int_extern_cause, for nmi / external.
+    uint64_t    raised      ; //!< Clock cycle it was actually raised at.
+    uint64_t    taken       ; //!< Clock cycle its handler started at.
+} irq_event_t;
+
+//! Latency statistics for one measurement.
+typedef struct irq_stats {
+    uint64_t    count       = 0;
+    uint64_t    min         = 0;
+    uint64_t    max         = 0;
+    uint64_t    total       = 0;
+    uint64_t    hist[IRQ_HIST_BINS] = {0};
+
+    //! Add one sample.
+    void add(uint64_t latency);
+} irq_stats_t;
+
+/*!
+@brief Drives the interrupt inputs of the core, from a schedule or at
+    random, and measures how long the core takes to respond.
+@details Each interrupt raises its line and holds it until the core
+    takes an interrupt from it (an instruction retires with rvfi_intr set,
+    and mcause names the line), since there is no device the handler could
+    clear it in. Interrupts of the core's own, e.g. the timer, are not
+    counted.
+
+    Two latencies are measured, in cycles of g_clk:
+    - entry: from raising the line to retiring the first instruction of
+      the handler;
+    - return: from raising the line to the handler's mret.
+
+    Lines are only raised one interrupt at a time: an interrupt whose
+    line is still held waits for it to be taken. A random interrupt the
+    core has not taken within IRQ_RANDOM_TIMEOUT cycles, e.g. because the
+    program has masked its line, is dropped, and the next one scheduled.
+*/
+class irq_agent {
+
+public:
+
+    //! Create a new agent with pointers to the signals it will control.
+    irq_agent (
+        uint8_t * int_nmi           , //!< Non-maskable interrupt.
+        uint8_t * int_external      , //!< External interrupt trigger line.
+        uint8_t * int_extern_cause  , //!< External interrupt cause code.
+        uint8_t * int_software        //!< Software interrupt trigger line.
+    ){
+        this -> int_nmi          = int_nmi         ;
+        this -> int_external     = int_external    ;
+        this -> int_extern_cause = int_extern_cause;
+        this -> int_software     = int_software    ;
+    };
+
+    /*!
+    @brief Load a schedule of interrupts, replacing any other.
+    @details One interrupt per line: "<cycle> <nmi|external|software>
+        [cause]". Blank lines and lines starting with '#' are ignored.
+    @returns false if the file cannot be read or has a bad line.
+    */
+    bool load_schedule(std::string path);
+
+    /*!
+    @brief Raise interrupts at random instead: each one a random
+        1 to 2*mean_gap - 1 cycles after the last was taken.
+    @param in lines - Bit n set: raise irq_line_t n.
+    */
+    void set_random(uint64_t mean_gap, uint32_t lines, uint64_t seed);
+
+    //! Is the agent going to raise any interrupts?
+    bool enabled() {
+        return this -> random_gap || !this -> schedule.empty();
+    }
+
+    //! Put the interface in reset, back at the start of the schedule.
+    void set_reset();
+
+    //! Take the interface out of reset
+    void clear_reset();
+
+    //! Compute any *next* signal values
+    void posedge_clk();
+
+    //! Drive any signal updates
+    void drive_signals();
+
+    /*!
+    @brief Watch the instruction retired at this rising clock edge, as
+        reported on the RVFI outputs.
+    @param in mcause - The core's mcause, if intr is set.
+    */
+    void retired(bool intr, bool trap, uint32_t insn, uint32_t mcause);
+
+    /*!
+    @brief Account for cycles skipped over without being simulated.
+    @details Stops short of the next interrupt, which is never skipped
+        (see cycles_to_next()).
+    */
+    void skip(uint64_t cycles);
+
+    /*!
+    @brief Clock cycles until the agent next raises a line. UINT64_MAX
+        if it never will (or only once the core takes one it holds).
+    */
+    uint64_t cycles_to_next();
+
+    //! Write the schedule position, held lines and statistics.
+    void save_state (VerilatedSerialize & os);
+
+    //! Restore everything written by save_state.
+    void restore_state (VerilatedDeserialize & is);
+
+    //! Print the number of interrupts and both latency measurements.
+    void report(std::ostream & os);
+
+    //! Cycles from raising a line to the first handler instruction.
+    irq_stats_t entry_latency;
+
+    //! Cycles from raising a line to the mret of its handler.
+    irq_stats_t return_latency;
+
+    //! Interrupts raised.
+    uint64_t    raised      = 0;
+
+    //! Random interrupts dropped after IRQ_RANDOM_TIMEOUT cycles.
+    uint64_t    dropped     = 0;
+
+    // Wires driven by the agent.
+    uint8_t * int_nmi           ; //!< Non-maskable interrupt.
+    uint8_t * int_external      ; //!< External interrupt trigger line.
+    uint8_t * int_extern_cause  ; //!< External interrupt cause code.
+    uint8_t * int_software      ; //!< Software interrupt trigger line.
+
+protected:
+
+    //! Clock cycles since reset.
+    uint64_t    cycle       = 0;
+
+    //! Loaded schedule, in cycle order.
+    std::vector<irq_event_t> schedule;
+
+    //! Interrupts of the schedule still to raise.
+    std::deque<irq_event_t>  pending;
+
+    //! The interrupt each line is held for.
+    irq_event_t held[IRQ_NUM_LINES];
+
+    //! Which lines are held.
+    bool        is_held[IRQ_NUM_LINES] = {false};
+
+    //! Interrupts whose handlers are running, innermost last.
+    std::vector<irq_event_t> in_handler;
+
+    //! If not zero, raise interrupts at random, this far apart on average.
+    uint64_t    random_gap  = 0;
+
+    //! Lines random interrupts may be raised on.
+    uint32_t    random_lines= 0;
+
+    //! Seed random interrupts start from after reset.
+    uint64_t    random_seed = 0;
+
+    //! State of the random interrupt generator. Separate from tb_rand so
+    //  it does not change the memory stalls.
+    uint64_t    random_state= 0;
+
+    //! Clock cycle of the next random interrupt.
+    uint64_t    random_next = 0;
+
+    //! Line the last random interrupt is held on, or IRQ_NUM_LINES.
+    uint8_t     random_held = IRQ_NUM_LINES;
+
+    //! Next random sample.
+    uint32_t    random();
+
+    //! Schedule the next random interrupt, from now.
+    void        random_schedule();
+
+    uint8_t     n_int_nmi         ; //!< Next non-maskable interrupt.
+    uint8_t     n_int_external    ; //!< Next external interrupt line.
+    uint8_t     n_int_extern_cause; //!< Next external interrupt cause.
+    uint8_t     n_int_software    ; //!< Next software interrupt line.
+
+};
+
+#endif
@@ -0,0 +1,803 @@
+
+#include <algorithm>
+
+#include "iss.hpp"
+#include "rng_agent.hpp"
+
+//
+// Instruction field helpers
+// ------------------------------------------------------------
+
+#define F_RD(i)     (((i) >>  7) & 0x1F)
+#define F_RS1(i)    (((i) >> 15) & 0x1F)
+#define F_RS2(i)    (((i) >> 20) & 0x1F)
+#define F_RS3(i)    (((i) >> 27) & 0x1F)
+#define F_FUNCT3(i) (((i) >> 12) & 0x7 )
+#define F_FUNCT7(i) (((i) >> 25) & 0x7F)
+#define F_OPCODE(i) ( (i)        & 0x7F)
+
+#define IMM_I(i)    ((int32_t)(i) >> 20)
+#define IMM_S(i)    ((int32_t)((i) & 0xFE000000) >> 20 | (((i) >> 7) & 0x1F))
+#define IMM_B(i)    ((int32_t)((i) & 0x80000000) >> 19 | (((i) & 0x80) << 4) |\
+                     (((i) >> 20) & 0x7E0) | (((i) >> 7) & 0x1E))
+#define IMM_U(i)    ((i) & 0xFFFFF000)
+#define IMM_J(i)    ((int32_t)((i) & 0x80000000) >> 11 | ((i) & 0xFF000) |   \
+                     (((i) >> 9) & 0x800) | (((i) >> 20) & 0x7FE))
+
+// Instruction encoders, used when expanding compressed instructions and
+// building the handoff program.
+#define ENC_R(f7,rs2,rs1,f3,rd,op) \
+    ((f7) << 25 | (rs2) << 20 | (rs1) << 15 | (f3) << 12 | (rd) << 7 | (op))
+#define ENC_I(imm,rs1,f3,rd,op) \
+    (((uint32_t)(imm) & 0xFFF) << 20 | (rs1) << 15 | (f3) << 12 |             \
+     (rd) << 7 | (op))
+#define ENC_S(imm,rs2,rs1,f3,op) \
+    ((((uint32_t)(imm) >> 5) & 0x7F) << 25 | (rs2) << 20 | (rs1) << 15 |      \
+     (f3) << 12 | ((uint32_t)(imm) & 0x1F) << 7 | (op))
+#define ENC_B(imm,rs2,rs1,f3) \
+    ((((uint32_t)(imm) >> 12) & 0x1) << 31 | (((uint32_t)(imm) >> 5) & 0x3F)  \
+     << 25 | (rs2) << 20 | (rs1) << 15 | (f3) << 12 |                         \
+     (((uint32_t)(imm) >> 1) & 0xF) << 8 | (((uint32_t)(imm) >> 11) & 0x1)    \
+     << 7 | 0x63)
+#define ENC_J(imm,rd) \
+    ((((uint32_t)(imm) >> 20) & 0x1) << 31 | (((uint32_t)(imm) >> 1) & 0x3FF)\
+     << 21 | (((uint32_t)(imm) >> 11) & 0x1) << 20 |                          \
+     (((uint32_t)(imm) >> 12) & 0xFF) << 12 | (rd) << 7 | 0x6F)
+
+#define BIT(x,n)    (((x) >> (n)) & 0x1)
+
+static inline int32_t sext(uint32_t x, int bits) {
+    return (int32_t)(x << (32 - bits)) >> (32 - bits);
+}
+
+static inline uint32_t ror32(uint32_t x, uint32_t n) {
+    n &= 31;
+    return n ? (x >> n) | (x << (32 - n)) : x;
+}
+
+static inline uint64_t ror64(uint64_t x, uint32_t n) {
+    n &= 63;
+    return n ? (x >> n) | (x << (64 - n)) : x;
+}
+
+static inline uint64_t rol64(uint64_t x, uint32_t n) {
+    n &= 63;
+    return n ? (x << n) | (x >> (64 - n)) : x;
+}
+
+static uint32_t grev32(uint32_t x, uint32_t shamt) {
+    if(shamt &  1) x = ((x & 0x55555555) <<  1) | ((x & 0xAAAAAAAA) >>  1);
+    if(shamt &  2) x = ((x & 0x33333333) <<  2) | ((x & 0xCCCCCCCC) >>  2);
+    if(shamt &  4) x = ((x & 0x0F0F0F0F) <<  4) | ((x & 0xF0F0F0F0) >>  4);
+    if(shamt &  8) x = ((x & 0x00FF00FF) <<  8) | ((x & 0xFF00FF00) >>  8);
+    if(shamt & 16) x = ((x & 0x0000FFFF) << 16) | ((x & 0xFFFF0000) >> 16);
+    return x;
+}
+
+static uint64_t clmul64(uint32_t a, uint32_t b) {
+    uint64_t r = 0;
+    for(int i = 0; i < 32; i ++) {
+        if(BIT(b,i)) {
+            r ^= (uint64_t)a << i;
+        }
+    }
+    return r;
+}
+
+static uint32_t bdep32(uint32_t rs1, uint32_t rs2) {
+    uint32_t r = 0;
+    for(int i = 0, j = 0; i < 32; i ++) {
+        if(BIT(rs2,i)) {
+            if(BIT(rs1,j)) {
+                r |= 1u << i;
+            }
+            j ++;
+        }
+    }
+    return r;
+}
+
+static uint32_t bext32(uint32_t rs1, uint32_t rs2) {
+    uint32_t r = 0;
+    for(int i = 0, j = 0; i < 32; i ++) {
+        if(BIT(rs2,i)) {
+            if(BIT(rs1,i)) {
+                r |= 1u << j;
+            }
+            j ++;
+        }
+    }
+    return r;
+}
+
+//
+// Compressed instruction expansion
+// ------------------------------------------------------------
+
+uint32_t iss_expand_rvc(uint16_t c) {
+
+    uint32_t op     = c & 0x3;
+    uint32_t funct3 = (c >> 13) & 0x7;
+    uint32_t rd     = (c >>  7) & 0x1F;         // Also rs1
+    uint32_t rs2    = (c >>  2) & 0x1F;
+    uint32_t rdp    = ((c >> 2) & 0x7) + 8;     // rd' / rs2'
+    uint32_t rs1p   = ((c >> 7) & 0x7) + 8;     // rs1' / rd'
+
+    int32_t  imm6   = sext(BIT(c,12) << 5 | ((c >> 2) & 0x1F), 6);
+
+    uint32_t uimm_lw= BIT(c,6) << 2 | ((c >> 10) & 0x7) << 3 | BIT(c,5) << 6;
+
+    int32_t  imm_j  = sext(
+        BIT(c,12) << 11 | BIT(c,11) <<  4 | ((c >> 9) & 0x3) << 8 |
+        BIT(c, 8) << 10 | BIT(c, 7) <<  6 | BIT(c,6) << 7 |
+        ((c >> 3) & 0x7) << 1 | BIT(c,2) << 5, 12);
+
+    int32_t  imm_b  = sext(
+        BIT(c,12) << 8 | ((c >> 10) & 0x3) << 3 | ((c >> 5) & 0x3) << 6 |
+        ((c >> 3) & 0x3) << 1 | BIT(c,2) << 5, 9);
+
+    if(op == 0) {
+        switch(funct3) {
+            case 0: { // c.addi4spn
+                uint32_t nzuimm = ((c >> 11) & 0x3) << 4 |
+                                  ((c >>  7) & 0xF) << 6 |
+                                  BIT(c,6) << 2 | BIT(c,5) << 3;
+                if(nzuimm == 0) return 0;
+                return ENC_I(nzuimm, 2, 0, rdp, 0x13);
+            }
+            case 2: // c.lw
+                return ENC_I(uimm_lw, rs1p, 2, rdp, 0x03);
+            case 6: // c.sw
+                return ENC_S(uimm_lw, rdp, rs1p, 2, 0x23);
+            default:
+                return 0;
+        }
+    } else if(op == 1) {
+        switch(funct3) {
+            case 0: // c.addi, c.nop
+                return ENC_I(imm6, rd, 0, rd, 0x13);
+            case 1: // c.jal
+                return ENC_J(imm_j, 1);
+            case 2: // c.li
+                return ENC_I(imm6, 0, 0, rd, 0x13);
+            case 3:
+                if(rd == 2) { // c.addi16sp
+                    int32_t imm = sext(
+                        BIT(c,12) << 9 | BIT(c,6) << 4 | BIT(c,5) << 6 |
+                        ((c >> 3) & 0x3) << 7 | BIT(c,2) << 5, 10);
+                    if(imm == 0) return 0;
+                    return ENC_I(imm, 2, 0, 2, 0x13);
+                } else {      // c.lui
+                    if(imm6 == 0) return 0;
+                    return ((uint32_t)imm6 << 12) | rd << 7 | 0x37;
+                }
+            case 4: {
+                uint32_t f2 = (c >> 10) & 0x3;
+                if(f2 == 0 || f2 == 1) { // c.srli, c.srai
+                    if(BIT(c,12)) return 0;
+                    return ENC_R(f2 ? 0x20 : 0, rs2, rs1p, 5, rs1p, 0x13);
+                } else if(f2 == 2) {     // c.andi
+                    return ENC_I(imm6, rs1p, 7, rs1p, 0x13);
+                } else {
+                    if(BIT(c,12)) return 0;
+                    switch((c >> 5) & 0x3) {
+                        case 0: return ENC_R(0x20, rdp, rs1p, 0, rs1p, 0x33);
+                        case 1: return ENC_R(0x00, rdp, rs1p, 4, rs1p, 0x33);
+                        case 2: return ENC_R(0x00, rdp, rs1p, 6, rs1p, 0x33);
+                        case 3: return ENC_R(0x00, rdp, rs1p, 7, rs1p, 0x33);
+                    }
+                }
+                return 0;
+            }
+            case 5: // c.j
+                return ENC_J(imm_j, 0);
+            case 6: // c.beqz
+                return ENC_B(imm_b, 0, rs1p, 0);
+            case 7: // c.bnez
+                return ENC_B(imm_b, 0, rs1p, 1);
+        }
+    } else if(op == 2) {
+        switch(funct3) {
+            case 0: // c.slli
+                if(BIT(c,12)) return 0;
+                return ENC_R(0, rs2, rd, 1, rd, 0x13);
+            case 2: { // c.lwsp
+                uint32_t uimm = BIT(c,12) << 5 | ((c >> 4) & 0x7) << 2 |
+                                ((c >> 2) & 0x3) << 6;
+                if(rd == 0) return 0;
+                return ENC_I(uimm, 2, 2, rd, 0x03);
+            }
+            case 4:
+                if(!BIT(c,12)) {
+                    if(rs2 == 0) { // c.jr
+                        if(rd == 0) return 0;
+                        return ENC_I(0, rd, 0, 0, 0x67);
+                    } else {       // c.mv
+                        return ENC_R(0, rs2, 0, 0, rd, 0x33);
+                    }
+                } else {
+                    if(rs2 == 0 && rd == 0) { // c.ebreak
+                        return 0x00100073;
+                    } else if(rs2 == 0) {     // c.jalr
+                        return ENC_I(0, rd, 0, 1, 0x67);
+                    } else {                  // c.add
+                        return ENC_R(0, rs2, rd, 0, rd, 0x33);
+                    }
+                }
+            case 6: { // c.swsp
+                uint32_t uimm = ((c >> 9) & 0xF) << 2 | ((c >> 7) & 0x3) << 6;
+                return ENC_S(uimm, rs2, 2, 2, 0x23);
+            }
+            default:
+                return 0;
+        }
+    }
+
+    return 0;
+}
+
+//
+// ISS
+// ------------------------------------------------------------
+
+iss::iss (
+    memory_bus * mem
+) {
+    this -> mem = mem;
+    this -> reset(0);
+}
+
+
+void iss::reset(uint32_t pc) {
+
+    this -> pc      = pc;
+    this -> instret = 0;
+
+    for(int i = 0; i < 32; i ++) {
+        this -> x[i] = 0;
+    }
+
+    csr_mstatus  = 0;
+    csr_mie      = 0;
+    csr_mtvec    = 0;
+    csr_mscratch = 0;
+    csr_mepc     = 0;
+    csr_mcause   = 0;
+    csr_mtval    = 0;
+
+    mem_size     = 0;
+
+}
+
+
+void iss::copy_state(iss const & other) {
+
+    this -> pc           = other.pc;
+    this -> instret      = other.instret;
+
+    for(int i = 0; i < 32; i ++) {
+        this -> x[i] = other.x[i];
+    }
+
+    this -> csr_mstatus  = other.csr_mstatus ;
+    this -> csr_mie      = other.csr_mie     ;
+    this -> csr_mtvec    = other.csr_mtvec   ;
+    this -> csr_mscratch = other.csr_mscratch;
+    this -> csr_mepc     = other.csr_mepc    ;
+    this -> csr_mcause   = other.csr_mcause  ;
+    this -> csr_mtval    = other.csr_mtval   ;
+
+}
+
+
+bool iss::mem_read (uint32_t addr, int size, uint32_t & data) {
+
+    memory_device * d = this -> mem -> get_device_at(addr);
+
+    if(d == NULL || !d -> in_range(addr, size) || !d -> functional_access(addr)) {
+        return false;
+    }
+
+    data = 0;
+
+    for(int i = 0; i < size; i ++) {
+        data |= (uint32_t)d -> read_byte(addr + i) << (8*i);
+    }
+
+    this -> mem_addr  = addr;
+    this -> mem_size  = size;
+    this -> mem_store = false;
+    this -> mem_data  = data;
+
+    return true;
+}
+
+
+bool iss::mem_write(uint32_t addr, int size, uint32_t data) {
+
+    memory_device * d = this -> mem -> get_device_at(addr);
+
+    if(d == NULL || !d -> in_range(addr, size) || !d -> functional_access(addr)) {
+        return false;
+    }
+
+    for(int i = 0; i < size && !d -> functional_discard(addr); i ++) {
+        d -> write_byte(addr + i, (data >> (8*i)) & 0xFF);
+    }
+
+    this -> mem_addr  = addr;
+    this -> mem_size  = size;
+    this -> mem_store = true;
+    this -> mem_data  = size == 4 ? data : data & ((1u << (8*size)) - 1);
+
+    return true;
+}
+
+
+bool iss::csr_access(
+    uint32_t   addr  ,
+    bool       write ,
+    int        op    ,
+    uint32_t   wdata ,
+    uint32_t & rdata
+) {
+    uint32_t * reg;
+    uint32_t   mask = 0xFFFFFFFF;
+
+    if(functional_counters && !write) {
+        switch(addr) {
+            case 0xB00: case 0xB02: case 0xC00: case 0xC01: case 0xC02:
+                rdata = (uint32_t)(instret      );
+                return true;
+            case 0xB80: case 0xB82: case 0xC80: case 0xC81: case 0xC82:
+                rdata = (uint32_t)(instret >> 32);
+                return true;
+        }
+    }
+
+    switch(addr) {
+        case 0x300: reg = &csr_mstatus ; mask = 0x7F8006CC; break;
+        case 0x304: reg = &csr_mie     ; mask = 0x00000888; break;
+        case 0x305: reg = &csr_mtvec   ; break;
+        case 0x340: reg = &csr_mscratch; break;
+        case 0x341: reg = &csr_mepc    ; mask = 0xFFFFFFFE; break;
+        case 0x342: reg = &csr_mcause  ; break;
+        case 0x343: reg = &csr_mtval   ; break;
+        default   : return false;
+    }
+
+    rdata = *reg;
+
+    if(write) {
+
+        uint32_t n = op == 2 ? *reg |  wdata :
+                     op == 3 ? *reg & ~wdata :
+                                       wdata ;
+
+        // mtvec ignores writes of a reserved mode, or an unaligned
+        // vectored base.
+        if(addr == 0x305 && (BIT(n,1) || (BIT(n,0) && (n & 0x7C)))) {
+            return true;
+        }
+
+        *reg = n & mask;
+    }
+
+    return true;
+}
+
+
+bool iss::step() {
+
+    uint32_t lo, hi;
+
+    if(!mem_read(this -> pc, 2, lo)) {
+        return false;
+    }
+
+    // Only data accesses are recorded, not the fetch.
+    this -> mem_size = 0;
+
+    if((lo & 0x3) != 0x3) {
+
+        uint32_t insn = iss_expand_rvc(lo);
+
+        if(insn == 0) {
+            return false;
+        }
+
+        return execute(insn, 2);
+    }
+
+    if(!mem_read(this -> pc + 2, 2, hi)) {
+        return false;
+    }
+
+    this -> mem_size = 0;
+
+    return execute(lo | hi << 16, 4);
+}
+
+
+bool iss::execute(uint32_t i, int len) {
+
+    uint32_t rd     = F_RD (i);
+    uint32_t rs1    = x[F_RS1(i)];
+    uint32_t rs2    = x[F_RS2(i)];
+    uint32_t rs3    = x[F_RS3(i)];
+    uint32_t funct3 = F_FUNCT3(i);
+    uint32_t funct7 = F_FUNCT7(i);
+
+    uint32_t npc    = this -> pc + len;
+    uint32_t result = 0;
+    bool     wb     = true;     // Write result to rd.
+    bool     wide   = false;    // Write result_hi to the odd register too.
+    uint32_t result_hi = 0;
+
+    switch(F_OPCODE(i)) {
+
+    case 0x37: // lui
+        result = IMM_U(i);
+        break;
+
+    case 0x17: // auipc
+        result = this -> pc + IMM_U(i);
+        break;
+
+    case 0x6F: // jal
+        result = npc;
+        npc    = this -> pc + IMM_J(i);
+        break;
+
+    case 0x67: // jalr
+        if(funct3 != 0) return false;
+        result = npc;
+        npc    = (rs1 + IMM_I(i)) & ~1u;
+        break;
+
+    case 0x63: { // branches
+        bool take;
+        switch(funct3) {
+            case 0: take = rs1 == rs2; break;
+            case 1: take = rs1 != rs2; break;
+            case 4: take = (int32_t)rs1 <  (int32_t)rs2; break;
+            case 5: take = (int32_t)rs1 >= (int32_t)rs2; break;
+            case 6: take = rs1 <  rs2; break;
+            case 7: take = rs1 >= rs2; break;
+            default: return false;
+        }
+        if(take) {
+            npc = this -> pc + IMM_B(i);
+        }
+        wb = false;
+        break;
+    }
+
+    case 0x03: { // loads
+        if(funct3 == 7) {
+            if(!execute_xc_ldr(i, result)) return false;
+            break;
+        }
+        uint32_t addr = rs1 + IMM_I(i);
+        uint32_t data;
+        int      size = 1 << (funct3 & 0x3);
+        if(funct3 == 3 || funct3 > 5) return false;
+        if(addr & (size - 1))         return false;
+        if(!mem_read(addr, size, data)) return false;
+        switch(funct3) {
+            case 0: result = sext(data,  8); break;
+            case 1: result = sext(data, 16); break;
+            default: result = data;          break;
+        }
+        break;
+    }
+
+    case 0x23: { // stores, xc.str.* and xc multi-precision arithmetic
+        uint32_t f = i & 0x60070ff;
+        uint64_t r;
+        bool     mp = true;
+        if     (f == 0x4004023) r = (uint64_t)rs1 * rs2 + rs3;         // mmul
+        else if(f == 0x40040a3) r = ((uint64_t)rs1 << 32 | rs2) + rs3; // macc
+        else if(f == 0x6004023) r = (uint64_t)rs1 + rs2 + (rs3 & 1);   // madd
+        else if(f == 0x60050a3) r = (uint64_t)rs1 - rs2 - (rs3 & 1);   // msub
+        else if(f == 0x0005023) r = ror64((uint64_t)rs1 << 32 | rs2,   // mror
+                                          rs3 & 0x3F);
+        else mp = false;
+        if(mp) {
+            // madd / msub produce a single carry / borrow bit.
+            if(f == 0x6004023 || f == 0x60050a3) {
+                r &= 0x1FFFFFFFFULL;
+            }
+            rd        = rd & 0x1E;
+            result    = (uint32_t)r;
+            result_hi = r >> 32;
+            wide      = true;
+            break;
+        }
+        if(funct3 == 4) {
+            // xc.str.b / h / w : mem[rs1 + (rs2 << n)] = rs3
+            uint32_t size_sel = (i >> 7) & 0x1F;
+            if((i & 0x6000000) != 0 || size_sel > 2) return false;
+            int      size = 1 << size_sel;
+            uint32_t addr = rs1 + (rs2 << size_sel);
+            if(addr & (size - 1))           return false;
+            if(!mem_write(addr, size, rs3)) return false;
+        } else {
+            uint32_t addr = rs1 + IMM_S(i);
+            int      size = 1 << funct3;
+            if(funct3 > 2)                  return false;
+            if(addr & (size - 1))           return false;
+            if(!mem_write(addr, size, rs2)) return false;
+        }
+        wb = false;
+        break;
+    }
+
+    case 0x13: { // register-immediate
+        int32_t  imm   = IMM_I(i);
+        uint32_t shamt = F_RS2(i);
+        switch(funct3) {
+            case 0: result = rs1 + imm; break;
+            case 2: result = (int32_t)rs1 < imm; break;
+            case 3: result = rs1 < (uint32_t)imm; break;
+            case 4: result = rs1 ^ imm; break;
+            case 6: result = rs1 | imm; break;
+            case 7: result = rs1 & imm; break;
+            case 1:
+                if     (funct7 == 0x00) result = rs1 << shamt;
+                else if((i & 0xfc00707f) == 0x40001013) // grevi
+                    result = grev32(rs1, shamt);
+                else return false;
+                break;
+            case 5:
+                if     (funct7 == 0x00) result = rs1 >> shamt;
+                else if(funct7 == 0x20) result = (int32_t)rs1 >> shamt;
+                else if((i & 0xfc00707f) == 0x60005013) // rori
+                    result = ror32(rs1, shamt);
+                else if((i & 0x400707f) == 0x4005013) { // fsri
+                    uint64_t v = (uint64_t)rs1 << 32 | rs3;
+                    result = ror64(v, (i >> 20) & 0x3F) >> 32;
+                }
+                else return false;
+                break;
+        }
+        break;
+    }
+
+    case 0x33: { // register-register
+        if((i & 0xfe00707f) == 0x40001033) {        // grev
+            result = grev32(rs1, rs2 & 31);
+        } else if(funct7 == 0x00 || funct7 == 0x20) {
+            switch(funct3 | funct7 >> 2) {
+                case 0x0: result = rs1 + rs2; break;
+                case 0x8: result = rs1 - rs2; break;
+                case 0x1: result = rs1 << (rs2 & 31); break;
+                case 0x2: result = (int32_t)rs1 < (int32_t)rs2; break;
+                case 0x3: result = rs1 < rs2; break;
+                case 0x4: result = rs1 ^ rs2; break;
+                case 0x5: result = rs1 >> (rs2 & 31); break;
+                case 0xD: result = (int32_t)rs1 >> (rs2 & 31); break;
+                case 0x6: result = rs1 | rs2; break;
+                case 0x7: result = rs1 & rs2; break;
+                default : return false;
+            }
+        } else if(funct7 == 0x01) {
+            int64_t  s1 = (int32_t)rs1, s2 = (int32_t)rs2;
+            uint64_t u1 = rs1         , u2 = rs2;
+            switch(funct3) {
+                case 0: result = rs1 * rs2; break;
+                case 1: result = (uint64_t)(s1 * s2) >> 32; break;
+                case 2: result = (uint64_t)(s1 * (int64_t)u2) >> 32; break;
+                case 3: result = (u1 * u2) >> 32; break;
+                case 4:
+                    result = rs2 == 0 ? 0xFFFFFFFF :
+                             (rs1 == 0x80000000 && rs2 == 0xFFFFFFFF) ? rs1 :
+                             (uint32_t)((int32_t)rs1 / (int32_t)rs2);
+                    break;
+                case 5:
+                    result = rs2 == 0 ? 0xFFFFFFFF : rs1 / rs2;
+                    break;
+                case 6:
+                    result = rs2 == 0 ? rs1 :
+                             (rs1 == 0x80000000 && rs2 == 0xFFFFFFFF) ? 0 :
+                             (uint32_t)((int32_t)rs1 % (int32_t)rs2);
+                    break;
+                case 7:
+                    result = rs2 == 0 ? rs1 : rs1 % rs2;
+                    break;
+            }
+        } else if((i & 0xfe00707f) == 0x60005033) { // ror
+            result = ror32(rs1, rs2);
+        } else if((i & 0x600707f) == 0x6005033) {   // cmov
+            result = rs2 ? rs1 : rs3;
+        } else if((i & 0x600707f) == 0x4001033) {   // fsl
+            uint64_t v = (uint64_t)rs1 << 32 | rs3;
+            result = rol64(v, rs2 & 0x3F) >> 32;
+        } else if((i & 0x600707f) == 0x4005033) {   // fsr
+            uint64_t v = (uint64_t)rs1 << 32 | rs3;
+            result = ror64(v, rs2 & 0x3F) >> 32;
+        } else if((i & 0xfe00707f) == 0xa001033) {  // clmul
+            result = clmul64(rs1, rs2);
+        } else if((i & 0xfe00707f) == 0xa003033) {  // clmulh
+            result = clmul64(rs1, rs2) >> 32;
+        } else if((i & 0xfe00707f) == 0x8002033) {  // bdep
+            result = bdep32(rs1, rs2);
+        } else if((i & 0xfe00707f) == 0x8006033) {  // bext
+            result = bext32(rs1, rs2);
+        } else {
+            return false;
+        }
+        break;
+    }
+
+    case 0x0F: // fence, fence.i
+        if(funct3 > 1) return false;
+        wb = false;
+        break;
+
+    case 0x73: { // system
+        if(funct3 == 0) {
+            if(i == 0x30200073) { // mret
+                uint32_t mpie = BIT(csr_mstatus, 7);
+                csr_mstatus   = (csr_mstatus & ~0x88u) | mpie << 3;
+                npc           = csr_mepc;
+                wb            = false;
+                break;
+            }
+            if(rng_responses) {
+                if((i & 0xfff07fff) == 0x00700073) { // xc.rngseed
+                    wb = false;
+                    break;
+                }
+                if((i & 0xfffff07f) == 0x00500073) { // xc.rngsamp
+                    result = rng_data;
+                    break;
+                }
+                if((i & 0xfffff07f) == 0x00300073) { // xc.rngtest
+                    result = rng_stat == rng_status_init_healthy;
+                    break;
+                }
+            }
+            // ecall, ebreak, wfi
+            return false;
+        }
+        if(funct3 == 4) return false;
+        uint32_t src   = funct3 & 0x4 ? F_RS1(i) : rs1;
+        int      op    = funct3 & 0x3;
+        bool     write = op == 1 || F_RS1(i) != 0;
+        if(!csr_access(i >> 20, write, op, src, result)) {
+            return false;
+        }
+        break;
+    }
+
+    default:
+        return false;
+    }
+
+    if(wb && rd != 0) {
+        x[rd] = result;
+    }
+
+    if(wide) {
+        x[rd | 1] = result_hi;
+    }
+
+    this -> pc = npc;
+    this -> instret ++;
+
+    return true;
+}
+
+
+bool iss::execute_xc_ldr(uint32_t i, uint32_t & result) {
+
+    uint32_t rs1 = x[F_RS1(i)];
+    uint32_t rs2 = x[F_RS2(i)];
+    uint32_t f   = i & 0xfe00707f;
+    int      size;
+    bool     sign;
+
+    if((i & 0xffc0707f) == 0xe007003) { // xc.sha256.s0 .. s3
+        switch(F_RS2(i) & 0x3) {
+            case 0: result = ror32(rs1, 7)^ror32(rs1,18)^(rs1 >>  3); break;
+            case 1: result = ror32(rs1,17)^ror32(rs1,19)^(rs1 >> 10); break;
+            case 2: result = ror32(rs1, 2)^ror32(rs1,13)^ror32(rs1,22); break;
+            case 3: result = ror32(rs1, 6)^ror32(rs1,11)^ror32(rs1,25); break;
+        }
+        return true;
+    }
+
+    if     (f == 0x0007003) { size = 1; sign = true ; } // xc.ldr.b
+    else if(f == 0x2007003) { size = 2; sign = true ; } // xc.ldr.h
+    else if(f == 0x4007003) { size = 4; sign = false; } // xc.ldr.w
+    else if(f == 0x8007003) { size = 1; sign = false; } // xc.ldr.bu
+    else if(f == 0xa007003) { size = 2; sign = false; } // xc.ldr.hu
+    else return false;
+
+    int      shift = size == 4 ? 2 : size - 1;
+    uint32_t addr  = rs1 + (rs2 << shift);
+    uint32_t data;
+
+    if(addr & (size - 1))           return false;
+    if(!mem_read(addr, size, data)) return false;
+
+    result = sign ? sext(data, 8*size) : data;
+
+    return true;
+}
+
+
+iss_stop_t iss::run(
+    std::vector<uint32_t> const & stop_pcs,
+    uint64_t                      max_instrs
+) {
+
+    uint64_t count = 0;
+
+    while(true) {
+
+        if(std::find(stop_pcs.begin(), stop_pcs.end(), this -> pc) !=
+           stop_pcs.end()) {
+            return ISS_STOP_PC;
+        }
+
+        if(max_instrs != 0 && count >= max_instrs) {
+            return ISS_STOP_COUNT;
+        }
+
+        if(!this -> step()) {
+            return ISS_STOP_UNSUPPORTED;
+        }
+
+        count ++;
+    }
+
+}
+
+
+std::vector<uint32_t> iss::handoff_code(uint32_t at) const {
+
+    std::vector<uint32_t> code;
+
+    // lui/addi pair loading v into register rd.
+    auto load_imm = [&code](uint32_t rd, uint32_t v) {
+        code.push_back(((v + 0x800) & 0xFFFFF000) | rd << 7 | 0x37);
+        code.push_back(ENC_I(v & 0xFFF, rd, 0, rd, 0x13));
+    };
+
+    // mstatus goes last, with MIE clear, so no interrupt can be taken
+    // while the GPRs are loaded.
+    const uint32_t csrs[][2] = {
+        {0x305, csr_mtvec   },
+        {0x340, csr_mscratch},
+        {0x341, csr_mepc    },
+        {0x342, csr_mcause  },
+        {0x343, csr_mtval   },
+        {0x304, csr_mie     },
+        {0x300, csr_mstatus & ~0x8u}
+    };
+
+    for(auto const & c : csrs) {
+        load_imm(1, c[1]);
+        code.push_back(ENC_I(c[0], 1, 1, 0, 0x73));     // csrrw x0, c, x1
+    }
+
+    for(uint32_t r = 1; r < 32; r ++) {
+        load_imm(r, x[r]);
+    }
+
+    if(BIT(csr_mstatus, 3)) {
+        code.push_back(ENC_I(0x300, 0x8, 6, 0, 0x73));  // csrrsi x0, mstatus, 8
+    }
+
+    int64_t offset = (int64_t)this -> pc - (at + 4*code.size());
+
+    if(offset < -(1 << 20) || offset >= (1 << 20)) {
+        return std::vector<uint32_t>();
+    }
+
+    code.push_back(ENC_J((uint32_t)offset, 0));
+
+    return code;
+}
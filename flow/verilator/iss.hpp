@@ -0,0 +1,164 @@
+
+#include <cstdint>
+#include <vector>
+
+#include "memory_bus.hpp"
+
+#ifndef ISS_HPP
+#define ISS_HPP
+
+//! Why iss::run returned.
+typedef enum iss_stop {
+    ISS_STOP_PC          = 0, //!< Reached one of the stop addresses.
+    ISS_STOP_COUNT       = 1, //!< Executed the requested instruction count.
+    ISS_STOP_UNSUPPORTED = 2  //!< The next instruction is not modelled.
+} iss_stop_t;
+
+/*!
+@brief A functional (not cycle accurate) model of the core, used to
+    fast-forward through program initialisation before handing the
+    architectural state over to the RTL model.
+@details Models RV32IMC, Zicsr, the bitmanip instructions implemented by
+    the core (but for clmulr) and the xcrypto indexed load/store,
+    multi-precision arithmetic and SHA256 instructions. It shares the
+    testbench memory_bus, so memory written by the ISS is seen by the RTL.
+
+    Anything the ISS cannot be sure of doing exactly as the RTL would is
+    left for the RTL. step() returns false without changing any state for:
+    - instructions which are not modelled, including the AES, SHA3,
+      packed, randomness (unless rng_responses is set) and leakage
+      instructions;
+    - anything which would trap (ecall, ebreak, illegal encodings,
+      misaligned or unmapped accesses, including the core's MMIO region);
+    - accesses to devices whose functional_access() is false;
+    - wfi, and reads of the cycle, time and instret counters, so that
+      timing measurements are always made on the RTL, unless
+      functional_counters is set.
+    Stores where functional_discard() is true are stepped over, but have
+    no effect. Interrupts are not modelled.
+*/
+class iss {
+
+public:
+
+    //! Create a new ISS which fetches and accesses data through mem.
+    iss (
+        memory_bus * mem
+    );
+
+    //! Zero all state and set the program counter.
+    void reset(uint32_t pc);
+
+    /*!
+    @brief Execute a single instruction.
+    @returns false, with no state changed, if the instruction must be
+        left for the RTL.
+    */
+    bool step();
+
+    /*!
+    @brief Execute instructions until the program counter matches one of
+        stop_pcs, max_instrs instructions have run, or step() fails.
+    @param in max_instrs - 0 means no limit.
+    */
+    iss_stop_t run(
+        std::vector<uint32_t> const & stop_pcs,
+        uint64_t                      max_instrs
+    );
+
+    //! Copy the architectural state (pc, GPRs, CSRs, instret) of other.
+    void copy_state(iss const & other);
+
+    /*!
+    @brief Build a program which, run by the RTL from address at, puts the
+        RTL into the current ISS state.
+    @details Writes mtvec, mscratch, mepc, mcause, mtval, mie and
+        mstatus (with MIE clear), then x1 to x31, then sets mstatus.MIE if
+        needed and jumps to pc. The jump is the last word of the program.
+    @returns An empty program if pc is out of range of a jal from the end
+        of the program.
+    */
+    std::vector<uint32_t> handoff_code(uint32_t at) const;
+
+    //! Program counter.
+    uint32_t    pc;
+
+    //! General purpose registers. x[0] is always zero.
+    uint32_t    x[32];
+
+    //! Number of instructions executed since reset().
+    uint64_t    instret;
+
+    /*!
+    @brief If set, reads of the cycle, time and instret counters (and
+        their machine mode aliases) return instret, rather than being left
+        to the RTL. For profiling runs, where timing is not measured.
+    */
+    bool        functional_counters = false;
+
+    /*!
+    @brief If set, xc.rngseed, xc.rngsamp and xc.rngtest are executed as
+        if the randomness interface responded with rng_stat and rng_data,
+        rather than being left to the RTL. Used to replay the responses
+        the RTL saw.
+    */
+    bool        rng_responses = false;
+    uint32_t    rng_data      = 0;
+    uint8_t     rng_stat      = 0;
+
+    /*!
+    @brief The data memory access made by the last step() which returned
+        true. mem_size is 0 if it made none.
+    */
+    uint32_t    mem_addr ;
+    int         mem_size ;
+    bool        mem_store;
+    uint32_t    mem_data ; //!< Bytes loaded or stored, not lane shifted.
+
+    // Machine mode CSRs which are handed over to the RTL.
+    uint32_t    csr_mstatus ;
+    uint32_t    csr_mie     ;
+    uint32_t    csr_mtvec   ;
+    uint32_t    csr_mscratch;
+    uint32_t    csr_mepc    ;
+    uint32_t    csr_mcause  ;
+    uint32_t    csr_mtval   ;
+
+protected:
+
+    //! Memory the ISS fetches from and loads / stores to.
+    memory_bus * mem;
+
+    //! Read size bytes, little endian. False if not mapped by one device.
+    bool mem_read (uint32_t addr, int size, uint32_t & data);
+
+    //! Write size bytes, little endian. False if not mapped by one device.
+    bool mem_write(uint32_t addr, int size, uint32_t   data);
+
+    //! Execute a 32-bit instruction of len bytes (2 if it was expanded).
+    bool execute  (uint32_t insn, int len);
+
+    //! Execute the xcrypto instructions sharing the load major opcode.
+    bool execute_xc_ldr(uint32_t insn, uint32_t & result);
+
+    /*!
+    @brief Perform a CSR read and optional write.
+    @returns false if the CSR is not modelled.
+    */
+    bool csr_access(
+        uint32_t   addr  ,
+        bool       write ,
+        int        op    , //!< 1 = write, 2 = set, 3 = clear.
+        uint32_t   wdata ,
+        uint32_t & rdata
+    );
+
+};
+
+/*!
+@brief Expand a 16-bit compressed instruction to its 32-bit equivalent.
+@returns 0 if the encoding is not a valid RV32C instruction.
+*/
+uint32_t iss_expand_rvc(uint16_t c);
+
+#endif
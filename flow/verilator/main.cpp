@@ -6,11 +6,19 @@
 #include <iostream>
 #include <cstdlib>
 #include <cstdio>
+#include <cerrno>
+#include <chrono>
+#include <fstream>
+#include <random>
+
+#include <sys/stat.h>
 
-#include "srec.hpp"
 #include "memory_device.hpp"
 #include "dut_wrapper.hpp"
 #include "testbench.hpp"
+#include "batch.hpp"
+#include "sampling.hpp"
+#include "ct_trace.hpp"
 
 uint32_t    TB_PASS_ADDRESS     = 0;
 uint32_t    TB_FAIL_ADDRESS     = -1;
@@ -19,6 +27,27 @@ bool        quiet               = false;
 
 bool        dump_waves          = false;
 std::string vcd_wavefile_path   = "waves.vcd";
+int         waves_depth         = 99;
+std::string waves_scope         = "";
+dut_wave_trigger_t waves_start;
+dut_wave_trigger_t waves_stop;
+uint64_t    waves_last          = 0;
+bool        roi                 = false;
+std::string pipe_trace_path     = "";
+std::string pipe_trace_json     = "";
+uint64_t    pipe_trace_start    = 0;
+uint64_t    pipe_trace_end      = UINT64_MAX;
+bool        instr_mix_report    = false;
+std::string instr_mix_json      = "";
+std::string instr_log_path      = "";
+bool        dmem_profile_report = false;
+std::string dmem_profile_json   = "";
+uint32_t    dmem_profile_line   = 64;
+uint64_t    dmem_profile_window = 10000;
+std::string dmem_profile_elf    = "";
+bool        mem_stats_report    = false;
+std::string mem_stats_json      = "";
+std::string toggle_path         = "";
 
 bool        dump_signature      = false;
 std::string sig_dump_path      = "signature.sig";
@@ -39,6 +68,42 @@ std::string srec_path           = "";
 uint32_t    max_stall_imem      = 5;
 uint32_t    max_stall_dmem      = 5;
 
+std::string checkpoint_save_path= "";
+uint64_t    checkpoint_save_at  = 0;
+std::string checkpoint_restore  = "";
+
+bool        ff_to_pc            = false;
+uint32_t    ff_pc               = 0;
+uint64_t    ff_instrs           = 0;
+
+bool        cosim_check         = false;
+
+uint32_t    hang_limit          = 1000;
+
+std::string syscall_dir         = "";
+
+bool        wfi_skip            = false;
+
+std::string irq_schedule        = "";
+uint64_t    irq_random          = 0;
+uint32_t    irq_lines           = 1 << IRQ_EXTERNAL;
+uint64_t    irq_seed            = 1;
+
+batch_job_t sample_defaults;
+
+bool        batch_mode          = false;
+std::string batch_list_path     = "";
+std::string batch_results_path  = "batch-results.jsonl";
+unsigned    batch_workers       = 0;
+
+unsigned    ct_runs             = 0;
+uint32_t    ct_input_addr       = 0;
+uint32_t    ct_input_len        = 0;
+std::string ct_input_file       = "";
+uint64_t    ct_seed             = 1;
+std::string ct_dir              = "ct-traces";
+std::string ct_report           = "";
+
 /*
 @brief Responsible for parsing all of the command line arguments.
 */
@@ -61,6 +126,131 @@ void process_arguments(int argc, char ** argv) {
                 std::cout << ">> Dumping waves to: " << vcd_wavefile_path 
                           << std::endl;
                 }
+                size_t dot = fpath.rfind('.');
+                bool   fst = dot != std::string::npos &&
+                             fpath.substr(dot) == ".fst";
+                if(fst != (VM_TRACE_FST != 0)) {
+                    std::cout << ">> Warning: this model writes "
+                              << (VM_TRACE_FST ? "FST" : "VCD")
+                              << " waves. Build it with VL_TRACE_FORMAT="
+                              << (VM_TRACE_FST ? "vcd" : "fst")
+                              << " for the other format." << std::endl;
+                }
+            }
+        }
+        else if(s.find("+WAVES_DEPTH=") != std::string::npos) {
+            waves_depth = std::stoi(s.substr(13));
+        }
+        else if(s.find("+WAVES_SCOPE=") != std::string::npos) {
+            waves_scope = s.substr(13);
+        }
+        else if(s.find("+WAVES_START=") != std::string::npos ||
+                s.find("+WAVES_STOP=" ) != std::string::npos) {
+            bool   start = s.find("+WAVES_START=") != std::string::npos;
+            std::string arg = s.substr(start ? 13 : 12);
+            if(!dut_wave_trigger_parse(arg, start ? waves_start : waves_stop)) {
+                std::cerr << (start ? "+WAVES_START" : "+WAVES_STOP")
+                          << " expects cycle:<N>, pc:<addr>, write:<addr>"
+                          << " or marker:<N>" << std::endl;
+                exit(1);
+            }
+        }
+        else if(s == "+ROI") {
+            roi = true;
+            if(!quiet){
+            std::cout << ">> Only covering the region of interest." << std::endl;
+            }
+        }
+        else if(s == "+INSTR_MIX") {
+            instr_mix_report = true;
+        }
+        else if(s.find("+INSTR_MIX_JSON=") != std::string::npos) {
+            instr_mix_json = s.substr(16);
+            if(!quiet){
+            std::cout << ">> Writing the instruction mix to "
+                      << instr_mix_json << std::endl;
+            }
+        }
+        else if(s.find("+INSTR_LOG=") != std::string::npos) {
+            instr_log_path = s.substr(11);
+            if(!quiet){
+            std::cout << ">> Logging retired instructions to "
+                      << instr_log_path << std::endl;
+            }
+        }
+        else if(s.find("+TOGGLE=") != std::string::npos) {
+            toggle_path = s.substr(8);
+            if(!quiet){
+            std::cout << ">> Writing toggle counts to " << toggle_path
+                      << std::endl;
+            }
+        }
+        else if(s == "+MEM_STATS") {
+            mem_stats_report = true;
+        }
+        else if(s.find("+MEM_STATS_JSON=") != std::string::npos) {
+            mem_stats_json = s.substr(16);
+            if(!quiet){
+            std::cout << ">> Writing memory port statistics to "
+                      << mem_stats_json << std::endl;
+            }
+        }
+        else if(s == "+DMEM_PROFILE") {
+            dmem_profile_report = true;
+        }
+        else if(s.find("+DMEM_PROFILE_JSON=") != std::string::npos) {
+            dmem_profile_json = s.substr(19);
+            if(!quiet){
+            std::cout << ">> Writing the data memory profile to "
+                      << dmem_profile_json << std::endl;
+            }
+        }
+        else if(s.find("+DMEM_PROFILE_ELF=") != std::string::npos) {
+            dmem_profile_elf = s.substr(18);
+        }
+        else if(s.find("+DMEM_PROFILE_LINE=") != std::string::npos) {
+            dmem_profile_line = std::stoul(s.substr(19),NULL,0);
+            if(!dmem_profile_line_ok(dmem_profile_line)) {
+                std::cerr << "+DMEM_PROFILE_LINE expects a power of two"
+                          << " of at least 4 bytes" << std::endl;
+                exit(1);
+            }
+        }
+        else if(s.find("+DMEM_PROFILE_WINDOW=") != std::string::npos) {
+            dmem_profile_window = std::stoull(s.substr(21),NULL,0);
+            if(dmem_profile_window == 0) {
+                std::cerr << "+DMEM_PROFILE_WINDOW expects a number of"
+                          << " cycles" << std::endl;
+                exit(1);
+            }
+        }
+        else if(s.find("+PIPE_TRACE=") != std::string::npos) {
+            pipe_trace_path = s.substr(12);
+            if(!quiet){
+            std::cout << ">> Tracing the pipeline to " << pipe_trace_path
+                      << std::endl;
+            }
+        }
+        else if(s.find("+PIPE_TRACE_JSON=") != std::string::npos) {
+            pipe_trace_json = s.substr(17);
+            if(!quiet){
+            std::cout << ">> Tracing the pipeline to " << pipe_trace_json
+                      << std::endl;
+            }
+        }
+        else if(s.find("+PIPE_TRACE_WINDOW=") != std::string::npos) {
+            if(!pipe_trace_window_parse(s.substr(19), pipe_trace_start,
+                                        pipe_trace_end)) {
+                std::cerr << "+PIPE_TRACE_WINDOW expects <start>:<end>"
+                          << " or <start>:" << std::endl;
+                exit(1);
+            }
+        }
+        else if(s.find("+WAVES_LAST=") != std::string::npos) {
+            waves_last = std::stoull(s.substr(12),NULL,0);
+            if(!quiet){
+            std::cout << ">> Keeping the last " << std::dec << waves_last
+                      << " cycles for the waves of a failing run." << std::endl;
             }
         }
         else if(s.find("+TIMEOUT=") != std::string::npos) {
@@ -140,6 +330,148 @@ void process_arguments(int argc, char ** argv) {
                 }
             }
         }
+        else if(s.find("+SAVE_AT=") != std::string::npos) {
+            std::string arg   = s.substr(9);
+            size_t      colon = arg.find(':');
+            if(colon == std::string::npos) {
+                std::cerr << "+SAVE_AT expects <cycle>:<file>" << std::endl;
+                exit(1);
+            }
+            checkpoint_save_at   = std::stoul(arg.substr(0,colon),NULL,0);
+            checkpoint_save_path = arg.substr(colon+1);
+            if(!quiet){
+            std::cout << ">> Checkpoint at cycle " << std::dec
+                      << checkpoint_save_at << " to: " << checkpoint_save_path
+                      << std::endl;
+            }
+        }
+        else if(s.find("+RESTORE=") != std::string::npos) {
+            checkpoint_restore = s.substr(9);
+            if(!quiet){
+            std::cout << ">> Restore from checkpoint: " << checkpoint_restore
+                      << std::endl;
+            }
+        }
+        else if(s.find("+FF_PC=") != std::string::npos) {
+            std::string addr = s.substr(7);
+            ff_pc    = std::stoul(addr,NULL,0) & 0xFFFFFFFF;
+            ff_to_pc = true;
+            if(!quiet){
+            std::cout << ">> Fast-forward to: 0x" << std::hex << ff_pc
+                      << std::endl;
+            }
+        }
+        else if(s.find("+FF_INSTRS=") != std::string::npos) {
+            ff_instrs = std::stoull(s.substr(11),NULL,0);
+            if(!quiet){
+            std::cout << ">> Fast-forward at most " << std::dec << ff_instrs
+                      << " instructions." << std::endl;
+            }
+        }
+        else if(s.find("+HANG_LIMIT=") != std::string::npos) {
+            hang_limit = std::stoul(s.substr(12),NULL,0);
+        }
+        else if(s.find("+SYSCALL_DIR=") != std::string::npos) {
+            syscall_dir = s.substr(13);
+            if(!quiet){
+            std::cout << ">> Program files are in " << syscall_dir
+                      << std::endl;
+            }
+        }
+        else if(s.find("+IRQ_SCHEDULE=") != std::string::npos) {
+            irq_schedule = s.substr(14);
+            if(!quiet){
+            std::cout << ">> Interrupt schedule: " << irq_schedule
+                      << std::endl;
+            }
+        }
+        else if(s.find("+IRQ_RANDOM=") != std::string::npos) {
+            std::string arg   = s.substr(12);
+            size_t      colon = arg.find(':');
+            irq_random = std::stoull(arg.substr(0,colon),NULL,0);
+            if(colon != std::string::npos) {
+                irq_lines  = irq_lines_from_names(arg.substr(colon+1));
+            }
+            if(!quiet){
+            std::cout << ">> Random interrupts every " << std::dec
+                      << irq_random << " cycles on average." << std::endl;
+            }
+        }
+        else if(s.find("+IRQ_SEED=") != std::string::npos) {
+            irq_seed = std::stoull(s.substr(10),NULL,0);
+        }
+        else if(s == "+WFI_SKIP") {
+            wfi_skip = true;
+            if(!quiet){
+            std::cout << ">> Skipping idle cycles in WFI." << std::endl;
+            }
+        }
+        else if(s == "+COSIM") {
+            cosim_check = true;
+            if(!quiet){
+            std::cout << ">> Co-simulating against the ISS." << std::endl;
+            }
+        }
+        else if(s.find("+SAMPLE=") != std::string::npos) {
+            sample_defaults.sample_interval = std::stoull(s.substr(8),NULL,0);
+            if(!quiet){
+            std::cout << ">> Sampled simulation, intervals of " << std::dec
+                      << sample_defaults.sample_interval << " instructions."
+                      << std::endl;
+            }
+        }
+        else if(s.find("+SAMPLE_WARMUP=") != std::string::npos) {
+            sample_defaults.sample_warmup = std::stoull(s.substr(15),NULL,0);
+        }
+        else if(s.find("+SAMPLE_PHASES=") != std::string::npos) {
+            sample_defaults.sample_phases = std::stoul(s.substr(15));
+        }
+        else if(s.find("+SAMPLE_PER_PHASE=") != std::string::npos) {
+            sample_defaults.sample_per_phase = std::stoul(s.substr(18));
+            if(sample_defaults.sample_per_phase == 0) {
+                std::cerr << "+SAMPLE_PER_PHASE expects at least one"
+                          << " interval" << std::endl;
+                exit(1);
+            }
+        }
+        else if(s.find("+SAMPLE_REPORT=") != std::string::npos) {
+            sample_defaults.sample_report = s.substr(15);
+        }
+        else if(s.find("+BATCH=") != std::string::npos) {
+            batch_list_path = s.substr(7);
+            batch_mode      = true;
+        }
+        else if(s.find("+BATCH_RESULTS=") != std::string::npos) {
+            batch_results_path = s.substr(15);
+        }
+        else if(s.find("+BATCH_JOBS=") != std::string::npos) {
+            batch_workers = std::stoul(s.substr(12));
+        }
+        else if(s.find("+CT_RUNS=") != std::string::npos) {
+            ct_runs = std::stoul(s.substr(9));
+        }
+        else if(s.find("+CT_INPUT=") != std::string::npos) {
+            std::string arg   = s.substr(10);
+            size_t      colon = arg.find(':');
+            if(colon == std::string::npos) {
+                std::cerr << "+CT_INPUT expects <addr>:<bytes>" << std::endl;
+                exit(1);
+            }
+            ct_input_addr = std::stoul(arg.substr(0, colon), NULL, 0);
+            ct_input_len  = std::stoul(arg.substr(colon + 1), NULL, 0);
+        }
+        else if(s.find("+CT_INPUT_FILE=") != std::string::npos) {
+            ct_input_file = s.substr(15);
+        }
+        else if(s.find("+CT_SEED=") != std::string::npos) {
+            ct_seed = std::stoull(s.substr(9), NULL, 0);
+        }
+        else if(s.find("+CT_DIR=") != std::string::npos) {
+            ct_dir = s.substr(8);
+        }
+        else if(s.find("+CT_REPORT=") != std::string::npos) {
+            ct_report = s.substr(11);
+        }
         else if(s == "+q") {
             quiet = true;
         }
@@ -148,6 +480,51 @@ void process_arguments(int argc, char ** argv) {
             << "\t+q                            -" << std::endl
             << "\t+IMEM=<srec input file path>  -" << std::endl
             << "\t+WAVES=<VCD dump file path>   -" << std::endl
+            << "\t+WAVES_DEPTH=<N>              - Dump N levels of hierarchy."
+            << " Default: 99." << std::endl
+            << "\t+WAVES_SCOPE=<scope>[,...]    - Only dump these scopes,"
+            << " e.g. TOP.frv_core.i_pipeline." << std::endl
+            << "\t+WAVES_START=<trigger>        - Start dumping waves on"
+            << " cycle:<N>, pc:<addr>, write:<addr>" << std::endl
+            << "\t                                or marker:<N> (a write to"
+            << " the exit device's MARKER register)." << std::endl
+            << "\t+WAVES_STOP=<trigger>         - Stop dumping waves."
+            << std::endl
+            << "\t+WAVES_LAST=<N>               - Only write waves for a"
+            << " failing run, from at least N cycles before the end."
+            << std::endl
+            << "\t+ROI                          - Only dump waves and"
+            << " statistics between the program's ROI markers." << std::endl
+            << "\t+INSTR_MIX                    - Report retired"
+            << " instructions and cycles by class and mnemonic." << std::endl
+            << "\t+INSTR_MIX_JSON=<file>        - Write them as JSON."
+            << std::endl
+            << "\t+INSTR_LOG=<file>             - Log each retired"
+            << " instruction, disassembled." << std::endl
+            << "\t+TOGGLE=<file>                - Write each signal's toggle"
+            << " count. Needs a VL_TOGGLE=1 model. With +ROI, from the"
+            << " first ROI begin to the last ROI end, gaps included."
+            << std::endl
+            << "\t+MEM_STATS                    - Report traffic, latency"
+            << " and idle cycles of the memory ports." << std::endl
+            << "\t+MEM_STATS_JSON=<file>        - Write them as JSON."
+            << std::endl
+            << "\t+DMEM_PROFILE                 - Report data memory"
+            << " accesses, stack depth and working set." << std::endl
+            << "\t+DMEM_PROFILE_JSON=<file>     - Write them as JSON."
+            << std::endl
+            << "\t+DMEM_PROFILE_ELF=<file>      - Also report each data"
+            << " object of this program." << std::endl
+            << "\t+DMEM_PROFILE_LINE=<bytes>    - Heatmap line size."
+            << " Default 64." << std::endl
+            << "\t+DMEM_PROFILE_WINDOW=<N>      - Working set window in"
+            << " cycles. Default 10000." << std::endl
+            << "\t+PIPE_TRACE=<file>            - Trace the pipeline for"
+            << " the Konata viewer." << std::endl
+            << "\t+PIPE_TRACE_JSON=<file>       - Trace the pipeline as"
+            << " Chrome trace events, for Perfetto." << std::endl
+            << "\t+PIPE_TRACE_WINDOW=<N>:<M>    - Only trace instructions"
+            << " entering decode in cycles N to M." << std::endl
             << "\t+TIMEOUT=<timeout after N>    -" << std::endl
             << "\t+PASS_ADDR=<hex number>       -" << std::endl
             << "\t+FAIL_ADDR=<hex number>       -" << std::endl
@@ -155,6 +532,59 @@ void process_arguments(int argc, char ** argv) {
             << "\t+SIG_END=<hex number>       -" << std::endl
             << "\t+REG_ADDR=<hex number>       -" << std::endl
             << "\t+SIG_PATH=<filepath>         -" << std::endl
+            << "\t+SAVE_AT=<cycle>:<filepath>   - Checkpoint the simulation."
+            << std::endl
+            << "\t+RESTORE=<filepath>           - Start from a checkpoint."
+            << std::endl
+            << "\t+FF_PC=<hex number>           - Run on the ISS up to here,"
+            << " then switch to the RTL." << std::endl
+            << "\t+FF_INSTRS=<N>                - Run at most N instructions"
+            << " on the ISS first." << std::endl
+            << "\t+HANG_LIMIT=<N>               - Stop if one instruction"
+            << " retires N times in a row. 0: never. Default: 1000."
+            << std::endl
+            << "\t+SYSCALL_DIR=<dir>            - Directory the program can"
+            << " open files in." << std::endl
+            << "\t+IRQ_SCHEDULE=<filepath>      - Raise interrupts at the"
+            << " cycles listed in the file." << std::endl
+            << "\t+IRQ_RANDOM=<N>[:<lines>]     - Raise interrupts every N"
+            << " cycles on average, on a comma" << std::endl
+            << "\t                                separated list of nmi,"
+            << " external, software. Default: external." << std::endl
+            << "\t+IRQ_SEED=<N>                 - Seed for +IRQ_RANDOM."
+            << std::endl
+            << "\t+WFI_SKIP                     - Skip to the timer interrupt"
+            << " when the core sleeps in a WFI." << std::endl
+            << "\t+COSIM                        - Check every instruction"
+            << " against the ISS." << std::endl
+            << "\t+SAMPLE=<N>                   - Estimate cycles by running"
+            << " only representative N instruction intervals." << std::endl
+            << "\t+SAMPLE_WARMUP=<N>            - Warm-up instructions per"
+            << " sample. Default: 2000." << std::endl
+            << "\t+SAMPLE_PHASES=<N>            - Maximum program phases."
+            << " Default: 10." << std::endl
+            << "\t+SAMPLE_PER_PHASE=<N>         - Samples per phase."
+            << " Default: 2." << std::endl
+            << "\t+SAMPLE_REPORT=<filepath>     - JSON sampling report."
+            << std::endl
+            << "\t+BATCH=<list file path>       - Run many tests. Other"
+            << " arguments give per-test defaults." << std::endl
+            << "\t+BATCH_RESULTS=<filepath>     - JSON lines batch results."
+            << std::endl
+            << "\t+BATCH_JOBS=<N>               - Batch worker processes."
+            << " Default: one per CPU." << std::endl
+            << "\t+CT_RUNS=<N>                  - Run N times on different"
+            << " inputs and compare their timing." << std::endl
+            << "\t+CT_INPUT=<addr>:<bytes>      - Write this many random"
+            << " bytes here before each run." << std::endl
+            << "\t+CT_INPUT_FILE=<filepath>     - Or one <addr>:<hex> input"
+            << " per line, a run each." << std::endl
+            << "\t+CT_SEED=<N>                  - Seed for the random inputs."
+            << " Default: 1." << std::endl
+            << "\t+CT_DIR=<dir>                 - Where to write the runs'"
+            << " traces. Default: ct-traces." << std::endl
+            << "\t+CT_REPORT=<filepath>         - JSON timing comparison."
+            << std::endl
             ;
             exit(0);
         }
@@ -162,27 +592,21 @@ void process_arguments(int argc, char ** argv) {
 }
 
 
-void load_srec_file (
-    memory_bus * mem
-) {
-    std::cout <<">> Loading srec: " << srec_path << std::endl;
-
-    srec::srec_file fh(srec_path);
-
-    for(auto it  = fh.data.begin();
-             it != fh.data.end();
-             it ++) {
-        mem -> write_byte(it -> first, it -> second);
-    }
-}
-
 //! Write out the memory signature for verification
 void dump_signature_file (
-    memory_bus *mem
+    memory_bus  *mem,
+    std::string  sig_dump_path,
+    uint32_t     SIG_START,
+    uint32_t     SIG_END
 ) {
 
     FILE * fh = fopen(sig_dump_path.c_str(),"w");
 
+    if(fh == NULL) {
+        std::cerr << "Could not open " << sig_dump_path << std::endl;
+        return;
+    }
+
     for(uint32_t i = SIG_START; i < SIG_END; i+=4) {
         
         fprintf(fh,"%02x", mem -> read_byte(i+3));
@@ -211,12 +635,20 @@ int a2h(char c)
 
 //! Verify the in-memory signature against the supplied file
 bool verif_signature_file (
-    memory_bus *mem
+    memory_bus  *mem,
+    std::string  sig_verif_path,
+    uint32_t     SIG_START,
+    uint32_t     SIG_END
 ) {
     std::cout << ">> Checking signature..." << std::endl;
 
     FILE * fh = fopen(sig_verif_path.c_str(),"r");
 
+    if(fh == NULL) {
+        std::cout << ">> Could not open " << sig_verif_path << std::endl;
+        return false;
+    }
+
     bool result = true;
 
     std::cout<<">> Address  Reference    Dut"<<std::endl;
@@ -259,31 +691,209 @@ bool verif_signature_file (
     return result;
 }
 
+/*!
+@brief Replay the end of a failing run from a flight recorder checkpoint,
+    dumping waves up to the cycle it stopped at.
+*/
+static void flight_replay (
+    batch_job_t    const & job      ,
+    batch_result_t const & failed   ,
+    std::string            from
+) {
+
+    if(from == "") {
+        std::cout << ">> No flight recorder checkpoint to replay" << std::endl;
+        return;
+    }
+
+    std::cout << ">> Replaying the end of the run to dump waves to "
+              << job.waves << std::endl;
+
+    // Everything the checkpoint does not hold is configured as before,
+    // but only the waves are written.
+    batch_job_t replay = batch_job_inputs(job);
+
+    replay.restore    = from;
+    replay.timeout    = failed.cycles;
+    replay.waves      = job.waves;
+
+    // The input was written at the start of the run, and may since have
+    // been changed by the program.
+    replay.ct_input.clear();
+
+    batch_result_t result;
+
+    run_job(replay, result, NULL);
+
+}
+
+
 /*
-@brief Top level simulation function.
+@brief Run a single test to completion.
+@details Used for both the single test and batch modes.
 */
-int main(int argc, char** argv) {
+batch_status_t run_job (
+    batch_job_t    & job    ,
+    batch_result_t & result ,
+    testbench      * reuse
+) {
+    
+    if(job.sample_interval > 0) {
+        return sample_job(job, result, reuse);
+    }
 
-    printf("> ");
-    for(int i = 0; i < argc; i ++) {
-        printf("%s ",argv[i]);
+    auto wall_start = std::chrono::steady_clock::now();
+
+    if(job.imem != "" && !std::ifstream(job.imem).good()) {
+        std::cout << ">> Could not open " << job.imem << std::endl;
+        result.status = BATCH_ERROR;
+        return result.status;
     }
-    printf("\n");
 
-    process_arguments(argc, argv);
+    // Tests which dump waves get a model of their own, so the wave file
+    // is opened when the model is built. With a flight recorder, waves are
+    // only dumped by the replay of a failing run.
+    testbench * fresh = NULL;
+    bool        waves = job.waves != "" && job.waves_last == 0;
+
+    if(reuse == NULL || waves) {
+        fresh = new testbench(waves ? job.waves : "", waves,
+                              job.waves_depth, job.waves_scope);
+    }
 
-    testbench tb (vcd_wavefile_path, dump_waves);
+    testbench & tb = fresh ? *fresh : *reuse;
 
-    if(load_srec) {
-        load_srec_file(tb.bus);
+    // Armed by the reset / restore below.
+    tb.dut -> waves_start = job.waves_start;
+    tb.dut -> waves_stop  = job.waves_stop;
+
+    if(job.restore != "") {
+        // The checkpoint holds the memory contents, so no image is loaded.
+        std::cout <<">> Restoring checkpoint: " << job.restore << std::endl;
+        tb.reset();
+        if(!tb.restore_checkpoint(job.restore)) {
+            std::cout << ">> Could not restore " << job.restore << std::endl;
+            delete fresh;
+            result.status = BATCH_ERROR;
+            return result.status;
+        }
+    } else if(job.imem != "") {
+        std::cout <<">> Loading srec: " << job.imem << std::endl;
+        tb.reset_and_load(job.imem);
+    } else {
+        tb.reset();
+    }
+
+    tb.save_path     = job.save_path;
+    tb.save_at_cycle = job.save_at;
+
+    tb.pass_address = job.pass_address;
+    tb.fail_address = job.fail_address;
+    tb.max_sim_time = job.timeout * 10;
+    tb.cosim_enable = job.cosim && job.restore == "";
+    tb.hang_limit   = job.hang_limit;
+    tb.syscalls -> sandbox = job.syscall_dir;
+    tb.wfi_skip     = job.wfi_skip;
+    tb.dut -> roi_enable = job.roi;
+
+    if(job.waves != "" && job.waves_last) {
+        tb.flight_period = job.waves_last;
+        tb.flight_path   = job.waves + ".flight";
     }
 
-    tb.pass_address = TB_PASS_ADDRESS;
-    tb.fail_address = TB_FAIL_ADDRESS;
-    tb.max_sim_time = max_sim_time;
+    tb.dut -> irq_if_agent -> set_random(job.irq_random, job.irq_lines,
+                                         job.irq_seed);
 
-    tb.dut -> set_imem_max_stall(max_stall_imem);
-    tb.dut -> set_dmem_max_stall(max_stall_dmem);
+    if(job.irq_schedule != "" &&
+       !tb.dut -> irq_if_agent -> load_schedule(job.irq_schedule)) {
+        delete fresh;
+        result.status = BATCH_ERROR;
+        return result.status;
+    }
+
+    if(job.cosim && job.restore != "") {
+        std::cout << ">> Runs restored from a checkpoint are not co-simulated"
+                  << std::endl;
+    }
+
+    // A restored checkpoint already starts part way through the program.
+    if(job.restore == "" && (job.ff_to_pc || job.ff_instrs > 0)) {
+        if(!tb.fast_forward(job.ff_to_pc, job.ff_pc, job.ff_instrs)) {
+            delete fresh;
+            result.status = BATCH_ERROR;
+            return result.status;
+        }
+    }
+
+    tb.dut -> set_imem_max_stall(job.max_stall_imem);
+    tb.dut -> set_dmem_max_stall(job.max_stall_dmem);
+
+    // After loading, so the same image or checkpoint runs on each input.
+    for(size_t i = 0; i < job.ct_input.size(); i ++) {
+        tb.bus -> write_byte(job.ct_input_addr + i, job.ct_input[i]);
+    }
+
+    pipe_trace * tracer = NULL;
+
+    if(job.pipe_trace != "" || job.pipe_trace_json != "") {
+        tracer = new pipe_trace();
+        tracer -> window_start = job.pipe_trace_start;
+        tracer -> window_end   = job.pipe_trace_end;
+        if(!tracer -> open(job.pipe_trace, job.pipe_trace_json)) {
+            std::cout << ">> Could not open the pipeline trace" << std::endl;
+            delete tracer;
+            delete fresh;
+            result.status = BATCH_ERROR;
+            return result.status;
+        }
+        tb.dut -> pipe_tracer = tracer;
+    }
+
+    instr_mix * mix = NULL;
+
+    if(job.instr_mix || job.instr_mix_json != "") {
+        mix = new instr_mix(tb.get_sim_time() / 10);
+        tb.dut -> mix = mix;
+    }
+
+    dmem_profile * dmem_prof = NULL;
+
+    if(job.dmem_profile || job.dmem_profile_json != "") {
+        dmem_prof = new dmem_profile(tb.get_sim_time() / 10,
+                                     job.dmem_profile_line,
+                                     job.dmem_profile_window);
+        if(job.dmem_profile_elf != "" &&
+           !dmem_prof -> add_symbols(job.dmem_profile_elf)) {
+            std::cout << ">> Could not read symbols from "
+                      << job.dmem_profile_elf << std::endl;
+        }
+        tb.dut -> dmem_prof = dmem_prof;
+    }
+
+    if(job.toggle != "") {
+        tb.dut -> toggle_path = job.toggle;
+        tb.dut -> toggle_start();
+    }
+
+    ct_trace * ct = NULL;
+
+    if(job.ct_trace != "") {
+        ct = new ct_trace(tb.get_sim_time() / 10);
+        if(!ct -> open(job.ct_trace)) {
+            std::cout << ">> Could not open " << job.ct_trace << std::endl;
+        }
+        tb.dut -> ct = ct;
+    }
+
+    FILE * instr_log = NULL;
+
+    if(job.instr_log != "") {
+        instr_log = fopen(job.instr_log.c_str(), "w");
+        if(!instr_log) {
+            std::cout << ">> Could not open " << job.instr_log << std::endl;
+        }
+        tb.dut -> instr_log = instr_log;
+    }
 
     tb.run_simulation();
 
@@ -291,37 +901,327 @@ int main(int argc, char** argv) {
               << std::dec<<tb.get_sim_time()/10
               << " simulated clock cycles" << std::endl;
 
-    if(dump_signature) {
-        dump_signature_file(tb.bus);
+    if(tb.dut -> irq_if_agent -> enabled()) {
+        tb.dut -> irq_if_agent -> report(std::cout);
+    }
+
+    if(tb.dut -> roi_entries) {
+        std::cout << ">> Region of interest: " << std::dec
+                  << tb.dut -> roi_cycles() << " simulated clock cycles, "
+                  << tb.dut -> roi_instrs << " instructions" << std::endl;
+    }
+
+    if(tracer) {
+        std::cout << ">> Traced " << std::dec << tracer -> traced
+                  << " instructions through the pipeline" << std::endl;
+        tb.dut -> pipe_tracer = NULL;
+        delete tracer;
+    }
+
+    if(mix) {
+        if(job.instr_mix) {
+            mix -> report(std::cout);
+        }
+        if(job.instr_mix_json != "" && !mix -> write_json(job.instr_mix_json)) {
+            std::cout << ">> Could not write " << job.instr_mix_json
+                      << std::endl;
+        }
+        tb.dut -> mix = NULL;
+        delete mix;
+    }
+
+    if(instr_log) {
+        tb.dut -> instr_log = NULL;
+        fclose(instr_log);
+    }
+
+    if(job.mem_stats) {
+        tb.dut -> mem_stats_report(std::cout);
+    }
+
+    if(job.toggle != "") {
+        if(!tb.dut -> toggle_finish()) {
+            std::cout << ">> Could not write " << job.toggle << std::endl;
+        }
+        tb.dut -> toggle_path = "";
+    }
+
+    if(job.mem_stats_json != "" && !tb.dut -> mem_stats_json(job.mem_stats_json)) {
+        std::cout << ">> Could not write " << job.mem_stats_json << std::endl;
+    }
+
+    if(dmem_prof) {
+        dmem_prof -> finish(tb.get_sim_time() / 10);
+        if(job.dmem_profile) {
+            dmem_prof -> report(std::cout);
+        }
+        if(job.dmem_profile_json != "" &&
+           !dmem_prof -> write_json(job.dmem_profile_json)) {
+            std::cout << ">> Could not write " << job.dmem_profile_json
+                      << std::endl;
+        }
+        tb.dut -> dmem_prof = NULL;
+        delete dmem_prof;
+    }
+
+    if(tb.wfi_skipped) {
+        std::cout << ">> Skipped " << std::dec << tb.wfi_skipped
+                  << " idle cycles in WFI" << std::endl;
+    }
+
+    if(job.sig_path != "") {
+        dump_signature_file(tb.bus, job.sig_path, job.sig_start, job.sig_end);
     }
 
     bool verif_result = true;
 
-    if(verif_signature) {
-        verif_result = verif_signature_file(tb.bus);
+    if(job.sig_verif != "") {
+        verif_result = verif_signature_file(
+            tb.bus, job.sig_verif, job.sig_start, job.sig_end
+        );
         tb.sim_passed &= verif_result;
     }
 
-    if(tb.get_sim_time() >= max_sim_time) {
+    result.cycles    = tb.get_sim_time() / 10;
+    result.roi_cycles= tb.dut -> roi_cycles();
+    result.roi_instrs= tb.dut -> roi_instrs;
+
+    if(tb.sim_exited) {
+        std::cout << ">> Exit code " << std::dec << tb.exit_code << std::endl;
+        result.program_exit = tb.exit_code;
+    }
+
+    if(tb.cosim_failed) {
+
+        std::cout << ">> COSIM FAIL" << std::endl;
+        result.status = BATCH_COSIM_FAIL;
+
+    } else if(tb.sim_hung) {
+
+        std::cout << ">> HANG" << std::endl;
+        result.status = BATCH_HANG;
+
+    } else if(tb.get_sim_time() >= tb.max_sim_time) {
         
         std::cout << ">> TIMEOUT" << std::endl;
-        return 1;
+        result.status = BATCH_TIMEOUT;
 
     } else if(tb.sim_passed) {
         
         std::cout << ">> SIM PASS" << std::endl;
-        return 0;
+        result.status = BATCH_PASS;
 
     } else if(!verif_result) {
         
         std::cout << ">> SIG FAIL" << std::endl;
-        return 3;
+        result.status = BATCH_SIG_FAIL;
         
     } else {
 
         std::cout << ">> SIM FAIL" << std::endl;
-        return 2;
+        result.status = BATCH_FAIL;
+
+    }
+
+    if(ct) {
+        ct -> finish(job.roi ? result.roi_cycles : result.cycles,
+                     result.status);
+        tb.dut -> ct = NULL;
+        delete ct;
+    }
+
+    if(tb.flight_period) {
+        if(result.status != BATCH_PASS) {
+            flight_replay(job, result, tb.flight_checkpoint());
+        }
+        tb.flight_clear();
+        tb.flight_period = 0;
+    }
+
+    delete fresh;
+
+    std::chrono::duration<double> wall =
+        std::chrono::steady_clock::now() - wall_start;
+    result.wall_time = wall.count();
+
+    return result.status;
+}
+
+/*!
+@brief Run one program many times on different secret inputs, across the
+    batch workers, and compare the timing of the runs.
+@details Each run's input is written to memory after the image is loaded
+    or the checkpoint restored, so only it differs between runs.
+@returns 0 if every run passed and no timing differences were found.
+*/
+static int ct_mode(batch_job_t const & defaults) {
+
+    std::vector<batch_job_t> jobs;
+
+    if(ct_input_file != "") {
+
+        std::ifstream in(ct_input_file);
+
+        if(!in.good()) {
+            std::cerr << "Could not open " << ct_input_file << std::endl;
+            return 1;
+        }
+
+        std::string line;
+        unsigned    lineno = 0;
+
+        while(std::getline(in, line) && (!ct_runs || jobs.size() < ct_runs)) {
+            lineno ++;
+            line.erase(line.find_last_not_of(" \t\r") + 1);
+            if(line == "" || line[0] == '#') {
+                continue;
+            }
+            batch_job_t job = defaults;
+            if(!ct_input_parse(line, job.ct_input_addr, job.ct_input)) {
+                std::cerr << ct_input_file << ":" << lineno
+                          << ": expected <addr>:<hex bytes>" << std::endl;
+                return 1;
+            }
+            jobs.push_back(job);
+        }
+
+    } else {
+
+        std::mt19937_64 rng(ct_seed);
+
+        for(unsigned i = 0; i < ct_runs; i ++) {
+            batch_job_t job   = defaults;
+            job.ct_input_addr = ct_input_addr;
+            for(uint32_t b = 0; b < ct_input_len; b ++) {
+                job.ct_input.push_back(rng() & 0xFF);
+            }
+            jobs.push_back(job);
+        }
+
+    }
+
+    if(jobs.size() < 2) {
+        std::cerr << "Timing comparison needs at least two runs" << std::endl;
+        return 1;
+    }
+
+    if(mkdir(ct_dir.c_str(), 0777) != 0 && errno != EEXIST) {
+        std::cerr << "Could not create " << ct_dir << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> traces;
 
+    for(size_t i = 0; i < jobs.size(); i ++) {
+        jobs[i].name     = "ct-" + std::to_string(i);
+        jobs[i].ct_trace = ct_dir + "/run-" + std::to_string(i) + ".trace";
+        traces.push_back(jobs[i].ct_trace);
     }
 
+    int status = batch_run(jobs, ct_dir + "/results.jsonl", batch_workers,
+                           quiet);
+
+    std::cout << ">> Comparing the timing of " << std::dec << jobs.size()
+              << " runs" << std::endl;
+
+    bool constant = ct_analyse(traces, std::cout, ct_report);
+
+    return status || !constant;
+
+}
+
+
+/*
+@brief Top level simulation function.
+*/
+int main(int argc, char** argv) {
+
+    printf("> ");
+    for(int i = 0; i < argc; i ++) {
+        printf("%s ",argv[i]);
+    }
+    printf("\n");
+
+    process_arguments(argc, argv);
+
+    // Command line arguments act as the defaults for every batch job.
+    batch_job_t job    = sample_defaults;
+    job.imem           = load_srec      ? srec_path         : "";
+    job.pass_address   = TB_PASS_ADDRESS;
+    job.fail_address   = TB_FAIL_ADDRESS;
+    job.timeout        = max_sim_time / 10;
+    job.sig_start      = SIG_START;
+    job.sig_end        = SIG_END;
+    job.sig_path       = dump_signature ? sig_dump_path     : "";
+    job.sig_verif      = verif_signature? sig_verif_path    : "";
+    job.waves          = dump_waves     ? vcd_wavefile_path : "";
+    job.waves_depth    = waves_depth;
+    job.waves_scope    = waves_scope;
+    job.waves_start    = waves_start;
+    job.waves_stop     = waves_stop;
+    job.waves_last     = waves_last;
+    job.roi            = roi;
+    job.pipe_trace     = pipe_trace_path;
+    job.pipe_trace_json= pipe_trace_json;
+    job.pipe_trace_start = pipe_trace_start;
+    job.pipe_trace_end = pipe_trace_end;
+    job.instr_mix      = instr_mix_report;
+    job.instr_mix_json = instr_mix_json;
+    job.instr_log      = instr_log_path;
+    job.dmem_profile   = dmem_profile_report;
+    job.dmem_profile_json = dmem_profile_json;
+    job.dmem_profile_line = dmem_profile_line;
+    job.dmem_profile_window = dmem_profile_window;
+    job.dmem_profile_elf = dmem_profile_elf;
+    job.mem_stats      = mem_stats_report;
+    job.mem_stats_json = mem_stats_json;
+    job.toggle         = toggle_path;
+    job.max_stall_imem = max_stall_imem;
+    job.max_stall_dmem = max_stall_dmem;
+    job.save_path      = checkpoint_save_path;
+    job.save_at        = checkpoint_save_at;
+    job.restore        = checkpoint_restore;
+    job.ff_to_pc       = ff_to_pc;
+    job.ff_pc          = ff_pc;
+    job.ff_instrs      = ff_instrs;
+    job.cosim          = cosim_check;
+    job.hang_limit     = hang_limit;
+    job.syscall_dir    = syscall_dir;
+    job.wfi_skip       = wfi_skip;
+    job.irq_schedule   = irq_schedule;
+    job.irq_random     = irq_random;
+    job.irq_lines      = irq_lines;
+    job.irq_seed       = irq_seed;
+
+    if(ct_runs || ct_input_file != "") {
+
+        job.waves     = "";
+        job.save_path = "";
+        job.sample_report = "";
+
+        return ct_mode(job);
+
+    }
+
+    if(batch_mode) {
+
+        std::vector<batch_job_t> jobs;
+
+        job.imem      = "";
+        job.waves     = "";
+        job.save_path = "";
+        job.sample_report = "";
+
+        if(!batch_parse_list(batch_list_path, job, jobs)) {
+            return 1;
+        }
+
+        return batch_run(jobs, batch_results_path, batch_workers, quiet);
+
+    }
+
+    batch_result_t result;
+
+    return run_job(job, result);
+
 }
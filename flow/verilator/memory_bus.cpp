@@ -1,4 +1,6 @@
 
+#include <algorithm>
+
 #include "memory_bus.hpp"
     
 /*!
@@ -30,6 +32,19 @@ bool memory_bus::add_device (
 }
 
 
+//! Disconnect a device added with add_device. It is not freed.
+void memory_bus::remove_device (
+    memory_device   * device
+) {
+
+    this -> devices.erase(
+        std::remove(this -> devices.begin(), this -> devices.end(), device),
+        this -> devices.end()
+    );
+
+}
+
+
 //! Return the device to which the supplied address maps, or NULL.
 memory_device * memory_bus::get_device_at (
     memory_address addr
@@ -50,6 +65,36 @@ memory_device * memory_bus::get_device_at (
 }
 
 
+//! Reset every device connected to the bus.
+void memory_bus::reset() {
+
+    for(auto const &it: this -> devices) {
+        it -> reset();
+    }
+
+}
+
+
+//! Save the state of every device, in the order they were added.
+void memory_bus::save_state (VerilatedSerialize & os) {
+
+    for(auto const &it: this -> devices) {
+        it -> save_state(os);
+    }
+
+}
+
+
+//! Restore the state of every device, as written by save_state.
+void memory_bus::restore_state (VerilatedDeserialize & is) {
+
+    for(auto const &it: this -> devices) {
+        it -> restore_state(is);
+    }
+
+}
+
+
 /*!
 @note If the requested memory address is not mapped, an error
       response transaction will be returned.
@@ -34,11 +34,25 @@ public:
         memory_device   * device
     );
 
+    //! Disconnect a device added with add_device. It is not freed.
+    void remove_device (
+        memory_device   * device
+    );
+
     //! Return the device to which the supplied address maps, or NULL.
     memory_device * get_device_at (
         memory_address addr
     );
 
+    //! Reset every device connected to the bus.
+    void reset();
+
+    //! Save the state of every device, in the order they were added.
+    void save_state (VerilatedSerialize & os);
+
+    //! Restore the state of every device, as written by save_state.
+    void restore_state (VerilatedDeserialize & is);
+
     //! Issue a new request to the bus and get the response back.
     memory_rsp_txn * request (
         memory_req_txn * req
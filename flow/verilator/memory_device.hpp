@@ -2,6 +2,8 @@
 #include <cstdint>
 #include <map>
 
+#include "verilated_save.h"
+
 #include "memory_txns.hpp"
 
 #ifndef MEMORY_DEVICE_HPP
@@ -17,7 +19,35 @@ public:
         size_t         range
     );
 
-    ~memory_device();
+    virtual ~memory_device();
+
+    /*!
+    @brief Return the device to its just-constructed state.
+    @details Called between back-to-back tests. Devices with no state
+        need not override this.
+    */
+    virtual void reset() {}
+
+    /*!
+    @brief Write the contents of the device to a checkpoint.
+    @details Devices with no state need not override this.
+    */
+    virtual void save_state (VerilatedSerialize & os) {}
+
+    //! Read back device contents written by save_state.
+    virtual void restore_state (VerilatedDeserialize & is) {}
+
+    /*!
+    @brief If false, the functional ISS leaves accesses to addr to the
+        RTL, because they have an effect on the testbench.
+    */
+    virtual bool functional_access(memory_address addr) { return true; }
+
+    /*!
+    @brief If true, stores the functional ISS makes to addr are dropped.
+        For registers which only mean something to the RTL run.
+    */
+    virtual bool functional_discard(memory_address addr) { return false; }
 
     memory_address get_base (){return this -> addr_base ;}
     size_t         get_range(){return this -> addr_range;}
@@ -0,0 +1,132 @@
+
+#include "memory_device_exit.hpp"
+
+
+/*!
+*/
+bool memory_device_exit::read_word (
+    memory_address addr,
+    uint32_t     * dout
+){
+    if(addr == addr_tohost) {
+        *dout = reg_tohost;
+    }
+    else if(addr == addr_fromhost) {
+        *dout = reg_fromhost;
+    }
+    else if(addr == addr_marker) {
+        *dout = reg_marker;
+    }
+    else {
+        return false;
+    }
+
+    return true;
+}
+
+
+/*!
+*/
+bool memory_device_exit::write_byte (
+    memory_address addr,
+    uint8_t        data
+){
+    memory_address word_addr = addr & ~(0b11);
+    uint32_t       shift     = 8 * (addr & 0b11);
+    uint32_t     * reg;
+
+    if(word_addr == addr_tohost) {
+        reg            = &reg_tohost;
+        tohost_written = true;
+    }
+    else if(word_addr == addr_fromhost) {
+        reg            = &reg_fromhost;
+    }
+    else if(word_addr == addr_marker) {
+        reg            = &reg_marker;
+        marker_written = true;
+    }
+    else {
+        return false;
+    }
+
+    *reg = (*reg & ~(0xFFu << shift)) | (uint32_t)data << shift;
+
+    return true;
+}
+
+
+/*!
+@brief Return a single byte from the device.
+*/
+uint8_t memory_device_exit::read_byte (
+    memory_address addr
+){
+    uint32_t word;
+
+    if(!read_word(addr & ~(0b11), &word)) {
+        return 0;
+    }
+
+    return (word >> (8 * (addr & 0b11))) & 0xFF;
+}
+
+
+//! If TOHOST has been written since the last call, return its value.
+bool memory_device_exit::take_command(uint32_t & cmd) {
+
+    if(!tohost_written) {
+        return false;
+    }
+
+    tohost_written = false;
+    cmd            = reg_tohost;
+
+    return true;
+
+}
+
+
+//! If MARKER has been written since the last call, return its value.
+bool memory_device_exit::take_marker(uint32_t & marker) {
+
+    if(!marker_written) {
+        return false;
+    }
+
+    marker_written = false;
+    marker         = reg_marker;
+
+    return true;
+
+}
+
+
+//! Clear the registers and any command not yet taken.
+void memory_device_exit::reset() {
+
+    reg_tohost     = 0;
+    reg_fromhost   = 0;
+    reg_marker     = 0;
+    tohost_written = false;
+    marker_written = false;
+
+}
+
+
+//! Write the registers to a checkpoint.
+void memory_device_exit::save_state (VerilatedSerialize & os) {
+
+    os << reg_tohost << reg_fromhost << tohost_written;
+    os << reg_marker << marker_written;
+
+}
+
+
+//! Restore the registers written by save_state.
+void memory_device_exit::restore_state (VerilatedDeserialize & is) {
+
+    is >> reg_tohost >> reg_fromhost >> tohost_written;
+    is >> reg_marker >> marker_written;
+
+}
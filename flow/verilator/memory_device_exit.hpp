@@ -0,0 +1,121 @@
+
+#include "memory_device.hpp"
+
+#ifndef MEMORY_DEVICE_EXIT_HPP
+#define MEMORY_DEVICE_EXIT_HPP
+
+#define MEMORY_DEVICE_EXIT_RANGE 12
+
+/*!
+@brief A host interface device, after the HTIF tohost / fromhost words,
+    through which a program ends the simulation.
+@details:
+Register Map:
+Offset  |  Register
+--------|----------------------
+0x0     | TOHOST
+0x4     | FROMHOST
+0x8     | MARKER
+
+Writing (code << 1) | 1 to TOHOST ends the simulation with exit code
+code, so 1 is a pass. Any other value written is a command for the host;
+the testbench picks up each write with take_command().
+
+Values written to MARKER tell the testbench where the program has got
+to, e.g. to start dumping waves or to begin and end its region of
+interest (DUT_MARKER_ROI_BEGIN / _END). Each write is picked up with
+take_marker().
+
+The functional ISS leaves accesses to TOHOST and FROMHOST to the RTL, so
+it stops before the program ends. Its writes to MARKER are dropped, so
+profiling and fast-forwarding run through region of interest markers.
+*/
+class memory_device_exit : public memory_device {
+
+public:
+    
+    memory_device_exit (
+        memory_address base
+    ) : memory_device(base,MEMORY_DEVICE_EXIT_RANGE) {
+        addr_tohost   = addr_base + 0;
+        addr_fromhost = addr_base + 4;
+        addr_marker   = addr_base + 8;
+        reset();
+    }
+
+    /*!
+    @brief Read a word from the address given.
+    @returns true if the read succeeds. False otherwise.
+    */
+    bool read_word (
+        memory_address addr,
+        uint32_t     * dout
+    );
+
+    /*!
+    @brief Write a single byte to the device.
+    @return true if the write is in range, else false.
+    */
+    bool write_byte (
+        memory_address addr,
+        uint8_t        data
+    );
+
+    /*!
+    @brief Return a single byte from the device.
+    */
+    uint8_t read_byte (
+        memory_address addr
+    );
+
+    //! Clear the registers and any command not yet taken.
+    void reset();
+
+    //! Write the registers to a checkpoint.
+    void save_state (VerilatedSerialize & os);
+
+    //! Restore the registers written by save_state.
+    void restore_state (VerilatedDeserialize & is);
+
+    //! The ISS may only touch MARKER: TOHOST and FROMHOST go to the RTL.
+    bool functional_access(memory_address addr) {
+        return (addr & ~0x3u) == addr_marker;
+    }
+
+    //! MARKER only means something to the RTL run.
+    bool functional_discard(memory_address addr) {
+        return (addr & ~0x3u) == addr_marker;
+    }
+
+    /*!
+    @brief If TOHOST has been written since the last call, return true and
+        its value in cmd.
+    @details Called once all of a store has reached the device, so cmd
+        holds every byte written.
+    */
+    bool take_command(uint32_t & cmd);
+
+    //! If MARKER has been written since the last call, return its value.
+    bool take_marker(uint32_t & marker);
+
+    //! Value returned by reads of FROMHOST.
+    uint32_t reg_fromhost;
+
+protected:
+
+    memory_address addr_tohost;
+    memory_address addr_fromhost;
+    memory_address addr_marker;
+
+    uint32_t reg_tohost;
+    uint32_t reg_marker;
+
+    //! Set by a write to TOHOST, until take_command() is called.
+    bool     tohost_written;
+
+    //! Set by a write to MARKER, until take_marker() is called.
+    bool     marker_written;
+
+};
+
+#endif
@@ -1,4 +1,7 @@
 
+#include <cstring>
+#include <vector>
+
 #include "memory_device_ram.hpp"
 
 /*!
@@ -32,6 +35,78 @@ uint8_t memory_device_ram::read_byte (
     return memory[addr];
 }
 
+/*!
+*/
+void memory_device_ram::reset() {
+    this -> memory.clear();
+}
+
+/*!
+*/
+void memory_device_ram::save_state (VerilatedSerialize & os) {
+
+    std::vector<memory_address> pages;
+
+    for(auto const &it : this -> memory) {
+        memory_address page = it.first & ~(memory_address)
+                                          (MEMORY_DEVICE_RAM_PAGE-1);
+        if(pages.empty() || pages.back() != page) {
+            pages.push_back(page);
+        }
+    }
+
+    uint64_t num_pages = pages.size();
+
+    os << num_pages;
+
+    uint8_t  buf[MEMORY_DEVICE_RAM_PAGE];
+
+    for(memory_address page : pages) {
+
+        memset(buf, 0, sizeof(buf));
+
+        for(auto it  = this -> memory.lower_bound(page);
+                 it != this -> memory.end() &&
+                 it -> first < page + MEMORY_DEVICE_RAM_PAGE;
+                 it ++) {
+            buf[it -> first - page] = it -> second;
+        }
+
+        os << page;
+        os.write(buf, sizeof(buf));
+    }
+
+}
+
+/*!
+*/
+void memory_device_ram::restore_state (VerilatedDeserialize & is) {
+
+    this -> memory.clear();
+
+    uint64_t num_pages = 0;
+
+    is >> num_pages;
+
+    uint8_t  buf[MEMORY_DEVICE_RAM_PAGE];
+
+    for(uint64_t p = 0; p < num_pages; p ++) {
+
+        memory_address page = 0;
+
+        is >> page;
+        is.read(buf, sizeof(buf));
+
+        // Bytes never written read as zero, so keep the map sparse.
+        for(size_t i = 0; i < sizeof(buf); i ++) {
+            if(buf[i]) {
+                this -> memory[page + i] = buf[i];
+            }
+        }
+    }
+
+}
+
 /*!
 */
 bool memory_device_ram::write_byte (
@@ -4,6 +4,9 @@
 #ifndef MEMORY_DEVICE_RAM_HPP
 #define MEMORY_DEVICE_RAM_HPP
 
+//! Granularity, in bytes, at which RAM contents are checkpointed.
+#define MEMORY_DEVICE_RAM_PAGE 4096
+
 class memory_device_ram : public memory_device {
 
 public:
@@ -38,6 +41,24 @@ public:
     uint8_t read_byte (
         memory_address addr
     );
+
+    /*!
+    @brief Forget the contents of the memory.
+    @details Storage is sparse, so this only costs as much as the number of
+        bytes touched since the last reset.
+    */
+    void reset();
+
+    /*!
+    @brief Write every page holding a touched byte to a checkpoint.
+    @details Pages are MEMORY_DEVICE_RAM_PAGE bytes. Untouched pages are
+        not written, so the checkpoint size follows the memory footprint
+        of the program rather than the size of the device.
+    */
+    void save_state (VerilatedSerialize & os);
+
+    //! Replace the memory contents with those written by save_state.
+    void restore_state (VerilatedDeserialize & is);
     
 
 protected:
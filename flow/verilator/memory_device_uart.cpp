@@ -139,10 +139,14 @@ void memory_device_uart::write_to_tx_buffer(uint8_t data) {
     // Line buffered - so if we see a newline, print and empty the buffer.
     if(data == '\n') {
 
-        std::cout << "$ ";
+        if(!quiet) {
+            std::cout << "$ ";
+        }
         
         while(tx_buffer.size() > 0) {
-            std::cout << tx_buffer.front();
+            if(!quiet) {
+                std::cout << tx_buffer.front();
+            }
             tx_buffer.pop();
         }
 
@@ -150,3 +154,64 @@ void memory_device_uart::write_to_tx_buffer(uint8_t data) {
     }
 
 }
+
+
+//! Empty the RX and TX buffers.
+void memory_device_uart::reset() {
+
+    std::queue<uint8_t>().swap(rx_buffer);
+    std::queue<uint8_t>().swap(tx_buffer);
+
+}
+
+
+//! Write a queue of characters to a checkpoint.
+static void save_char_queue (
+    VerilatedSerialize  & os,
+    std::queue<uint8_t>   q
+) {
+    uint64_t n = q.size();
+    os << n;
+    while(q.size() > 0) {
+        os << q.front();
+        q.pop();
+    }
+}
+
+
+//! Read back a queue of characters written by save_char_queue.
+static void restore_char_queue (
+    VerilatedDeserialize & is,
+    std::queue<uint8_t>  & q
+) {
+    std::queue<uint8_t>().swap(q);
+    uint64_t n = 0;
+    is >> n;
+    for(uint64_t i = 0; i < n; i ++) {
+        uint8_t c;
+        is >> c;
+        q.push(c);
+    }
+}
+
+
+//! Write the registers and buffered characters to a checkpoint.
+void memory_device_uart::save_state (VerilatedSerialize & os) {
+
+    os << reg_tx << reg_rx << reg_ctrl << reg_status;
+
+    save_char_queue(os, rx_buffer);
+    save_char_queue(os, tx_buffer);
+
+}
+
+
+//! Restore the registers and buffers written by save_state.
+void memory_device_uart::restore_state (VerilatedDeserialize & is) {
+
+    is >> reg_tx >> reg_rx >> reg_ctrl >> reg_status;
+
+    restore_char_queue(is, rx_buffer);
+    restore_char_queue(is, tx_buffer);
+
+}
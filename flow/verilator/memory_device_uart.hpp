@@ -57,6 +57,18 @@ public:
     uint8_t read_byte (
         memory_address addr
     );
+
+    //! Empty the RX and TX buffers.
+    void reset();
+
+    //! Write the registers and buffered characters to a checkpoint.
+    void save_state (VerilatedSerialize & os);
+
+    //! Restore the registers and buffers written by save_state.
+    void restore_state (VerilatedDeserialize & is);
+
+    //! If set, transmitted lines are discarded rather than printed.
+    bool quiet = false;
     
 
 protected:
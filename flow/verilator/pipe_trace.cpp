@@ -0,0 +1,290 @@
+
+#include <cinttypes>
+#include <stdexcept>
+
+#include "pipe_trace.hpp"
+#include "instr_disasm.hpp"
+
+//! Konata stage names, and Chrome trace track names.
+static const char * pipe_stage_names[PIPE_STAGES] = {"D", "E", "M", "W"};
+static const char * pipe_track_names[PIPE_STAGES] = {
+    "decode", "execute", "memory", "writeback"
+};
+
+
+//! Parse a window of simulation cycles.
+bool pipe_trace_window_parse(std::string arg, uint64_t & start,
+                             uint64_t & end) {
+
+    size_t colon = arg.find(':');
+
+    if(colon == std::string::npos || colon == 0) {
+        return false;
+    }
+
+    try {
+        start = std::stoull(arg.substr(0, colon), NULL, 0);
+        end   = colon + 1 < arg.size() ?
+                std::stoull(arg.substr(colon + 1), NULL, 0) : UINT64_MAX;
+    } catch(std::exception const &) {
+        return false;
+    }
+
+    return start < end;
+
+}
+
+
+//! Close any open files.
+pipe_trace::~pipe_trace() {
+
+    this -> close();
+
+}
+
+
+//! Open the output files. Either path may be empty.
+bool pipe_trace::open(std::string konata_path, std::string chrome_path) {
+
+    if(konata_path != "") {
+
+        this -> konata = fopen(konata_path.c_str(), "w");
+
+        if(this -> konata == NULL) {
+            return false;
+        }
+
+        fprintf(this -> konata, "Kanata\t0004\n");
+    }
+
+    if(chrome_path != "") {
+
+        this -> chrome = fopen(chrome_path.c_str(), "w");
+
+        if(this -> chrome == NULL) {
+            return false;
+        }
+
+        fprintf(this -> chrome, "{\"displayTimeUnit\": \"ns\", "
+                                "\"traceEvents\": [\n");
+
+        for(int s = 0; s < PIPE_STAGES; s ++) {
+            char json[128];
+            snprintf(json, sizeof(json),
+                "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, "
+                "\"tid\": %d, \"args\": {\"name\": \"%d %s\"}}",
+                s, s + 1, pipe_track_names[s]);
+            this -> chrome_event(json);
+        }
+    }
+
+    return true;
+
+}
+
+
+//! Finish and close the output files.
+void pipe_trace::close() {
+
+    if(this -> konata) {
+        fclose(this -> konata);
+        this -> konata = NULL;
+    }
+
+    if(this -> chrome) {
+        fprintf(this -> chrome, "\n]}\n");
+        fclose(this -> chrome);
+        this -> chrome = NULL;
+    }
+
+}
+
+
+//! Called at each rising edge of g_clk.
+void pipe_trace::posedge (
+    uint64_t cycle      ,
+    uint64_t sim_cycle  ,
+    bool     record     ,
+    uint32_t progress   ,
+    uint32_t s1_data    ,
+    bool     trs_valid  ,
+    uint32_t trs_pc
+) {
+
+    // An instruction seen in decode for the first time entered it in this
+    // cycle.
+    bool in_window = sim_cycle >= this -> window_start &&
+                     sim_cycle <  this -> window_end;
+
+    if((progress & PIPE_S1_VALID) && !this -> full[PIPE_DECODE] &&
+       record && in_window) {
+
+        pipe_trace_instr_t & i = this -> slot[PIPE_DECODE];
+
+        i.id    = this -> traced ++;
+        i.instr = (s1_data & 0x3) == 0x3 ? s1_data : s1_data & 0xFFFF;
+
+        this -> full[PIPE_DECODE] = true;
+
+        if(this -> konata) {
+            this -> konata_at(cycle);
+            fprintf(this -> konata, "I\t%" PRIu64 "\t%" PRIu64 "\t0\n",
+                    i.id, i.id);
+            fprintf(this -> konata, "L\t%" PRIu64 "\t0\t%08x %s\n",
+                    i.id, i.instr, instr_disasm(i.instr).c_str());
+        }
+
+        this -> stage_begin(PIPE_DECODE, cycle);
+    }
+
+    // Everything else happens at the edge, so at the start of the next
+    // cycle.
+    uint64_t next = cycle + 1;
+
+    if(this -> full[PIPE_WRITEBACK] &&
+       (progress & PIPE_PROGRESS(PIPE_WRITEBACK))) {
+        this -> stage_end(PIPE_WRITEBACK, next, trs_valid, trs_pc);
+        this -> leave(PIPE_WRITEBACK, next, false);
+    }
+
+    if(progress & PIPE_FLUSH) {
+
+        for(int s = PIPE_DECODE; s < PIPE_WRITEBACK; s ++) {
+            if(this -> full[s]) {
+                this -> stage_end((pipe_stage_t)s, next, false, 0);
+                this -> leave((pipe_stage_t)s, next, true);
+            }
+        }
+
+        return;
+    }
+
+    // From the back, so each stage has been emptied before it is filled.
+    for(int s = PIPE_MEMORY; s >= PIPE_DECODE; s --) {
+
+        if(!this -> full[s] || !(progress & PIPE_PROGRESS(s)) ||
+           this -> full[s + 1]) {
+            continue;
+        }
+
+        this -> stage_end((pipe_stage_t)s, next, false, 0);
+
+        this -> slot[s + 1] = this -> slot[s];
+        this -> full[s + 1] = true;
+        this -> full[s    ] = false;
+
+        this -> stage_begin((pipe_stage_t)(s + 1), next);
+    }
+
+}
+
+
+//! Move the Konata log on to cycle.
+void pipe_trace::konata_at(uint64_t cycle) {
+
+    if(!this -> konata_started) {
+        fprintf(this -> konata, "C=\t%" PRIu64 "\n", cycle);
+        this -> konata_started = true;
+        this -> konata_cycle   = cycle;
+    } else if(cycle > this -> konata_cycle) {
+        fprintf(this -> konata, "C\t%" PRIu64 "\n",
+                cycle - this -> konata_cycle);
+        this -> konata_cycle   = cycle;
+    }
+
+}
+
+
+//! Start writing an instruction's time in a stage.
+void pipe_trace::stage_begin(pipe_stage_t stage, uint64_t cycle) {
+
+    pipe_trace_instr_t & i = this -> slot[stage];
+
+    i.since = cycle;
+
+    if(this -> konata) {
+        this -> konata_at(cycle);
+        fprintf(this -> konata, "S\t%" PRIu64 "\t0\t%s\n",
+                i.id, pipe_stage_names[stage]);
+    }
+
+}
+
+
+//! Finish an instruction's time in a stage.
+void pipe_trace::stage_end (
+    pipe_stage_t stage  ,
+    uint64_t     cycle  ,
+    bool         has_pc ,
+    uint32_t     pc
+) {
+
+    pipe_trace_instr_t & i = this -> slot[stage];
+
+    if(this -> konata) {
+        this -> konata_at(cycle);
+        fprintf(this -> konata, "E\t%" PRIu64 "\t0\t%s\n",
+                i.id, pipe_stage_names[stage]);
+        if(has_pc) {
+            fprintf(this -> konata, "L\t%" PRIu64 "\t0\t @ %08x\n",
+                    i.id, pc);
+        }
+    }
+
+    if(this -> chrome) {
+        char json[256];
+        int  n = snprintf(json, sizeof(json),
+            "{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, "
+            "\"ts\": %" PRIu64 ", \"dur\": %" PRIu64 ", "
+            "\"args\": {\"id\": %" PRIu64 ", \"instr\": \"%08x\"",
+            instr_disasm(i.instr).c_str(), (int)stage, i.since,
+            cycle - i.since, i.id, i.instr);
+        if(has_pc) {
+            n += snprintf(json + n, sizeof(json) - n,
+                          ", \"pc\": \"0x%08x\"", pc);
+        }
+        snprintf(json + n, sizeof(json) - n, "}}");
+        this -> chrome_event(json);
+    }
+
+}
+
+
+//! Take an instruction out of the pipeline, as retired or flushed.
+void pipe_trace::leave(pipe_stage_t stage, uint64_t cycle, bool flushed) {
+
+    pipe_trace_instr_t & i = this -> slot[stage];
+
+    this -> full[stage] = false;
+
+    if(this -> konata) {
+        this -> konata_at(cycle);
+        fprintf(this -> konata, "R\t%" PRIu64 "\t%" PRIu64 "\t%d\n",
+                i.id, flushed ? 0 : this -> retired, flushed ? 1 : 0);
+    }
+
+    if(flushed && this -> chrome) {
+        char json[160];
+        snprintf(json, sizeof(json),
+            "{\"name\": \"flush %s\", \"ph\": \"i\", \"s\": \"t\", "
+            "\"pid\": 1, \"tid\": %d, \"ts\": %" PRIu64 "}",
+            instr_disasm(i.instr).c_str(), (int)stage, cycle);
+        this -> chrome_event(json);
+    }
+
+    if(!flushed) {
+        this -> retired ++;
+    }
+
+}
+
+
+//! Write one Chrome trace event.
+void pipe_trace::chrome_event(std::string const & json) {
+
+    fprintf(this -> chrome, "%s%s", this -> chrome_started ? ",\n" : "",
+            json.c_str());
+
+    this -> chrome_started = true;
+
+}
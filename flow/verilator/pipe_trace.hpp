@@ -0,0 +1,144 @@
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#ifndef PIPE_TRACE_HPP
+#define PIPE_TRACE_HPP
+
+//! Pipeline stages instructions are followed through.
+typedef enum pipe_stage {
+    PIPE_DECODE     = 0,
+    PIPE_EXECUTE    = 1,
+    PIPE_MEMORY     = 2,
+    PIPE_WRITEBACK  = 3,
+    PIPE_STAGES     = 4
+} pipe_stage_t;
+
+//! Bits of frv_pipeline_progress() in frv_pipeline.v.
+#define PIPE_S1_VALID       (1 << 0)
+#define PIPE_PROGRESS(s)    (1 << (1 + (s)))
+#define PIPE_FLUSH          (1 << 5)
+
+/*!
+@brief Parse a window of simulation cycles, "<start>:<end>" or
+    "<start>:" for no end, into start and end.
+@returns false if it is not one.
+*/
+bool pipe_trace_window_parse(std::string arg, uint64_t & start,
+                             uint64_t & end);
+
+//! One instruction in the pipeline.
+typedef struct pipe_trace_instr {
+    uint64_t    id          ; //!< Order it entered decode in.
+    uint32_t    instr       ; //!< Instruction word, as decode saw it.
+    uint64_t    since       ; //!< Clock cycle it entered its stage at.
+} pipe_trace_instr_t;
+
+/*!
+@brief Logs when each instruction enters and leaves the decode, execute,
+    memory and writeback stages, and which are flushed, in Konata's log
+    format and / or as Chrome trace event JSON (for Perfetto).
+@details Instructions are followed from the stage progress signals of
+    the pipeline (see frv_pipeline_progress() in frv_pipeline.v). Fetch
+    is not traced: the fetch buffer does not keep instructions apart.
+    Instruction addresses are only known once they retire.
+
+    Times are in clock cycles of g_clk. In the Chrome trace one cycle is
+    shown as one microsecond, with one track per stage.
+*/
+class pipe_trace {
+
+public:
+
+    pipe_trace() {}
+
+    //! Close any open files.
+    ~pipe_trace();
+
+    /*!
+    @brief Open the output files. Either path may be empty.
+    @returns false if a file could not be opened.
+    */
+    bool open(std::string konata_path, std::string chrome_path);
+
+    //! Finish and close the output files.
+    void close();
+
+    //! Simulation cycle (as +TIMEOUT) instructions start being traced at.
+    uint64_t    window_start    = 0;
+
+    //! Simulation cycle instructions stop being traced at.
+    uint64_t    window_end      = UINT64_MAX;
+
+    /*!
+    @brief Called at each rising edge of g_clk, with the signals as they
+        were in the cycle it ends.
+    @param in cycle     - Clock cycle which ends at this edge.
+    @param in sim_cycle - The same, in simulation cycles.
+    @param in record    - May new instructions be traced (e.g. in the
+                          region of interest)? Those already being traced
+                          are followed until they leave the pipeline.
+    @param in progress  - frv_pipeline_progress().
+    @param in s1_data   - The instruction in decode.
+    @param in trs_valid - An instruction is traced out on trs_pc.
+    @param in trs_pc    - Its address.
+    */
+    void posedge (
+        uint64_t cycle      ,
+        uint64_t sim_cycle  ,
+        bool     record     ,
+        uint32_t progress   ,
+        uint32_t s1_data    ,
+        bool     trs_valid  ,
+        uint32_t trs_pc
+    );
+
+    //! Instructions traced so far.
+    uint64_t    traced          = 0;
+
+protected:
+
+    FILE      * konata          = NULL;
+    FILE      * chrome          = NULL;
+
+    //! Cycle the Konata log is at.
+    uint64_t    konata_cycle    = 0;
+
+    //! Set once the Konata log has its first cycle.
+    bool        konata_started  = false;
+
+    //! Set once a Chrome trace event has been written.
+    bool        chrome_started  = false;
+
+    //! Instructions retired so far.
+    uint64_t    retired         = 0;
+
+    //! Which stages hold a traced instruction.
+    bool        full[PIPE_STAGES] = {false};
+
+    //! The instruction each stage holds.
+    pipe_trace_instr_t slot[PIPE_STAGES];
+
+    //! Move the Konata log on to cycle.
+    void konata_at(uint64_t cycle);
+
+    //! Start writing an instruction's time in a stage.
+    void stage_begin(pipe_stage_t stage, uint64_t cycle);
+
+    /*!
+    @brief Finish an instruction's time in a stage.
+    @param in pc - Its address, if known. Only for writeback.
+    */
+    void stage_end(pipe_stage_t stage, uint64_t cycle, bool has_pc,
+                   uint32_t pc);
+
+    //! Take an instruction out of the pipeline, as retired or flushed.
+    void leave(pipe_stage_t stage, uint64_t cycle, bool flushed);
+
+    //! Write one Chrome trace event.
+    void chrome_event(std::string const & json);
+
+};
+
+#endif
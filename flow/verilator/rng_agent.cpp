@@ -3,6 +3,7 @@
 #include <cstdlib>
 
 #include "rng_agent.hpp"
+#include "tb_random.hpp"
 
 const uint8_t rng_op_seed = 0b001;
 const uint8_t rng_op_samp = 0b010;
@@ -18,11 +19,22 @@ void rng_agent::set_reset() {
     *rng_req_ready = 0;
     *rng_rsp_valid = 0;
 
+    n_rng_req_ready  = 0;
+    n_rng_rsp_valid  = 0;
+    n_rng_rsp_status = 0;
+    n_rng_rsp_data   = 0;
+
     req_stall_len  = 0;
     rsp_stall_len  = 0;
 
     status         = rng_status_noinit;
 
+    // Drop any responses left over from a previous run.
+    while(rsp_q.empty() == false) {
+        delete rsp_q.front();
+        rsp_q.pop();
+    }
+
 }
 
 //! Take the interface out of reset
@@ -116,7 +128,7 @@ uint32_t   rng_agent::rng_sample() {
     status = rand_chance(9,10) ? rng_status_init_healthy    : 
                                  rng_status_init_unhealthy  ;
 
-    return std::rand();
+    return tb_rand();
 
 }
 
@@ -125,7 +137,51 @@ void       rng_agent::rng_seed  (uint32_t seed) {
     
     status = rng_status_init_unhealthy;
     
-    std::srand(seed);
+    tb_srand(seed);
+
+}
+
+
+
+//! Write queued responses and next signal values to a checkpoint.
+void rng_agent::save_state (VerilatedSerialize & os) {
+
+    os << status << req_stall_len << rsp_stall_len;
+    os << n_rng_req_ready << n_rng_rsp_valid;
+    os << n_rng_rsp_status << n_rng_rsp_data;
+
+    uint64_t num_rsps = rsp_q.size();
+    os << num_rsps;
+
+    // Rotate through the queue so it is left as it was found.
+    for(uint64_t i = 0; i < num_rsps; i ++) {
+        rng_agent_txn * txn = rsp_q.front();
+        rsp_q.pop();
+        os << txn -> data << txn -> status;
+        rsp_q.push(txn);
+    }
 
 }
 
+//! Restore the queue and next signal values written by save_state.
+void rng_agent::restore_state (VerilatedDeserialize & is) {
+
+    while(rsp_q.empty() == false) {
+        delete rsp_q.front();
+        rsp_q.pop();
+    }
+
+    is >> status >> req_stall_len >> rsp_stall_len;
+    is >> n_rng_req_ready >> n_rng_rsp_valid;
+    is >> n_rng_rsp_status >> n_rng_rsp_data;
+
+    uint64_t num_rsps = 0;
+    is >> num_rsps;
+
+    for(uint64_t i = 0; i < num_rsps; i ++) {
+        rng_agent_txn * txn = new rng_agent_txn;
+        is >> txn -> data >> txn -> status;
+        rsp_q.push(txn);
+    }
+
+}
@@ -1,6 +1,10 @@
 
 #include <queue>
 
+#include "verilated_save.h"
+
+#include "tb_random.hpp"
+
 #ifndef RNG_AGENT_HPP
 #define RNG_AGENT_HPP
 
@@ -59,6 +63,12 @@ public:
 
     //! Drive any signal updates
     void drive_signals();
+
+    //! Write queued responses and next signal values to a checkpoint.
+    void save_state (VerilatedSerialize & os);
+
+    //! Restore the queue and next signal values written by save_state.
+    void restore_state (VerilatedDeserialize & is);
         
     // Wires driven / monitored by the agent.
     uint8_t  * rng_req_valid    ; //!< Signal a new request to the RNG
@@ -105,7 +115,7 @@ protected:
     std::queue<rng_agent_txn *> rsp_q;
     
     uint8_t rand_chance(int a, int b) {
-        return ((rand() % b) < a) ? 1 : 0;
+        return ((int)(tb_rand() % b) < a) ? 1 : 0;
     }
 
 };
@@ -0,0 +1,520 @@
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+
+#include "iss.hpp"
+#include "sampling.hpp"
+
+//! Number of k-means runs from different starting centres.
+#define SAMPLE_KMEANS_RUNS  5
+
+//! Limit on k-means iterations per run.
+#define SAMPLE_KMEANS_ITERS 100
+
+/*!
+@brief Fixed random projection matrix entry, in [-1,1), for the basic
+    block starting at pc and output dimension d.
+@details A hash rather than a stored matrix, since the set of blocks is
+    not known up front.
+*/
+static double sample_projection(uint32_t pc, int d) {
+    uint64_t z = ((uint64_t)pc << 8 | d) + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z =  z ^ (z >> 31);
+    return (double)(z >> 11) / (double)(1ull << 52) - 1.0;
+}
+
+//! Add a finished interval's basic block vector to the profile.
+static void sample_add_interval (
+    std::vector<sample_interval_t> & intervals,
+    std::map<uint32_t,uint64_t>    & bbv      ,
+    uint64_t                         start    ,
+    uint64_t                         length
+) {
+    sample_interval_t iv;
+    iv.start  = start;
+    iv.length = length;
+
+    for(int d = 0; d < SAMPLE_DIMS; d ++) {
+        iv.vec[d] = 0;
+    }
+
+    for(auto const & it : bbv) {
+        double w = (double)it.second / length;
+        for(int d = 0; d < SAMPLE_DIMS; d ++) {
+            iv.vec[d] += w * sample_projection(it.first, d);
+        }
+    }
+
+    intervals.push_back(iv);
+    bbv.clear();
+}
+
+//! Squared euclidean distance between two projected vectors.
+static double sample_dist(double const * a, double const * b) {
+    double r = 0;
+    for(int d = 0; d < SAMPLE_DIMS; d ++) {
+        r += (a[d] - b[d]) * (a[d] - b[d]);
+    }
+    return r;
+}
+
+/*!
+@brief Cluster the intervals into at most k phases with k-means.
+@details k-means++ starting centres, best of SAMPLE_KMEANS_RUNS runs.
+    Sets the phase of each interval.
+@returns The number of phases used.
+*/
+static unsigned sample_cluster (
+    std::vector<sample_interval_t> & iv,
+    unsigned                         k
+) {
+    typedef std::vector<double> centre_t;
+
+    k = std::min<size_t>(k, iv.size());
+
+    std::mt19937 rng(1);
+    auto uniform = [&rng]() {return (double)rng() / 4294967296.0;};
+
+    double                best_cost = std::numeric_limits<double>::max();
+    std::vector<unsigned> best_phase(iv.size(), 0);
+
+    for(int run = 0; run < SAMPLE_KMEANS_RUNS; run ++) {
+
+        // k-means++: pick each new centre with probability proportional
+        // to its squared distance from the nearest existing one.
+        std::vector<centre_t> centres;
+        size_t first = rng() % iv.size();
+        centres.push_back(centre_t(iv[first].vec, iv[first].vec+SAMPLE_DIMS));
+
+        while(centres.size() < k) {
+            std::vector<double> near(iv.size());
+            double              total = 0;
+            for(size_t i = 0; i < iv.size(); i ++) {
+                near[i] = std::numeric_limits<double>::max();
+                for(auto const & c : centres) {
+                    near[i] = std::min(near[i], sample_dist(iv[i].vec,c.data()));
+                }
+                total += near[i];
+            }
+            if(total == 0) {
+                break;  // Fewer distinct intervals than k.
+            }
+            double pick = uniform() * total;
+            size_t i    = 0;
+            for(; i < iv.size() - 1 && pick >= near[i]; i ++) {
+                pick -= near[i];
+            }
+            centres.push_back(centre_t(iv[i].vec, iv[i].vec+SAMPLE_DIMS));
+        }
+
+        std::vector<unsigned> phase(iv.size(), 0);
+        double                cost = 0;
+
+        for(int iter = 0; iter < SAMPLE_KMEANS_ITERS; iter ++) {
+
+            bool changed = false;
+            cost         = 0;
+
+            for(size_t i = 0; i < iv.size(); i ++) {
+                unsigned best = 0;
+                double   bd   = std::numeric_limits<double>::max();
+                for(unsigned c = 0; c < centres.size(); c ++) {
+                    double d = sample_dist(iv[i].vec, centres[c].data());
+                    if(d < bd) {
+                        bd   = d;
+                        best = c;
+                    }
+                }
+                changed |= iter == 0 || phase[i] != best;
+                phase[i] = best;
+                cost    += bd;
+            }
+
+            if(!changed) {
+                break;
+            }
+
+            std::vector<size_t> count(centres.size(), 0);
+            for(auto & c : centres) {
+                std::fill(c.begin(), c.end(), 0);
+            }
+            for(size_t i = 0; i < iv.size(); i ++) {
+                count[phase[i]] ++;
+                for(int d = 0; d < SAMPLE_DIMS; d ++) {
+                    centres[phase[i]][d] += iv[i].vec[d];
+                }
+            }
+            for(unsigned c = 0; c < centres.size(); c ++) {
+                for(int d = 0; d < SAMPLE_DIMS && count[c]; d ++) {
+                    centres[c][d] /= count[c];
+                }
+            }
+        }
+
+        if(cost < best_cost) {
+            best_cost  = cost;
+            best_phase = phase;
+        }
+    }
+
+    // Number the phases which are actually used from zero.
+    std::map<unsigned,unsigned> renumber;
+    for(size_t i = 0; i < iv.size(); i ++) {
+        if(renumber.count(best_phase[i]) == 0) {
+            unsigned n = renumber.size();
+            renumber[best_phase[i]] = n;
+        }
+        iv[i].phase = renumber[best_phase[i]];
+    }
+
+    return renumber.size();
+}
+
+/*!
+@brief Load the job's image into tb, and set it up for a sample run.
+*/
+static bool sample_setup_tb (
+    testbench   & tb ,
+    batch_job_t & job
+) {
+    if(!tb.reset_and_load(job.imem)) {
+        return false;
+    }
+    tb.pass_address   = job.pass_address;
+    tb.fail_address   = job.fail_address;
+    tb.max_sim_time   = job.timeout * 10;
+    tb.max_rtl_instrs = 0;
+    tb.cosim_enable   = false;
+    tb.hang_limit     = job.hang_limit;
+    tb.wfi_skip       = job.wfi_skip;
+    tb.syscalls -> sandbox = job.syscall_dir;
+    tb.dut -> roi_enable   = job.roi;
+    tb.dut -> set_imem_max_stall(job.max_stall_imem);
+    tb.dut -> set_dmem_max_stall(job.max_stall_dmem);
+    tb.dut -> irq_if_agent -> set_random(job.irq_random, job.irq_lines,
+                                         job.irq_seed);
+    if(job.irq_schedule != "" &&
+       !tb.dut -> irq_if_agent -> load_schedule(job.irq_schedule)) {
+        return false;
+    }
+    return true;
+}
+
+/*!
+@brief Run one interval on the RTL, after fast-forwarding and warming up.
+@returns false if the RTL did not run the whole interval.
+*/
+static bool sample_run_interval (
+    testbench         & tb     ,
+    batch_job_t       & job    ,
+    sample_interval_t & iv     ,
+    uint64_t          & rtl_cycles
+) {
+    if(!sample_setup_tb(tb, job)) {
+        return false;
+    }
+
+    // At least one warm-up instruction, so the handoff program and the
+    // reset sequence are never counted.
+    uint64_t warm = std::min(std::max<uint64_t>(job.sample_warmup, 1),
+                             iv.start);
+    uint64_t skip = iv.start - warm;
+    uint64_t count= iv.length;
+
+    // Interval 0 starts at reset, so has nothing before it to warm up
+    // on: its first instruction takes the reset sequence instead.
+    if(iv.start == 0 && iv.length > 1) {
+        warm  = 1;
+        count = iv.length - 1;
+    }
+
+    if(skip > 0) {
+        iss model(tb.bus);
+        model.functional_counters = true;
+        model.reset(tb.default_ram -> get_base());
+        model.run(std::vector<uint32_t>(), skip);
+        if(model.instret != skip || !tb.handoff(model)) {
+            return false;
+        }
+    }
+
+    uint64_t t_start = 0;
+
+    if(warm > 0) {
+        tb.max_rtl_instrs = warm;
+        tb.run_simulation();
+        if(tb.rtl_instrs < warm) {
+            return false;
+        }
+        t_start = tb.get_sim_time();
+        tb.max_rtl_instrs = warm + count;
+        tb.resume_simulation();
+    } else {
+        tb.max_rtl_instrs = count;
+        tb.run_simulation();
+    }
+
+    rtl_cycles += tb.get_sim_time() / 10;
+
+    // The last interval ends on the pass / fail address, so may retire
+    // one instruction fewer than the ISS counted.
+    if(tb.get_sim_time() >= tb.max_sim_time ||
+       (tb.rtl_instrs + 1 < warm + count && !tb.sim_finished)) {
+        return false;
+    }
+
+    iv.cycles  = (tb.get_sim_time() - t_start) / 10;
+    iv.counted = count;
+    iv.sampled = true;
+
+    return true;
+}
+
+//! Run a job as a sampled (SimPoint style) simulation.
+batch_status_t sample_job (
+    batch_job_t    & job    ,
+    batch_result_t & result ,
+    testbench      * reuse
+) {
+    auto wall_start = std::chrono::steady_clock::now();
+
+    testbench * fresh = reuse ? NULL : new testbench("", false);
+    testbench & tb    = fresh ? *fresh : *reuse;
+
+    result.status = BATCH_ERROR;
+
+    if(job.imem == "" || !sample_setup_tb(tb, job)) {
+        std::cout << ">> Could not open " << job.imem << std::endl;
+        delete fresh;
+        return result.status;
+    }
+
+    //
+    // 1. Functional profile.
+
+    std::vector<sample_interval_t> intervals;
+    std::map<uint32_t,uint64_t>    bbv;
+
+    iss model(tb.bus);
+    model.functional_counters = true;
+    model.reset(tb.default_ram -> get_base());
+
+    uint32_t block = model.pc;
+    uint64_t start = 0;
+    bool     ok    = true;
+
+    while(model.pc != job.pass_address && model.pc != job.fail_address) {
+
+        uint32_t pc = model.pc;
+
+        if(model.instret >= job.timeout || !model.step()) {
+            ok = false;
+            break;
+        }
+
+        bbv[block] ++;
+
+        // Anything other than falling through to the next instruction
+        // starts a new block.
+        if(model.pc - pc != 2 && model.pc - pc != 4) {
+            block = model.pc;
+        }
+
+        if(model.instret - start == job.sample_interval) {
+            sample_add_interval(intervals, bbv, start, job.sample_interval);
+            start = model.instret;
+        }
+    }
+
+    if(model.instret > start) {
+        sample_add_interval(intervals, bbv, start, model.instret - start);
+    }
+
+    std::cout << ">> Profiled " << std::dec << model.instret
+              << " instructions on the ISS." << std::endl;
+
+    if(!ok || intervals.empty()) {
+        std::cout << ">> Profile stopped at 0x" << std::hex << model.pc
+                  << std::dec << " before the pass / fail address."
+                  << std::endl;
+        delete fresh;
+        return result.status;
+    }
+
+    //
+    // 2. Find the phases.
+
+    unsigned phases = sample_cluster(intervals, std::max(1u,job.sample_phases));
+
+    //
+    // 3. Simulate the intervals nearest each phase centre.
+
+    std::vector<std::vector<size_t>> members(phases);
+    for(size_t i = 0; i < intervals.size(); i ++) {
+        members[intervals[i].phase].push_back(i);
+    }
+
+    uint64_t rtl_cycles = 0;
+    size_t   n_samples  = 0;
+
+    tb.uart_0 -> quiet = true;
+
+    for(unsigned p = 0; p < phases && ok; p ++) {
+
+        std::vector<double> centre(SAMPLE_DIMS, 0);
+        for(size_t i : members[p]) {
+            for(int d = 0; d < SAMPLE_DIMS; d ++) {
+                centre[d] += intervals[i].vec[d] / members[p].size();
+            }
+        }
+
+        std::vector<size_t> order = members[p];
+        std::stable_sort(order.begin(), order.end(),
+            [&](size_t a, size_t b) {
+                return sample_dist(intervals[a].vec, centre.data()) <
+                       sample_dist(intervals[b].vec, centre.data());
+            }
+        );
+
+        for(size_t n = 0; n < order.size() && n < job.sample_per_phase; n++) {
+            sample_interval_t & iv = intervals[order[n]];
+            if(!sample_run_interval(tb, job, iv, rtl_cycles)) {
+                std::cout << ">> Sample of instructions " << iv.start
+                          << " to " << iv.start + iv.length
+                          << " did not complete on the RTL." << std::endl;
+                ok = false;
+                break;
+            }
+            n_samples ++;
+        }
+    }
+
+    tb.uart_0 -> quiet = false;
+
+    //
+    // 4. Extrapolate.
+
+    std::vector<double>   cpi_mean(phases, 0), cpi_var(phases, -1);
+    std::vector<uint64_t> phase_instrs(phases, 0);
+    std::vector<size_t>   phase_samples(phases, 0);
+    double                pooled_var = 0;
+    int                   pooled_n   = 0;
+
+    for(unsigned p = 0; p < phases && ok; p ++) {
+        std::vector<double> cpis;
+        for(size_t i : members[p]) {
+            phase_instrs[p] += intervals[i].length;
+            if(intervals[i].sampled) {
+                cpis.push_back((double)intervals[i].cycles /
+                                       intervals[i].counted);
+            }
+        }
+        phase_samples[p] = cpis.size();
+        for(double c : cpis) {
+            cpi_mean[p] += c / cpis.size();
+        }
+        if(cpis.size() > 1) {
+            cpi_var[p] = 0;
+            for(double c : cpis) {
+                cpi_var[p] += (c - cpi_mean[p]) * (c - cpi_mean[p]) /
+                              (cpis.size() - 1);
+            }
+            pooled_var += cpi_var[p];
+            pooled_n   ++;
+        }
+    }
+
+    pooled_var = pooled_n ? pooled_var / pooled_n : 0;
+
+    double estimate = 0;
+    double variance = 0;
+
+    for(unsigned p = 0; p < phases && ok; p ++) {
+        double n   = phase_samples[p];
+        double N   = members[p].size();
+        if(n == 0) {
+            continue;   // Empty phase: no instructions to estimate.
+        }
+        double var = cpi_var[p] >= 0 ? cpi_var[p] : pooled_var;
+        estimate  += phase_instrs[p] * cpi_mean[p];
+        variance  += (double)phase_instrs[p] * phase_instrs[p] *
+                     (1 - n / N) * var / n;
+    }
+
+    double bound = 1.96 * std::sqrt(variance);
+
+    if(ok) {
+        std::cout << ">> Sampled " << n_samples << " of " << intervals.size()
+                  << " intervals of " << job.sample_interval
+                  << " instructions in " << phases << " phases, "
+                  << rtl_cycles << " RTL cycles." << std::endl
+                  << ">> Estimated " << (uint64_t)std::llround(estimate)
+                  << " +/- " << (uint64_t)std::llround(bound)
+                  << " cycles (95%)." << std::endl;
+
+        result.cycles       = std::llround(estimate);
+        result.cycles_bound = std::llround(bound);
+        result.status       = model.pc == job.pass_address ? BATCH_PASS :
+                                                             BATCH_FAIL;
+    }
+
+    std::chrono::duration<double> wall =
+        std::chrono::steady_clock::now() - wall_start;
+    result.wall_time = wall.count();
+
+    if(ok && job.sample_report != "") {
+
+        FILE * fh = fopen(job.sample_report.c_str(), "w");
+
+        if(fh == NULL) {
+            std::cout << ">> Could not open " << job.sample_report
+                      << std::endl;
+        } else {
+            fprintf(fh, "{\n  \"imem\": \"%s\",\n",
+                    json_escape(job.imem).c_str());
+            fprintf(fh, "  \"instructions\": %lu,\n",
+                    (unsigned long)model.instret);
+            fprintf(fh, "  \"interval\": %lu,\n  \"warmup\": %lu,\n",
+                    (unsigned long)job.sample_interval,
+                    (unsigned long)job.sample_warmup);
+            fprintf(fh, "  \"intervals\": %lu,\n  \"phases\": %u,\n",
+                    (unsigned long)intervals.size(), phases);
+            fprintf(fh, "  \"samples\": [\n");
+            size_t n = 0;
+            for(auto const & iv : intervals) {
+                if(!iv.sampled) {
+                    continue;
+                }
+                fprintf(fh, "    {\"start\": %lu, \"length\": %lu, "
+                            "\"phase\": %u, \"cycles\": %lu, "
+                            "\"counted\": %lu, \"weight\": %.6f}%s\n",
+                    (unsigned long)iv.start, (unsigned long)iv.length,
+                    iv.phase, (unsigned long)iv.cycles,
+                    (unsigned long)iv.counted,
+                    (double)phase_instrs[iv.phase] / model.instret /
+                            phase_samples[iv.phase],
+                    ++n < n_samples ? "," : "");
+            }
+            fprintf(fh, "  ],\n");
+            fprintf(fh, "  \"rtl_cycles\": %lu,\n",(unsigned long)rtl_cycles);
+            fprintf(fh, "  \"estimated_cycles\": %lu,\n",
+                    (unsigned long)result.cycles);
+            fprintf(fh, "  \"cycles_bound\": %lu,\n",
+                    (unsigned long)result.cycles_bound);
+            fprintf(fh, "  \"wall_time\": %.3f\n}\n", result.wall_time);
+            fclose(fh);
+        }
+    }
+
+    delete fresh;
+
+    return result.status;
+}
@@ -0,0 +1,56 @@
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "batch.hpp"
+#include "testbench.hpp"
+
+#ifndef SAMPLING_HPP
+#define SAMPLING_HPP
+
+//! Number of dimensions basic block vectors are projected down to.
+#define SAMPLE_DIMS 15
+
+//! One fixed length slice of the functional profile of a program.
+typedef struct sample_interval {
+    uint64_t    start   = 0;        //!< Index of the first instruction.
+    uint64_t    length  = 0;        //!< Instructions in the interval.
+    double      vec[SAMPLE_DIMS];   //!< Projected basic block vector.
+    unsigned    phase   = 0;        //!< Cluster the interval belongs to.
+    bool        sampled = false;    //!< Simulated on the RTL?
+    uint64_t    cycles  = 0;        //!< RTL cycles, if sampled.
+    uint64_t    counted = 0;        //!< Instructions cycles covers.
+} sample_interval_t;
+
+/*!
+@brief Run a job as a sampled (SimPoint style) simulation.
+@details
+    1. The whole program is run on the functional ISS, recording a basic
+       block vector (instructions executed per basic block) for each
+       job.sample_interval instructions.
+    2. The vectors are projected to SAMPLE_DIMS dimensions and clustered
+       into at most job.sample_phases phases with k-means.
+    3. The job.sample_per_phase intervals nearest the centre of each phase
+       are run on the RTL: the ISS fast-forwards to job.sample_warmup
+       instructions before the interval, the RTL runs the warm-up and
+       then the interval, and only the interval's cycles are counted.
+       Interval 0 starts at reset, so its first instruction is its
+       warm-up, and only the rest of it is counted.
+    4. Total cycles are extrapolated from each phase's mean cycles per
+       instruction, weighted by the instructions in that phase. The bound
+       is a 95% interval from the spread of CPIs within each phase (a
+       stratified sampling estimate). Phases with one sample use the
+       spread pooled over the other phases.
+    result.cycles is the estimate, and result.cycles_bound the bound.
+    The status is that of the ISS run, unless a sample fails on the RTL.
+@param in reuse - As for run_job.
+*/
+batch_status_t sample_job (
+    batch_job_t    & job    ,
+    batch_result_t & result ,
+    testbench      * reuse  = NULL
+);
+
+#endif
@@ -1,4 +1,6 @@
 
+#include <algorithm>
+#include <iomanip>
 #include <iostream>
 
 #include "sram_agent.hpp"
@@ -17,11 +19,15 @@ void sram_agent::set_reset(){
     *mem_gnt = 0;
     *mem_recv= 0;
 
-    // Empty the request queue.
-    while(this -> req_q.empty() == false) {
-        delete this -> req_q.back();
-        this -> req_q.pop();
-    }
+    n_mem_error   = 0;
+    n_mem_recv    = 0;
+    n_mem_rdata   = 0;
+    n_mem_gnt     = 0;
+
+    req_stall_len = 0;
+    rsp_stall_len = 0;
+
+    this -> flush_requests();
     
 }
 
@@ -29,6 +35,22 @@ void sram_agent::set_reset(){
 //! Take the interface out of reset
 void sram_agent::clear_reset(){
 
+    // Anything captured while the core was in reset is left over from
+    // the previous run of a re-used model, so drop it.
+    this -> flush_requests();
+
+}
+
+
+//! Empty the request queue.
+void sram_agent::flush_requests(){
+
+    while(this -> req_q.empty() == false) {
+        delete this -> req_q.front();
+        this -> req_q.pop();
+        this -> req_clock.pop();
+    }
+
 }
 
 
@@ -64,7 +86,16 @@ void sram_agent::drive_response(){
             n_mem_rdata = rsp -> data_word();
         }
 
+        uint64_t granted = req_clock.front();
+
+        if(granted != UINT64_MAX) {
+            uint64_t latency = this -> clock - granted + 1;
+            stats.latency[std::min<uint64_t>(latency,
+                          SRAM_AGENT_LATENCY_BUCKETS - 1)] ++;
+        }
+
         req_q.pop();
+        req_clock.pop();
         delete rsp;
         delete req;
 
@@ -92,6 +123,13 @@ void sram_agent::posedge_clk(){
         req_stall_len += 1;
     }
 
+    if(count_stats) {
+        stats.cycles   ++;
+        stats.gnt_wait += *mem_req && !*mem_gnt;
+        stats.queued   += !req_q.empty();
+        stats.idle     += !*mem_req && req_q.empty() && !*mem_recv;
+    }
+
     if(new_txn) {
         // There is an active request.
 
@@ -114,7 +152,27 @@ void sram_agent::posedge_clk(){
 
         }
 
+        if(count_stats) {
+
+            uint64_t bytes = 0;
+
+            for(int i = 0; i < 4 ; i ++) {
+                bytes += (*mem_strb >> i) & 0x1;
+            }
+
+            stats.requests ++;
+
+            if(*mem_wen) {
+                stats.writes        ++;
+                stats.bytes_written += bytes;
+            } else {
+                stats.reads         ++;
+                stats.bytes_read    += bytes ? bytes : 4;
+            }
+        }
+
         req_q.push(req);
+        req_clock.push(count_stats ? this -> clock : UINT64_MAX);
     }
     
     // Randomise the stall signal value.
@@ -136,4 +194,134 @@ void sram_agent::posedge_clk(){
 
     }
 
+    this -> clock ++;
+
+}
+
+
+//! Print stats, each line starting with name.
+void sram_agent::report(std::ostream & os, std::string const & name) {
+
+    sram_agent_stats_t const & s = this -> stats;
+
+    uint64_t responses = 0;
+    uint64_t total     = 0;
+    size_t   longest   = 0;
+
+    for(size_t i = 0; i < s.latency.size(); i ++) {
+        responses += s.latency[i];
+        total     += s.latency[i] * i;
+        longest    = s.latency[i] ? i : longest;
+    }
+
+    os << ">> " << name << ": " << std::dec << s.requests << " requests ("
+       << s.reads << " reads, " << s.writes << " writes), "
+       << s.bytes_read << " bytes read, " << s.bytes_written
+       << " written, in " << s.cycles << " cycles" << std::endl;
+
+    os << ">> " << name << ": " << std::fixed << std::setprecision(2)
+       << (s.cycles ? 100.0 * s.idle     / s.cycles : 0.0) << "% idle, "
+       << (s.cycles ? 100.0 * s.gnt_wait / s.cycles : 0.0)
+       << "% waiting for a grant, "
+       << (s.cycles ? 100.0 * s.queued   / s.cycles : 0.0)
+       << "% waiting for a response, "
+       << (s.cycles ? (double)s.requests / s.cycles : 0.0)
+       << " requests per cycle" << std::endl;
+
+    if(responses) {
+        os << ">> " << name << ": latency " << (double)total / responses
+           << " cycles on average," << std::defaultfloat;
+        for(size_t i = 1; i <= longest; i ++) {
+            os << " " << i << (i + 1 == s.latency.size() ? "+" : "")
+               << ":" << s.latency[i];
+        }
+        os << std::endl;
+    }
+
+    os << std::defaultfloat;
+
+}
+
+
+//! Write stats to fh as a JSON object.
+void sram_agent::write_json(FILE * fh) {
+
+    sram_agent_stats_t const & s = this -> stats;
+
+    fprintf(fh, "{\"cycles\": %lu, \"requests\": %lu, \"reads\": %lu, "
+                "\"writes\": %lu, \"bytes_read\": %lu, "
+                "\"bytes_written\": %lu, \"gnt_wait\": %lu, "
+                "\"queued\": %lu, \"idle\": %lu, \"latency\": [",
+            (unsigned long)s.cycles, (unsigned long)s.requests,
+            (unsigned long)s.reads, (unsigned long)s.writes,
+            (unsigned long)s.bytes_read, (unsigned long)s.bytes_written,
+            (unsigned long)s.gnt_wait, (unsigned long)s.queued,
+            (unsigned long)s.idle);
+
+    for(size_t i = 0; i < s.latency.size(); i ++) {
+        fprintf(fh, "%s%lu", i ? ", " : "", (unsigned long)s.latency[i]);
+    }
+
+    fprintf(fh, "]}");
+
+}
+
+
+//! Write queued requests and next signal values to a checkpoint.
+void sram_agent::save_state (VerilatedSerialize & os) {
+
+    os << req_stall_len << rsp_stall_len;
+    os << n_mem_error << n_mem_recv << n_mem_rdata << n_mem_gnt;
+
+    uint64_t num_reqs = req_q.size();
+    os << num_reqs;
+
+    // Rotate through the queue so it is left as it was found.
+    for(uint64_t i = 0; i < num_reqs; i ++) {
+
+        memory_req_txn * req = req_q.front();
+        req_q.pop();
+
+        uint64_t addr  = req -> addr();
+        uint64_t size  = req -> size();
+        bool     write = req -> is_write();
+
+        os << addr << size << write;
+        os.write(req -> data(), size);
+        os.write(req -> strb(), size * sizeof(bool));
+
+        req_q.push(req);
+    }
+
+}
+
+
+//! Restore the queue and next signal values written by save_state.
+void sram_agent::restore_state (VerilatedDeserialize & is) {
+
+    this -> flush_requests();
+
+    is >> req_stall_len >> rsp_stall_len;
+    is >> n_mem_error >> n_mem_recv >> n_mem_rdata >> n_mem_gnt;
+
+    uint64_t num_reqs = 0;
+    is >> num_reqs;
+
+    for(uint64_t i = 0; i < num_reqs; i ++) {
+
+        uint64_t addr  = 0;
+        uint64_t size  = 0;
+        bool     write = false;
+
+        is >> addr >> size >> write;
+
+        memory_req_txn * req = new memory_req_txn(addr, size, write);
+
+        is.read(req -> data(), size);
+        is.read(req -> strb(), size * sizeof(bool));
+
+        req_q.push(req);
+        req_clock.push(UINT64_MAX);
+    }
+
 }
@@ -1,12 +1,39 @@
 
+#include <cstdio>
+#include <ostream>
 #include <queue>
+#include <string>
+#include <vector>
+
+#include "verilated_save.h"
 
 #include "memory_txns.hpp"
 #include "memory_bus.hpp"
+#include "tb_random.hpp"
 
 #ifndef SRAM_AGENT_HPP
 #define SRAM_AGENT_HPP
 
+//! Response latencies counted apart. The last bucket holds longer ones too.
+#define SRAM_AGENT_LATENCY_BUCKETS 32
+
+//! Counts an sram_agent keeps of the traffic on its port.
+typedef struct sram_agent_stats {
+    uint64_t cycles        = 0; //!< Clock cycles counted.
+    uint64_t requests      = 0; //!< Requests granted.
+    uint64_t reads         = 0;
+    uint64_t writes        = 0;
+    uint64_t bytes_read    = 0; //!< By strobe. A read without one is 4.
+    uint64_t bytes_written = 0;
+    uint64_t gnt_wait      = 0; //!< Cycles a request waited for a grant.
+    uint64_t queued        = 0; //!< Cycles a granted request waited.
+    uint64_t idle          = 0; //!< Cycles with nothing asked or pending.
+
+    //! Responses by cycles from grant to response.
+    std::vector<uint64_t> latency =
+        std::vector<uint64_t>(SRAM_AGENT_LATENCY_BUCKETS, 0);
+} sram_agent_stats_t;
+
 /*!
 @brief Acts as an SRAM slave agent.
 */
@@ -31,6 +58,12 @@ public:
     //! Drive any signal updates
     void drive_signals();
 
+    //! Write queued requests and next signal values to a checkpoint.
+    void save_state (VerilatedSerialize & os);
+
+    //! Restore the queue and next signal values written by save_state.
+    void restore_state (VerilatedDeserialize & is);
+
     // Request channel
     uint8_t  * mem_req  ; // Start memory request
     uint8_t  * mem_gnt  ; // request accepted
@@ -51,6 +84,18 @@ public:
     //! Maximum length of a stalled response.
     uint32_t   max_rsp_stall = 5;
 
+    //! Count cycles and requests in stats? E.g. only inside the ROI.
+    bool       count_stats   = true;
+
+    //! Traffic counted so far.
+    sram_agent_stats_t stats;
+
+    //! Print stats, each line starting with name.
+    void report(std::ostream & os, std::string const & name);
+
+    //! Write stats to fh as a JSON object.
+    void write_json(FILE * fh);
+
 protected:
 
     //! Current request stall length.
@@ -64,6 +109,12 @@ protected:
     
     //! Queue of requests to handle.
     std::queue<memory_req_txn *> req_q;
+
+    //! Clock cycles since construction.
+    uint64_t   clock         = 0;
+
+    //! Clock cycle each of req_q was granted in. UINT64_MAX: not counted.
+    std::queue<uint64_t> req_clock;
     
     uint8_t  n_mem_error;  // Next Error
     uint8_t  n_mem_recv ;  // Next Memory stall
@@ -71,11 +122,14 @@ protected:
     uint32_t n_mem_gnt  ;  // Next request grant.
     
     uint8_t rand_chance(int a, int b) {
-        return ((rand() % b) < a) ? 1 : 0;
+        return ((int)(tb_rand() % b) < a) ? 1 : 0;
     }
     
     //! Drives the response channel.
     void drive_response();
+
+    //! Empty the request queue.
+    void flush_requests();
 };
 
 #endif
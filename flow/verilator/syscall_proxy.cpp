@@ -0,0 +1,327 @@
+
+#include <cerrno>
+#include <cstdlib>
+#include <iostream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "syscall_proxy.hpp"
+
+//! Largest path accepted by open().
+#define SYSCALL_PATH_MAX 1024
+
+//! Largest single read or write, so one call cannot stall the simulation.
+#define SYSCALL_IO_MAX   (1 << 20)
+
+
+//! Resolve path's symbolic links, "." and "..". Empty if it cannot be.
+static std::string syscall_realpath(std::string const & path) {
+    char      * r  = realpath(path.c_str(), NULL);
+    std::string tr = r ? r : "";
+    free(r);
+    return tr;
+}
+
+
+//! Create a proxy which reads and writes program memory through mem.
+syscall_proxy::syscall_proxy (
+    memory_bus * mem
+) {
+
+    this -> mem = mem;
+
+}
+
+
+//! Close any files the program left open.
+syscall_proxy::~syscall_proxy() {
+
+    this -> reset();
+
+}
+
+
+//! Close every file and forget any exit.
+void syscall_proxy::reset() {
+
+    for(auto const & it : this -> files) {
+        close(it.second);
+    }
+
+    this -> files.clear();
+    this -> writes.clear();
+
+    this -> next_fd   = 3;
+    this -> exited    = false;
+    this -> exit_code = 0;
+
+}
+
+
+uint32_t syscall_proxy::read_word(uint32_t addr) {
+
+    uint32_t tr = 0;
+
+    for(int i = 0; i < 4; i ++) {
+        tr |= (uint32_t)this -> mem -> read_byte(addr + i) << (8*i);
+    }
+
+    return tr;
+
+}
+
+
+void syscall_proxy::write_byte(uint32_t addr, uint8_t data) {
+
+    this -> mem -> write_byte(addr, data);
+    this -> writes.push_back({addr, data});
+
+}
+
+
+void syscall_proxy::write_word(uint32_t addr, uint32_t data) {
+
+    for(int i = 0; i < 4; i ++) {
+        this -> write_byte(addr + i, data >> (8*i));
+    }
+
+}
+
+
+//! Read a NUL terminated string from program memory.
+bool syscall_proxy::read_string(uint32_t addr, std::string & s, size_t max) {
+
+    s.clear();
+
+    for(size_t i = 0; i < max; i ++) {
+        char c = this -> mem -> read_byte(addr + i);
+        if(c == 0) {
+            return true;
+        }
+        s += c;
+    }
+
+    return false;
+
+}
+
+
+//! Service the call whose argument block is at addr.
+void syscall_proxy::call(uint32_t addr, uint64_t cycles) {
+
+    uint32_t n = this -> read_word(addr);
+    uint32_t a[6];
+
+    for(int i = 0; i < 6; i ++) {
+        a[i] = this -> read_word(addr + 4 + 4*i);
+    }
+
+    this -> writes.clear();
+
+    int32_t result = -ENOSYS;
+
+    switch(n) {
+
+        case SYSCALL_WRITE: result = sys_write(a[0], a[1], a[2]); break;
+        case SYSCALL_READ : result = sys_read (a[0], a[1], a[2]); break;
+        case SYSCALL_OPEN : result = sys_open (a[0], a[1], a[2]); break;
+        case SYSCALL_CLOSE: result = sys_close(a[0]);             break;
+        case SYSCALL_LSEEK: result = sys_lseek(a[0], a[1], a[2]); break;
+
+        case SYSCALL_EXIT:
+            this -> exited    = true;
+            this -> exit_code = a[0];
+            result            = 0;
+            break;
+
+        case SYSCALL_GETTIMEOFDAY: {
+            uint64_t usec = cycles * 1000000 / this -> clock_hz;
+            this -> write_word(addr + 4, (uint32_t)(usec      ));
+            this -> write_word(addr + 8, (uint32_t)(usec >> 32));
+            result = 0;
+            break;
+        }
+
+        default:
+            std::cout << ">> Unsupported system call " << std::dec << n
+                      << std::endl;
+            break;
+    }
+
+    this -> write_word(addr, result);
+
+}
+
+
+int32_t syscall_proxy::sys_write(uint32_t fd, uint32_t buf, uint32_t len) {
+
+    if(len > SYSCALL_IO_MAX) {
+        len = SYSCALL_IO_MAX;
+    }
+
+    std::string data(len, 0);
+
+    for(uint32_t i = 0; i < len; i ++) {
+        data[i] = this -> mem -> read_byte(buf + i);
+    }
+
+    if(fd == 1 || fd == 2) {
+        std::cout.write(data.data(), len);
+        std::cout.flush();
+        return len;
+    }
+
+    auto it = this -> files.find(fd);
+
+    if(it == this -> files.end()) {
+        return -EBADF;
+    }
+
+    ssize_t w = write(it -> second, data.data(), len);
+
+    return w < 0 ? -errno : (int32_t)w;
+
+}
+
+
+int32_t syscall_proxy::sys_read(uint32_t fd, uint32_t buf, uint32_t len) {
+
+    if(fd == 0) {
+        return 0;
+    }
+
+    auto it = this -> files.find(fd);
+
+    if(it == this -> files.end()) {
+        return -EBADF;
+    }
+
+    if(len > SYSCALL_IO_MAX) {
+        len = SYSCALL_IO_MAX;
+    }
+
+    std::string data(len, 0);
+
+    ssize_t r = read(it -> second, &data[0], len);
+
+    if(r < 0) {
+        return -errno;
+    }
+
+    for(ssize_t i = 0; i < r; i ++) {
+        this -> write_byte(buf + i, data[i]);
+    }
+
+    return r;
+
+}
+
+
+int32_t syscall_proxy::sys_open(uint32_t path, uint32_t flags, uint32_t mode) {
+
+    std::string p;
+
+    if(this -> sandbox == "") {
+        return -EACCES;
+    }
+
+    if(!this -> read_string(path, p, SYSCALL_PATH_MAX)) {
+        return -ENAMETOOLONG;
+    }
+
+    // Keep the program inside the sandbox.
+    if(p.empty() || p[0] == '/' || p == ".." || p.find("../") == 0 ||
+       p.find("/../") != std::string::npos ||
+       (p.size() >= 3 && p.compare(p.size() - 3, 3, "/..") == 0)) {
+        return -EACCES;
+    }
+
+    int host_flags;
+
+    switch(flags & SYSCALL_O_ACCMODE) {
+        case 0 : host_flags = O_RDONLY; break;
+        case 1 : host_flags = O_WRONLY; break;
+        case 2 : host_flags = O_RDWR  ; break;
+        default: return -EINVAL;
+    }
+
+    if(flags & SYSCALL_O_CREAT ) host_flags |= O_CREAT ;
+    if(flags & SYSCALL_O_EXCL  ) host_flags |= O_EXCL  ;
+    if(flags & SYSCALL_O_TRUNC ) host_flags |= O_TRUNC ;
+    if(flags & SYSCALL_O_APPEND) host_flags |= O_APPEND;
+
+    // A symbolic link inside the sandbox may still point out of it, so
+    // check where the directory opened in really is, and do not follow
+    // a link in the last component.
+    std::string full   = this -> sandbox + "/" + p;
+    std::string root   = syscall_realpath(this -> sandbox);
+    std::string parent = syscall_realpath(full.substr(0, full.rfind('/')));
+
+    if(root == "" || parent == "") {
+        return -ENOENT;
+    }
+
+    if(parent != root && parent.compare(0, root.size() + 1, root + "/") != 0) {
+        return -EACCES;
+    }
+
+    host_flags |= O_NOFOLLOW;
+
+    int hfd = open(full.c_str(), host_flags, mode & 0777);
+
+    if(hfd < 0) {
+        return -errno;
+    }
+
+    uint32_t fd = this -> next_fd ++;
+
+    this -> files[fd] = hfd;
+
+    return fd;
+
+}
+
+
+int32_t syscall_proxy::sys_close(uint32_t fd) {
+
+    if(fd <= 2) {
+        return 0;
+    }
+
+    auto it = this -> files.find(fd);
+
+    if(it == this -> files.end()) {
+        return -EBADF;
+    }
+
+    close(it -> second);
+
+    this -> files.erase(it);
+
+    return 0;
+
+}
+
+
+int32_t syscall_proxy::sys_lseek(uint32_t fd, int32_t offset, uint32_t whence) {
+
+    auto it = this -> files.find(fd);
+
+    if(it == this -> files.end()) {
+        return fd <= 2 ? -ESPIPE : -EBADF;
+    }
+
+    int host_whence = whence == 0 ? SEEK_SET :
+                      whence == 1 ? SEEK_CUR :
+                      whence == 2 ? SEEK_END : -1;
+
+    if(host_whence < 0) {
+        return -EINVAL;
+    }
+
+    off_t r = lseek(it -> second, offset, host_whence);
+
+    return r < 0 ? -errno : (int32_t)r;
+
+}
@@ -0,0 +1,114 @@
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "memory_bus.hpp"
+
+#ifndef SYSCALL_PROXY_HPP
+#define SYSCALL_PROXY_HPP
+
+// System call numbers, as used by the RISC-V newlib port.
+#define SYSCALL_CLOSE           57
+#define SYSCALL_LSEEK           62
+#define SYSCALL_READ            63
+#define SYSCALL_WRITE           64
+#define SYSCALL_EXIT            93
+#define SYSCALL_GETTIMEOFDAY    169
+#define SYSCALL_OPEN            1024
+
+// open() flags, as passed by the program. Translated to the host's own.
+#define SYSCALL_O_ACCMODE       0x003
+#define SYSCALL_O_CREAT         0x040
+#define SYSCALL_O_EXCL          0x080
+#define SYSCALL_O_TRUNC         0x200
+#define SYSCALL_O_APPEND        0x400
+
+/*!
+@brief Services newlib system calls made by a program through the tohost
+    register of the exit device (see src/libgloss).
+@details The program fills in an 8 word, 8 byte aligned argument block:
+    the call number, then up to six arguments. It writes the address of
+    the block to TOHOST, and waits for FROMHOST to become non-zero. The
+    result, or minus the error number, is written over the call number.
+
+    Calls:
+    - write(fd, buf, len): fds 1 and 2 go to the host's stdout.
+    - read(fd, buf, len): fd 0 is always at end of file.
+    - open(path, flags, mode) / close(fd) / lseek(fd, offset, whence):
+      path is relative to sandbox and may not contain "..", nor lead
+      out of it through a symbolic link. With no sandbox, every open()
+      fails.
+    - exit(code).
+    - gettimeofday(): writes the microseconds since reset, from the cycle
+      count and clock_hz, to words 1 (low) and 2 (high) of the block.
+
+    Open files are not saved in checkpoints.
+*/
+class syscall_proxy {
+
+public:
+
+    //! Create a proxy which reads and writes program memory through mem.
+    syscall_proxy (
+        memory_bus * mem
+    );
+
+    //! Close any files the program left open.
+    ~syscall_proxy();
+
+    /*!
+    @brief Service the call whose argument block is at addr.
+    @param in cycles - Clock cycles since reset, for gettimeofday.
+    */
+    void call(uint32_t addr, uint64_t cycles);
+
+    //! Close every file and forget any exit.
+    void reset();
+
+    //! Directory program paths are relative to. Empty: open() fails.
+    std::string sandbox     = "";
+
+    //! Clock frequency the cycle count is converted to time with.
+    uint64_t    clock_hz    = 100000000;
+
+    //! Set by an exit call.
+    bool        exited      = false;
+
+    //! Code passed to the exit call.
+    uint32_t    exit_code   = 0;
+
+    //! Program memory written by the last call(), in order.
+    std::vector<std::pair<uint32_t,uint8_t>> writes;
+
+protected:
+
+    //! Program memory.
+    memory_bus * mem;
+
+    //! Open files: program fd to host fd.
+    std::map<uint32_t,int> files;
+
+    //! Next program fd to hand out.
+    uint32_t    next_fd     = 3;
+
+    uint32_t    read_word (uint32_t addr);
+    void        write_word(uint32_t addr, uint32_t data);
+    void        write_byte(uint32_t addr, uint8_t  data);
+
+    /*!
+    @brief Read a NUL terminated string from program memory.
+    @returns false if it is longer than max bytes.
+    */
+    bool        read_string(uint32_t addr, std::string & s, size_t max);
+
+    int32_t     sys_write(uint32_t fd, uint32_t buf, uint32_t len);
+    int32_t     sys_read (uint32_t fd, uint32_t buf, uint32_t len);
+    int32_t     sys_open (uint32_t path, uint32_t flags, uint32_t mode);
+    int32_t     sys_close(uint32_t fd);
+    int32_t     sys_lseek(uint32_t fd, int32_t offset, uint32_t whence);
+
+};
+
+#endif
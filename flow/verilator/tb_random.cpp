@@ -0,0 +1,24 @@
+
+#include "tb_random.hpp"
+
+//! splitmix64 state. Any value is a valid state.
+static uint64_t tb_rand_state = 1;
+
+void tb_srand (uint64_t seed) {
+    tb_rand_state = seed;
+}
+
+uint32_t tb_rand () {
+    uint64_t z = (tb_rand_state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return (uint32_t)((z ^ (z >> 31)) >> 32);
+}
+
+uint64_t tb_rand_get_state () {
+    return tb_rand_state;
+}
+
+void tb_rand_set_state (uint64_t state) {
+    tb_rand_state = state;
+}
@@ -0,0 +1,24 @@
+
+#include <cstdint>
+
+#ifndef TB_RANDOM_HPP
+#define TB_RANDOM_HPP
+
+/*!
+@brief Seed the PRNG shared by all of the testbench agents.
+@details Used in place of srand()/rand() so the random stall and sample
+    stream is the same on every host C library, and so its state can be
+    saved with a checkpoint.
+*/
+void     tb_srand (uint64_t seed);
+
+//! Return the next 32-bit sample from the testbench PRNG.
+uint32_t tb_rand  ();
+
+//! Return the complete state of the testbench PRNG.
+uint64_t tb_rand_get_state ();
+
+//! Overwrite the complete state of the testbench PRNG.
+void     tb_rand_set_state (uint64_t state);
+
+#endif
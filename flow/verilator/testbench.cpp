@@ -1,4 +1,11 @@
 
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#include "srec.hpp"
+#include "tb_random.hpp"
 #include "testbench.hpp"
 
 
@@ -16,43 +23,448 @@ void testbench::build() {
         this -> uart_base_addr
     );
 
+    this -> exit_0 = new memory_device_exit (
+        this -> exit_base_addr
+    );
+
     this -> bus -> add_device(this -> default_ram);
     this -> bus -> add_device(this -> uart_0);
+    this -> bus -> add_device(this -> exit_0);
+
+    this -> syscalls = new syscall_proxy(this -> bus);
+
+    // Not added to the bus until it is needed by handoff(). A page above
+    // the default memory, since device ranges include their top address.
+    this -> handoff_ram = new memory_device_ram(
+        this -> default_ram_base_addr + this -> default_ram_size + 0x1000,
+        this -> handoff_ram_size
+    );
 
     this -> dut = new dut_wrapper(
         this -> bus,
         this -> waves_dump,
-        this -> waves_file
+        this -> waves_file,
+        this -> waves_depth,
+        this -> waves_scope
     );
 
 }
+
+//! Free everything created by build().
+testbench::~testbench() {
+
+    if(this -> checker) {
+        this -> dut -> checker = NULL;
+        delete this -> checker;
+    }
+
+    delete this -> handoff_state;
+    delete this -> dut;
+    delete this -> bus;
+    delete this -> uart_0;
+    delete this -> syscalls;
+    delete this -> exit_0;
+    delete this -> default_ram;
+    delete this -> handoff_ram;
+
+}
+
+
+//! Return the testbench to its just-built state.
+void testbench::reset() {
+
+    this -> sim_finished = false;
+    this -> sim_passed   = false;
+    this -> restored     = false;
+    this -> saved        = false;
+    this -> rtl_instrs   = 0;
+    this -> cosim_failed = false;
+    this -> sim_exited   = false;
+    this -> exit_code    = 0;
+    this -> sim_hung     = false;
+    this -> hang_pc      = 1;
+    this -> hang_count   = 0;
+    this -> wfi_skipped  = 0;
+
+    // Per-job settings, which the caller sets again after reset().
+    this -> save_path      = "";
+    this -> save_at_cycle  = 0;
+    this -> max_rtl_instrs = 0;
+    this -> cosim_enable   = false;
+    this -> max_sim_time   = 10000;
+    this -> pass_address   = 0;
+    this -> fail_address   = -1;
+    this -> hang_limit     = 1000;
+    this -> wfi_skip       = false;
+    this -> flight_period  = 0;
+    this -> flight_path    = "";
+
+    this -> syscalls -> sandbox = "";
+    this -> dut -> roi_enable   = false;
+    this -> dut -> irq_if_agent -> set_random(0, 0, 1);
+    this -> dut -> set_imem_max_stall(5);
+    this -> dut -> set_dmem_max_stall(5);
+
+    this -> flight_clear();
+
+    if(this -> checker) {
+        this -> dut -> checker = NULL;
+        delete this -> checker;
+        this -> checker = NULL;
+    }
+
+    if(this -> handoff_pending) {
+        this -> bus -> remove_device(this -> handoff_ram);
+        this -> handoff_pending = false;
+    }
+
+    // The agents all draw from the shared testbench PRNG.
+    tb_srand(this -> random_seed);
+
+    this -> bus -> reset();
+    this -> syscalls -> reset();
+    this -> dut -> dut_restart();
+
+}
+
+
+//! reset() the testbench, then load a new SREC image into memory.
+bool testbench::reset_and_load(std::string image) {
+
+    this -> reset();
+
+    if(!std::ifstream(image).good()) {
+        return false;
+    }
+
+    srec::srec_file fh(image);
+
+    for(auto it  = fh.data.begin();
+             it != fh.data.end();
+             it ++) {
+        this -> bus -> write_byte(it -> first, it -> second);
+    }
+
+    return true;
+
+}
+
+
+//! Identifies checkpoint files, and their layout version.
+static std::string checkpoint_magic = "frv-checkpoint-5";
+
+
+//! Write the complete simulation state to a checkpoint file.
+bool testbench::save_checkpoint(std::string path) {
+
+    VerilatedSave os;
+
+    os.open(path.c_str());
+
+    if(!os.isOpen()) {
+        return false;
+    }
+
+    std::string magic = checkpoint_magic;
+
+    os << magic;
+
+    this -> dut -> save_state(os);
+    this -> bus -> save_state(os);
+
+    os.close();
+
+    return true;
+
+}
+
+
+//! Load a checkpoint written by save_checkpoint.
+bool testbench::restore_checkpoint(std::string path) {
+
+    VerilatedRestore is;
+
+    is.open(path.c_str());
+
+    if(!is.isOpen()) {
+        return false;
+    }
+
+    std::string magic;
+
+    is >> magic;
+
+    if(magic != checkpoint_magic) {
+        is.close();
+        return false;
+    }
+
+    this -> dut -> restore_state(is);
+    this -> bus -> restore_state(is);
+
+    is.close();
+
+    this -> restored = true;
+
+    return true;
+
+}
+
+
+//! Run the loaded program on the ISS, then hand over to the RTL.
+bool testbench::fast_forward(
+    bool     to_pc     ,
+    uint32_t ff_pc     ,
+    uint64_t max_instrs
+) {
+
+    // The core always starts at the base of the default RAM.
+    uint32_t reset_pc = this -> default_ram_base_addr;
+
+    iss model(this -> bus);
+
+    model.reset(reset_pc);
+
+    std::vector<uint32_t> stop_pcs = {
+        (uint32_t)pass_address, (uint32_t)fail_address
+    };
+
+    if(to_pc) {
+        stop_pcs.push_back(ff_pc);
+    }
+
+    iss_stop_t why = model.run(stop_pcs, max_instrs);
+
+    std::cout << ">> Fast-forwarded " << std::dec << model.instret
+              << " instructions to 0x" << std::hex << model.pc << std::dec;
+
+    if(why == ISS_STOP_UNSUPPORTED) {
+        std::cout << " (next instruction left to the RTL)";
+    }
+
+    std::cout << std::endl;
+
+    return this -> handoff(model);
+
+}
+
+
+//! Start the next run_simulation() from the state of model.
+bool testbench::handoff(iss & model) {
+
+    uint32_t reset_pc = this -> default_ram_base_addr;
+    uint32_t base     = this -> handoff_ram -> get_base();
+
+    std::vector<uint32_t> code = model.handoff_code(base);
+
+    // lui x1, %hi(base) ; jalr x0, %lo(base)(x1). The handoff program
+    // reloads x1 afterwards.
+    uint32_t jump[2] = {
+        ((base + 0x800) & 0xFFFFF000) | 1 << 7 | 0x37,
+        (base & 0xFFF) << 20 | 1 << 15 | 0x67
+    };
+
+    uint32_t jump_end = reset_pc + sizeof(jump);
+
+    auto overwritten = [&](uint32_t a) {
+        return a >= reset_pc && a < jump_end;
+    };
+
+    if(code.empty() || 4*code.size() > this -> handoff_ram_size ||
+       overwritten(model.pc) ||
+       overwritten(pass_address) || overwritten(fail_address) ||
+       this -> bus -> get_device_at(base) != NULL) {
+        std::cout << ">> Cannot hand over to the RTL at 0x" << std::hex
+                  << model.pc << std::dec << std::endl;
+        return false;
+    }
+
+    this -> handoff_ram -> reset();
+
+    for(size_t i = 0; i < 4*code.size(); i ++) {
+        this -> handoff_ram -> write_byte(base + i, code[i/4] >> (8*(i%4)));
+    }
+
+    this -> handoff_saved.clear();
+
+    for(uint32_t a = reset_pc; a < jump_end; a ++) {
+        this -> handoff_saved.push_back(this -> bus -> read_byte(a));
+        this -> bus -> write_byte(a, jump[(a-reset_pc)/4] >> (8*(a & 0x3)));
+    }
+
+    this -> bus -> add_device(this -> handoff_ram);
+
+    this -> handoff_jump_pc = base + 4*(code.size() - 1);
+    this -> handoff_pending = true;
+
+    delete this -> handoff_state;
+    this -> handoff_state   = new iss(model);
+
+    return true;
+
+}
+
+
+//! Start checking the RTL from the architectural state of start.
+void testbench::cosim_start(iss const & start) {
+
+    this -> checker        = new cosim(start, *this -> default_ram);
+    this -> dut -> checker = this -> checker;
+
+}
+
+
+//! Wait for the checker to catch up, report on it, and free it.
+void testbench::cosim_stop() {
+
+    if(this -> checker == NULL) {
+        return;
+    }
+
+    this -> dut -> checker = NULL;
+
+    if(this -> checker -> finish()) {
+        std::cout << ">> Co-simulation checked " << std::dec
+                  << this -> checker -> checked() << " instructions"
+                  << std::endl;
+    } else {
+        std::cout << this -> checker -> report();
+        this -> cosim_failed = true;
+        this -> sim_passed   = false;
+    }
+
+    delete this -> checker;
+    this -> checker = NULL;
+
+}
     
 //! Called immediately before the run function.
 void testbench::pre_run() {
 
-    this -> dut -> dut_set_reset();
+    if(!this -> restored) {
+        this -> dut -> dut_set_reset();
+    }
 
 }
 
 //! The main phase of the DUT simulation.
 void testbench::run() {
    
-    // Run the DUT for a few cycles while held in reset.
-    for(int i = 0; i < 5; i ++) {
-        dut -> dut_step_clk();
+    if(!this -> restored) {
+
+        // Run the DUT for a few cycles while held in reset.
+        for(int i = 0; i < 5; i ++) {
+            dut -> dut_step_clk();
+        }
+        
+        if(cosim_enable && !handoff_pending) {
+            iss start(bus);
+            start.reset(this -> default_ram_base_addr);
+            cosim_start(start);
+        }
+
+        // Start running the DUT proper.
+        dut -> dut_clear_reset();
+
     }
     
-    // Start running the DUT proper.
-    dut -> dut_clear_reset();
-    
     dut_trace_pkt_t trs_item;
 
     while(dut -> get_sim_time() < max_sim_time && !sim_finished) {
         
         dut -> dut_step_clk();
 
+        // An odd command is an exit, an even one the address of a system
+        // call argument block.
+        uint32_t tohost;
+        uint32_t marker;
+
+        if(exit_0 -> take_command(tohost)) {
+
+            if(!(tohost & 0x1)) {
+
+                syscalls -> call(tohost, dut -> get_sim_time() / 10);
+
+                if(checker) {
+                    for(auto const & w : syscalls -> writes) {
+                        checker -> host_write(w.first, w.second);
+                    }
+                }
+
+                exit_0 -> reg_fromhost = 1;
+
+                if(syscalls -> exited) {
+                    tohost = syscalls -> exit_code << 1 | 0x1;
+                }
+            }
+
+            if(tohost & 0x1) {
+                sim_exited  = true;
+                exit_code   = tohost >> 1;
+                sim_passed  = exit_code == 0;
+                sim_finished= true;
+            }
+        }
+
+        if(exit_0 -> take_marker(marker)) {
+            dut -> marker_written(marker);
+        }
+
+        if(flight_period && !handoff_pending &&
+           dut -> get_sim_time() >= flight_next * 10) {
+            flight_save();
+        }
+
+        if(save_path != "" && !saved && !handoff_pending &&
+           dut -> get_sim_time() >= save_at_cycle * 10) {
+
+            saved = true;
+
+            if(save_checkpoint(save_path)) {
+                std::cout << ">> Saved checkpoint at cycle "
+                          << std::dec << dut -> get_sim_time() / 10
+                          << " to " << save_path << std::endl;
+            } else {
+                std::cout << ">> Could not save checkpoint to "
+                          << save_path << std::endl;
+            }
+        }
+
         if(dut -> dut_trace.empty() == false) {
             trs_item = dut -> dut_trace.front();
+
+            if(handoff_pending &&
+               trs_item.program_counter == handoff_jump_pc) {
+
+                // The RTL now holds the ISS state: put back the reset
+                // vector and unmap the handoff program.
+                uint32_t reset_pc = this -> default_ram_base_addr;
+
+                for(size_t i = 0; i < handoff_saved.size(); i ++) {
+                    bus -> write_byte(reset_pc + i, handoff_saved[i]);
+                }
+
+                bus -> remove_device(handoff_ram);
+
+                handoff_pending = false;
+                rtl_instrs      = 0;
+
+                std::cout << ">> Handed over to the RTL at cycle "
+                          << std::dec << dut -> get_sim_time() / 10
+                          << std::endl;
+
+                if(cosim_enable) {
+                    cosim_start(*handoff_state);
+                }
+
+            } else if(!handoff_pending) {
+
+                rtl_instrs ++;
+
+                if(max_rtl_instrs && rtl_instrs >= max_rtl_instrs) {
+                    sim_finished = true;
+                }
+            }
             
             if(trs_item.program_counter == pass_address) {
                 sim_passed  = true;
@@ -62,15 +474,154 @@ void testbench::run() {
                 sim_finished= true;
             }
 
+            if(trs_item.program_counter == hang_pc) {
+                hang_count ++;
+            } else {
+                hang_pc    = trs_item.program_counter;
+                hang_count = 0;
+            }
+
+            if(hang_limit && hang_count >= hang_limit && !sim_finished) {
+                std::cout << ">> Hang: 0x" << std::hex << hang_pc << std::dec
+                          << " retired " << hang_count << " times in a row"
+                          << std::endl;
+                sim_hung    = true;
+                sim_passed  = false;
+                sim_finished= true;
+            }
+
+            if(wfi_skip && !sim_finished && !handoff_pending &&
+               trs_item.instr_word == TB_WFI_INSTR) {
+                idle_skip();
+            }
+
             dut -> dut_trace.pop();
         }
 
+        if(checker && checker -> failed()) {
+            sim_finished = true;
+        }
+
+    }
+
+}
+
+//! The earliest cycle at which the testbench must be stepping the model.
+uint64_t testbench::next_event_cycle() {
+
+    uint64_t next = this -> max_sim_time / 10;
+
+    if(this -> save_path != "" && !this -> saved &&
+       this -> save_at_cycle < next) {
+        next = this -> save_at_cycle;
+    }
+
+    if(this -> flight_period && this -> flight_next < next) {
+        next = this -> flight_next;
+    }
+
+    // The interrupt agent counts whole periods of g_clk.
+    uint64_t irq  = dut -> irq_if_agent -> cycles_to_next();
+    uint64_t now  = dut -> get_sim_time() / 10;
+
+    if(irq < (next - std::min(next, now)) / 2) {
+        next = now + 2 * irq;
     }
 
+    return next;
+
 }
 
+
+//! Skip over the cycles the core would spend asleep in a WFI.
+void testbench::idle_skip() {
+
+    // Simulation "cycles" are half periods of g_clk, while mtime counts
+    // whole periods.
+    uint64_t now    = dut -> get_sim_time() / 10;
+    uint64_t mtime  = dut -> dut_mtime();
+    uint64_t cmp    = dut -> dut_mtimecmp();
+    uint64_t limit  = this -> next_event_cycle();
+
+    if(!dut -> dut_timer_irq_enabled() || cmp == UINT64_MAX) {
+        // Nothing will wake the core: WFI is a NOP, so let it run on.
+        return;
+    }
+
+    if(cmp <= mtime + TB_WFI_MARGIN || limit <= now + 2) {
+        // The interrupt is (nearly) due, or something else is.
+        return;
+    }
+
+    // The skipping period itself counts as one.
+    uint64_t skip   = cmp - mtime - TB_WFI_MARGIN;
+
+    if(skip > (limit - now - 2) / 2) {
+        skip = (limit - now - 2) / 2;
+    }
+
+    dut -> dut_skip_clk(skip);
+
+    this -> wfi_skipped += 2 * skip;
+
+}
+
+
+//! Write the next flight recorder checkpoint.
+void testbench::flight_save() {
+
+    unsigned slot = this -> flight_slot;
+
+    // Moved on even if the save fails, so it is not tried every cycle.
+    this -> flight_saved[slot] =
+        save_checkpoint(this -> flight_path + "." + std::to_string(slot));
+    this -> flight_slot        = slot ^ 1;
+    this -> flight_next        = dut -> get_sim_time() / 10 +
+                                 this -> flight_period;
+
+}
+
+
+//! The oldest flight recorder checkpoint kept.
+std::string testbench::flight_checkpoint() {
+
+    // The next one to be overwritten is the older.
+    unsigned slot = this -> flight_slot;
+
+    if(!this -> flight_saved[slot]) {
+        slot ^= 1;
+    }
+
+    if(!this -> flight_saved[slot]) {
+        return "";
+    }
+
+    return this -> flight_path + "." + std::to_string(slot);
+
+}
+
+
+//! Delete the flight recorder checkpoint files.
+void testbench::flight_clear() {
+
+    for(unsigned slot = 0; slot < 2; slot ++) {
+        if(this -> flight_saved[slot]) {
+            std::remove(
+                (this -> flight_path + "." + std::to_string(slot)).c_str());
+        }
+        this -> flight_saved[slot] = false;
+    }
+
+    this -> flight_slot = 0;
+    this -> flight_next = 0;
+
+}
+
+
 //! Called after the run function has returned.
 void testbench::post_run() {
+
+    this -> cosim_stop();
     
     if(this -> waves_dump) {
         dut -> trace_fh -> close();
@@ -3,29 +3,49 @@
 #include "memory_device.hpp"
 #include "memory_device_ram.hpp"
 #include "memory_device_uart.hpp"
+#include "memory_device_exit.hpp"
 #include "memory_bus.hpp"
 
 #include "dut_wrapper.hpp"
+#include "iss.hpp"
+#include "cosim.hpp"
+#include "syscall_proxy.hpp"
 
 #ifndef TESTBENCH_HPP
 #define TESTBENCH_HPP
 
+//! Encoding of the WFI instruction.
+#define TB_WFI_INSTR    0x10500073
+
+/*!
+@brief Cycles before the timer interrupt at which an idle skip stops, so
+    the core raises the interrupt itself.
+*/
+#define TB_WFI_MARGIN   2
+
 class testbench {
 
 public:
     
-    //! Create a new testbench.
+    //! Create a new testbench. See dut_wrapper for the wave arguments.
     testbench (
         std::string waves_file,
-        bool        waves_dump
+        bool        waves_dump,
+        int         waves_depth = 99,
+        std::string waves_scope = ""
     ) {
         
-        this -> waves_file = waves_file;
-        this -> waves_dump = waves_dump;
+        this -> waves_file  = waves_file;
+        this -> waves_dump  = waves_dump;
+        this -> waves_depth = waves_depth;
+        this -> waves_scope = waves_scope;
 
         this -> build();
     }
 
+    //! Free everything created by build().
+    ~testbench();
+
     //! Memory device bus.
     memory_bus  * bus;
     
@@ -35,9 +55,117 @@ public:
     //! UART device used to print messages.
     memory_device_uart * uart_0;
 
+    //! Device through which the program can end the simulation.
+    memory_device_exit * exit_0;
+
+    //! Services the system calls the program makes through exit_0.
+    syscall_proxy * syscalls;
+
+    //! Holds the handoff program. Only on the bus during a handoff.
+    memory_device_ram * handoff_ram;
+
     //! The design under test.
     dut_wrapper * dut;
 
+    /*!
+    @brief Return the testbench to its just-built state, ready for a new
+        test, without re-constructing the model or any of the devices.
+    @details Clears the RAM and UART, empties the agent queues, re-seeds
+        the agents' random stalls and zeros the simulation time. Every
+        per-job setting (pass / fail address, limits, save, cosim, wfi
+        skip, flight recorder, sandbox, ROI, memory stalls and interrupt
+        stimulus) goes back to its default, so the caller sets them after
+        reset(). The model is put back into reset by the next call to
+        run_simulation().
+        State the core does not reset (the GPRs) keeps its old value, as
+        it would on a real reset.
+    */
+    void reset();
+
+    /*!
+    @brief reset() the testbench, then load a new SREC image into memory.
+    @returns false if the image could not be read.
+    */
+    bool reset_and_load(std::string image);
+
+    //! Seed for the random stalls and RNG samples. Applied by reset().
+    unsigned int    random_seed     = 1;
+
+    /*!
+    @brief Write the complete simulation state to a checkpoint file.
+    @details Covers the model, the memory devices, the agents, the PRNG
+        and the simulation time. Only touched RAM pages are written.
+    @returns false if the file could not be opened.
+    */
+    bool save_checkpoint(std::string path);
+
+    /*!
+    @brief Load a checkpoint written by save_checkpoint.
+    @details The next run_simulation() carries on from the saved cycle
+        rather than starting from reset. The testbench must be built from
+        the same RTL and parameters as the one which saved the checkpoint.
+    @returns false if the file could not be opened or is not a checkpoint.
+    */
+    bool restore_checkpoint(std::string path);
+
+    //! If not empty, save a checkpoint here once save_at_cycle is reached.
+    std::string     save_path       = "";
+
+    //! Clock cycle at which to write save_path.
+    uint64_t        save_at_cycle   = 0;
+
+    /*!
+    @brief Run the loaded program on the functional ISS, then arrange for
+        the RTL to carry on from the state the ISS reached.
+    @details The ISS runs from the reset address until it reaches ff_pc
+        (if to_pc is set), the pass or fail address, max_instrs
+        instructions (0 = no limit) or an instruction it leaves to the RTL.
+        The RTL is then started on a handoff program which loads the ISS
+        state into it (see handoff()). Call after loading the image and
+        setting the pass / fail addresses, and before run_simulation().
+    @returns false if the handoff program cannot be used.
+    */
+    bool fast_forward(bool to_pc, uint32_t ff_pc, uint64_t max_instrs);
+
+    /*!
+    @brief Start the next run_simulation() from the state of model, which
+        must share this testbench's bus.
+    @details Puts a program which loads the model's CSRs and GPRs and then
+        jumps to its pc into handoff_ram, maps handoff_ram just above the
+        default memory (it must not already be mapped), and writes a jump to it over the reset vector.
+        Once the RTL has run it, the reset vector is put back and
+        handoff_ram is unmapped again.
+    @returns false if the model's pc, or the pass or fail address, is in
+        the bytes taken by the jump.
+    */
+    bool handoff(iss & model);
+
+    //! Instructions retired by the RTL since reset, or since the handoff.
+    uint64_t        rtl_instrs      = 0;
+
+    /*!
+    @brief If not zero, stop the simulation once rtl_instrs reaches this.
+        resume_simulation() will carry on from there.
+    */
+    uint64_t        max_rtl_instrs  = 0;
+
+    /*!
+    @brief If set, check every instruction the RTL retires against the
+        ISS, in lockstep (see cosim). Checking starts from reset, or once
+        the RTL has run a handoff program. A mismatch fails the test.
+    */
+    bool            cosim_enable    = false;
+
+    //! Set if the co-simulation found a mismatch.
+    bool            cosim_failed    = false;
+
+    //! Carry on a simulation which stopped at max_rtl_instrs.
+    void resume_simulation() {
+        this -> restored     = true;
+        this -> sim_finished = false;
+        this -> run();
+    }
+
     //! Run the simulation from beginning to end.
     void run_simulation() {
         this -> pre_run();   
@@ -62,6 +190,55 @@ public:
 
     bool            sim_passed      = false;
 
+    //! Set if the program ended the simulation through exit_0.
+    bool            sim_exited      = false;
+
+    //! The code the program exited with, if sim_exited.
+    uint32_t        exit_code       = 0;
+
+    /*!
+    @brief Stop, as a hang, once the RTL has retired an instruction at the
+        same address this many times in a row (e.g. a "j ." loop).
+        0 disables the check.
+    */
+    uint32_t        hang_limit      = 1000;
+
+    //! Set if the simulation was stopped by the hang_limit check.
+    bool            sim_hung        = false;
+
+    /*!
+    @brief If set, treat a retired WFI as the core going to sleep: when
+        nothing can wake it before an enabled machine timer interrupt,
+        advance mtime, the cycle counter and the simulation time straight
+        to it rather than simulating every idle cycle. The interrupt agent's
+        schedule is never skipped over. See idle_skip().
+    */
+    bool            wfi_skip        = false;
+
+    //! Simulation cycles skipped by wfi_skip since reset.
+    uint64_t        wfi_skipped     = 0;
+
+    /*!
+    @brief If not zero, run a flight recorder: save a checkpoint every
+        flight_period cycles, to flight_path.0 and flight_path.1 in turn,
+        so a run which fails can be replayed with waves from at least
+        flight_period cycles before the end.
+    */
+    uint64_t        flight_period   = 0;
+
+    //! Prefix of the flight recorder checkpoint files.
+    std::string     flight_path     = "";
+
+    /*!
+    @brief The oldest flight recorder checkpoint kept, which is at least
+        flight_period cycles old once two have been saved. Empty if none
+        has been.
+    */
+    std::string     flight_checkpoint();
+
+    //! Delete the flight recorder checkpoint files.
+    void            flight_clear();
+
 protected:
     
     //! Construct all of the objects we need inside the testbench.
@@ -81,6 +258,43 @@ protected:
     
     //! Whether or not to dump waveforms.
     bool        waves_dump;
+
+    //! Levels of hierarchy to dump waves for.
+    int         waves_depth;
+
+    //! If set, the only scopes to dump waves for.
+    std::string waves_scope;
+
+    //! Set by restore_checkpoint: skip the reset sequence in the next run.
+    //  Also used by resume_simulation().
+    bool        restored    = false;
+
+    //! Set once the save_path checkpoint has been written.
+    bool        saved       = false;
+
+    //! Set by fast_forward until the RTL has run the handoff program.
+    bool        handoff_pending = false;
+
+    //! Address of the final jump of the handoff program.
+    uint32_t    handoff_jump_pc = 0;
+
+    //! Memory contents overwritten by the jump to the handoff program.
+    std::vector<uint8_t> handoff_saved;
+
+    //! Copy of the state given to handoff(), for the co-simulation.
+    iss       * handoff_state = NULL;
+
+    //! The running co-simulation checker, if any.
+    cosim     * checker       = NULL;
+
+    //! Start checking the RTL from the architectural state of start.
+    void cosim_start(iss const & start);
+
+    //! Wait for the checker to catch up, report on it, and free it.
+    void cosim_stop();
+
+    //! Size of handoff_ram, placed a page above the default memory.
+    size_t      handoff_ram_size = 0x1000;
     
     //! Default base address of the default memory.
     size_t      default_ram_base_addr = 0x80000000;
@@ -91,6 +305,42 @@ protected:
     //! Default size of the default memory.
     size_t      default_ram_size = 0x20000;
 
+    //! Default base address of the exit device.
+    size_t      exit_base_addr = 0x40700000;
+
+    //! Address of the last instruction retired, for hang detection.
+    uint32_t    hang_pc     = 1;
+
+    //! Times in a row an instruction at hang_pc has been retired.
+    uint32_t    hang_count  = 0;
+
+    //! Which flight recorder checkpoints have been saved.
+    bool        flight_saved[2] = {false, false};
+
+    //! The flight recorder checkpoint to write next.
+    unsigned    flight_slot     = 0;
+
+    //! Cycle at which to write it.
+    uint64_t    flight_next     = 0;
+
+    //! Write the next flight recorder checkpoint.
+    void        flight_save();
+
+    /*!
+    @brief The earliest clock cycle at which the testbench itself will do
+        something which must not be skipped over: the timeout, a pending
+        or flight recorder checkpoint, or the interrupt agent raising a
+        line.
+    */
+    uint64_t    next_event_cycle();
+
+    /*!
+    @brief Called when the core retires a WFI. If the machine timer
+        interrupt is enabled, and due later than next_event_cycle()
+        allows, skip over the cycles until shortly before it.
+    */
+    void        idle_skip();
+
 };
 
 #endif
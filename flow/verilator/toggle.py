@@ -0,0 +1,185 @@
+#!/usr/bin/python3
+
+"""
+Read the toggle counts +TOGGLE writes (from a model built with
+VL_TOGGLE=1). Print the toggles of each part of the core, per file, as a
+relative estimate of dynamic energy: every bit switching counts the same.
+Optionally write one file's counts as SAIF, for power analysis tools.
+
+The cycles are whole g_clk periods (the gclk_cycles item), half the
+sim_time / 10 counts the harness prints. With +ROI, the counts run from
+the first ROI begin to the last ROI end, including any gaps between ROIs.
+"""
+
+import sys
+import json
+import argparse
+
+# Parts of the core, by instance name anywhere in a signal's hierarchy.
+# The first which matches wins, so those inside others come first.
+GROUPS = [
+    ("gprs"     , ["i_gprs"]),
+    ("xc_malu"  , ["i_xc_malu"]),
+    ("aes"      , ["i_xc_aessub", "i_xc_aesmix"]),
+    ("sha"      , ["i_xc_sha256", "i_xc_sha3"]),
+    ("mul"      , ["i_frv_mul_fast"]),
+    ("bitwise"  , ["i_frv_bitwise"]),
+    ("lsu"      , ["i_lsu"]),
+    ("csrs"     , ["i_csrs", "i_counters"]),
+    ("leak"     , ["i_frv_leak"]),
+    ("fetch"    , ["i_pipeline_s0_fetch", "i_core_fetch_buffer"]),
+    ("decode"   , ["i_pipeline_s1_decode"]),
+    ("execute"  , ["i_pipeline_s2_execute"]),
+    ("memory"   , ["i_pipeline_s3_memory"]),
+    ("writeback", ["i_pipeline_s4_writeback"]),
+]
+
+OTHER = "other"
+
+
+def read_toggles(path):
+    """
+    Return ({signal path: toggles}, g_clk cycles) from a coverage file.
+    Each signal path is a list of instance names, then the signal.
+    """
+    toggles = {}
+    cycles  = 0
+    with open(path, "r", encoding="latin-1") as fh:
+        for line in fh:
+            if(not line.startswith("C '")):
+                continue
+            end    = line.rindex("'")
+            count  = int(line[end+1:])
+            keys   = {}
+            for item in line[3:end].split("\x01"):
+                if("\x02" in item):
+                    k, v = item.split("\x02", 1)
+                    keys[k] = v
+            page   = keys.get("page", "")
+            if(page == "v_harness" and keys.get("o") == "gclk_cycles"):
+                cycles = count
+            elif(page.startswith("v_toggle")):
+                hier = [h for h in keys.get("h", "").split(".") if h]
+                if(hier and hier[0] == "TOP"):
+                    hier = hier[1:]
+                name = tuple(hier + keys.get("o", "").split("."))
+                toggles[name] = toggles.get(name, 0) + count
+    return toggles, cycles
+
+
+def group_of(name):
+    for group, instances in GROUPS:
+        if(any(i in name[:-1] for i in instances)):
+            return group
+    return OTHER
+
+
+def write_saif(path, toggles, cycles, period):
+    """
+    Write toggles as SAIF, with only the toggle count (TC) of each net.
+    """
+    tree = {}
+    for name, count in toggles.items():
+        node = tree
+        for inst in name[:-1]:
+            node = node.setdefault(inst, {})
+        node.setdefault(None, []).append((name[-1], count))
+
+    def escape(n):
+        return n.replace("[", "\\[").replace("]", "\\]")
+
+    def instance(fh, name, node, depth):
+        pad = "  " * depth
+        fh.write("%s(INSTANCE %s\n" % (pad, name))
+        if(None in node):
+            fh.write("%s  (NET\n" % pad)
+            for net, count in sorted(node[None]):
+                fh.write("%s    (%s (TC %d))\n" % (pad, escape(net), count))
+            fh.write("%s  )\n" % pad)
+        for child in sorted(k for k in node if k is not None):
+            instance(fh, child, node[child], depth + 1)
+        fh.write("%s)\n" % pad)
+
+    with open(path, "w") as fh:
+        fh.write("(SAIFILE\n")
+        fh.write("(SAIFVERSION \"2.0\")\n")
+        fh.write("(DIRECTION \"backward\")\n")
+        fh.write("(DESIGN \"frv_core\")\n")
+        fh.write("(PROGRAM_NAME \"toggle.py\")\n")
+        fh.write("(DIVIDER / )\n")
+        fh.write("(TIMESCALE 1 ns)\n")
+        fh.write("(DURATION %d)\n" % (cycles * period))
+        for top in sorted(k for k in tree if k is not None):
+            instance(fh, top, tree[top], 0)
+        fh.write(")\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("counts", nargs="+",
+        help="Toggle count files, e.g. one per benchmark.")
+    parser.add_argument("--saif",
+        help="Write the first file's counts here as SAIF.")
+    parser.add_argument("--period", type=float, default=10,
+        help="g_clk period in ns, for the SAIF duration.")
+    parser.add_argument("--json",
+        help="Also write the toggles of each part, per file, here.")
+    args = parser.parse_args()
+
+    names   = []
+    results = []
+
+    for path in args.counts:
+        toggles, cycles = read_toggles(path)
+        if(args.saif and not results):
+            write_saif(args.saif, toggles, cycles, args.period)
+        parts = {g: 0 for g, i in GROUPS + [(OTHER, [])]}
+        for name, count in toggles.items():
+            parts[group_of(name)] += count
+        results.append({"cycles": cycles,
+                        "toggles": sum(parts.values()),
+                        "parts": parts})
+        # .../src/<benchmark>/benchmark.toggle.dat
+        p = path.split("/")
+        names.append(p[-2] if len(p) > 1 else path)
+
+    # Only parts some file toggles get a column.
+    used   = [g for g, i in GROUPS + [(OTHER, [])]
+              if any(r["parts"][g] for r in results)]
+
+    def pct(n, d):
+        return "%.2f" % (100.0 * n / d) if d else "-"
+
+    def per_cycle(n, d):
+        return "%.1f" % (n / d) if d else "-"
+
+    header = ["name", "g_clk cycles", "toggles", "per cycle"] + \
+             ["%s %%" % g for g in used]
+    rows   = []
+
+    for name, r in sorted(zip(names, results), key=lambda r: r[0]):
+        rows.append([name, str(r["cycles"]), str(r["toggles"]),
+                     per_cycle(r["toggles"], r["cycles"])] +
+                    [pct(r["parts"][g], r["toggles"]) for g in used])
+
+    widths = [max(len(r[i]) for r in [header] + rows)
+              for i in range(len(header))]
+
+    def line(cols):
+        return "| " + " | ".join(
+            c.rjust(w) for c, w in zip(cols, widths)) + " |"
+
+    print(line(header))
+    print("|" + "|".join("-" * (w + 2) for w in widths) + "|")
+    for row in rows:
+        print(line(row))
+
+    if(args.json):
+        with open(args.json, "w") as fh:
+            json.dump(dict(zip(names, results)), fh, indent=2)
+
+    return 0
+
+
+if(__name__ == "__main__"):
+    sys.exit(main())
@@ -1,6 +1,13 @@
 
 yosys -import
 
+# Where to put reports. Overridden by the build matrix flow.
+if {[info exists ::env(SYNTH_DIR)]} {
+    set synth_dir $::env(SYNTH_DIR)
+} else {
+    set synth_dir $::env(FRV_WORK)/synth
+}
+
 # Read in the design
 read_verilog -I$::env(FRV_HOME)/rtl/core $::env(FRV_HOME)/rtl/core/*.v
 read_verilog $::env(XCRYPTO_RTL)/p_addsub/p_addsub.v
@@ -19,24 +26,33 @@ read_verilog $::env(XCRYPTO_RTL)/xc_aesmix/xc_aesmix.v
 read_verilog $::env(XCRYPTO_RTL)/b_bop/b_bop.v
 read_verilog $::env(XCRYPTO_RTL)/b_lut/b_lut.v
 
+# Optional top level parameter overrides. "NAME=VALUE NAME=VALUE ..."
+if {[info exists ::env(SYNTH_PARAMS)]} {
+    foreach p [split [string trim $::env(SYNTH_PARAMS)]] {
+        if {$p eq ""} continue
+        set kv [split $p "="]
+        chparam -set [lindex $kv 0] [lindex $kv 1] frv_core
+    }
+}
+
 # Synthesise processes ready for SCC check.
 procs
 
 # Check that there are no logic loops in the design early on.
-tee -o $::env(FRV_WORK)/synth/logic-loops.rpt check -assert
+tee -o $synth_dir/logic-loops.rpt check -assert
 
 # Generic yosys synthesis command
 synth -top frv_core
 
 # Print some statistics out
-tee -o $::env(FRV_WORK)/synth/synth-statistics.rpt stat -width
+tee -o $synth_dir/synth-statistics.rpt stat -width
 
 # Write out the synthesised verilog
-write_verilog $::env(FRV_WORK)/synth/synth-cells.v
+write_verilog $synth_dir/synth-cells.v
 
 dfflibmap -liberty $::env(YOSYS_ROOT)/techlibs/common/cells.lib
 abc -liberty $::env(YOSYS_ROOT)/examples/cmos/cmos_cells.lib
-tee -o $::env(FRV_WORK)/synth/synth-gates.rpt stat
+tee -o $synth_dir/synth-gates.rpt stat -liberty $::env(YOSYS_ROOT)/examples/cmos/cmos_cells.lib
 
-write_verilog $::env(FRV_WORK)/synth-gates.v
+write_verilog $synth_dir/synth-gates.v
 
@@ -127,6 +127,22 @@ parameter XC_CLASS_LEAK_BUBBLE= 1'b1 && XC_CLASS_LEAK;
 parameter AES_SUB_FAST        = 1'b0;
 parameter AES_MIX_FAST        = 1'b0;
 
+// Issue loads while an older data access is still awaiting its response?
+parameter LSU_PIPELINE        = 1'b0;
+
+// Retire stores without waiting for their data memory response?
+// Bus errors on such stores are not reported.
+parameter LSU_STORE_BUFFER    = 1'b0;
+
+// Forward load data to decode in the cycle it arrives in writeback?
+// Clear to shorten the critical path for FPGA builds.
+parameter LOAD_BYPASS         = 1'b1;
+
+// Fast multiplier for mul/mulh/mulhu/mulhsu and xc.mmul.
+// 0 - Iterative xc_malu only (smallest). 1 - Single cycle 32x32.
+// 2 - Two cycle 32x32, with a registered result.
+parameter MUL_FAST            = 0;
+
 //
 // Partial Bitmanip Extension Support
 parameter BITMANIP_BASELINE   = 1'b1;
@@ -205,6 +221,10 @@ frv_pipeline #(
 .XC_CLASS_LEAK_BUBBLE(XC_CLASS_LEAK_BUBBLE),
 .AES_SUB_FAST       (AES_SUB_FAST       ),
 .AES_MIX_FAST       (AES_MIX_FAST       ),
+.LSU_PIPELINE       (LSU_PIPELINE       ),
+.LSU_STORE_BUFFER   (LSU_STORE_BUFFER   ),
+.LOAD_BYPASS        (LOAD_BYPASS        ),
+.MUL_FAST           (MUL_FAST           ),
 .BITMANIP_BASELINE  (BITMANIP_BASELINE  ), 
 .CSR_MIMPID         (CSR_MIMPID         )
 ) i_pipeline(
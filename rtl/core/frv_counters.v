@@ -61,7 +61,44 @@ wire    addr_mtimecmp_hi = mmio_en &&
 reg  [63:0] mapped_mtime;
 reg  [63:0] mapped_mtimecmp;
 
-wire [63:0] n_mapped_mtime = mapped_mtime + 1;
+// ---------------------- Testbench idle skipping -----------------------
+
+`ifdef VERILATOR
+
+//
+// Lets the verilator testbench skip over cycles in which the core is
+// idle in a WFI. After frv_counters_skip(n), each clock edge advances
+// mtime and the cycle counter by n+1 rather than 1, until the testbench
+// calls frv_counters_skip(0) again.
+//
+
+reg  [63:0] tb_skip = 64'b0;
+
+export "DPI-C" function frv_counters_skip;
+export "DPI-C" function frv_counters_mtime;
+export "DPI-C" function frv_counters_mtimecmp;
+
+function void frv_counters_skip(input longint cycles);
+    tb_skip = cycles;
+endfunction
+
+function longint frv_counters_mtime();
+    frv_counters_mtime = mapped_mtime;
+endfunction
+
+function longint frv_counters_mtimecmp();
+    frv_counters_mtimecmp = mapped_mtimecmp;
+endfunction
+
+wire [63:0] skip_cycles = tb_skip;
+
+`else
+
+wire [63:0] skip_cycles = 64'b0;
+
+`endif
+
+wire [63:0] n_mapped_mtime = mapped_mtime + 1 + skip_cycles;
 
 wire n_timer_interrupt = mapped_mtime >= mapped_mtimecmp;
 
@@ -165,7 +202,7 @@ end
 // Cycle counter register
 //
 
-wire [63:0] n_ctr_cycle = ctr_cycle + 1;
+wire [63:0] n_ctr_cycle = ctr_cycle + 1 + skip_cycles;
 
 always @(posedge g_clk) begin
     if(!g_resetn) begin
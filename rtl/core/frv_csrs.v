@@ -715,5 +715,32 @@ assign csr_rdata =
     {32{read_uxcrypto }} & reg_uxcrypto         |
     {32{read_lkgcfg   }} & {19'b0,reg_lkgcfg}   ;
 
+
+`ifdef VERILATOR
+
+//
+// Lets the verilator testbench see the interrupt enables, e.g. to know
+// whether a WFI can wake for the timer interrupt (flow/verilator
+// testbench::idle_skip), and the cause of each interrupt taken.
+//
+
+export "DPI-C" function frv_csrs_mie;
+export "DPI-C" function frv_csrs_mstatus;
+export "DPI-C" function frv_csrs_mcause;
+
+function int frv_csrs_mie();
+    frv_csrs_mie = reg_mie;
+endfunction
+
+function int frv_csrs_mstatus();
+    frv_csrs_mstatus = reg_mstatus;
+endfunction
+
+function int frv_csrs_mcause();
+    frv_csrs_mcause = reg_mcause;
+endfunction
+
+`endif
+
 endmodule
 
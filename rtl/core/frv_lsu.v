@@ -15,6 +15,8 @@ output wire        lsu_ready   , // Outputs are valid / instruction complete.
 output wire        lsu_mmio    , // Is this an MMIO access?
 
 input  wire        pipe_prog   , // Pipeline is progressing this cycle.
+input  wire        flush       , // Flush the current access.
+output wire        lsu_orphan  , // Flushed a granted access. Drop its response.
 
 input  wire [XL:0] lsu_addr    , // Memory address to access.
 input  wire [XL:0] lsu_wdata   , // Data to write to memory.
@@ -26,6 +28,7 @@ input  wire        lsu_word    , // Word operation width.
 input  wire        lsu_signed  , // Sign extend loaded data?
 
 input  wire        hold_lsu_req, // Don't make LSU requests yet.
+input  wire        hold_lsu_ld , // Don't make LSU load requests yet.
 
 output wire        mmio_en     , // MMIO enable
 output wire        mmio_wen    , // MMIO write enable
@@ -57,7 +60,7 @@ assign      lsu_mmio   = lsu_valid &&
 
 reg         mmio_done;
 
-wire        n_mmio_done= (mmio_done || mmio_en) && !pipe_prog;
+wire        n_mmio_done= (mmio_done || mmio_en) && !pipe_prog && !flush;
 
 always @(posedge g_clk) begin
     if(!g_resetn) begin
@@ -68,6 +71,15 @@ always @(posedge g_clk) begin
 end
 
 assign      mmio_en    = lsu_mmio && !mmio_done && !hold_lsu_req;
+
+//
+// Request holding
+// -------------------------------------------------------------------------
+
+// Plain memory loads have no side effects, so may use the relaxed hold
+// signal from writeback, which lets them issue behind an outstanding access.
+wire        lsu_hold   = lsu_load && !lsu_mmio ? hold_lsu_ld   :
+                                                 hold_lsu_req  ;
 assign      mmio_addr  = lsu_addr   ;
 assign      mmio_wen   = lsu_store  ;
 assign      mmio_wdata = lsu_wdata  ;
@@ -84,7 +96,7 @@ reg  lsu_finished;
 
 wire n_lsu_finished = 
     (lsu_finished || ((lsu_valid && dmem_txn_done) || lsu_a_error)) &&
-    !pipe_prog;
+    !pipe_prog && !flush;
 
 assign lsu_ready    = dmem_txn_done || lsu_finished;
 
@@ -97,6 +109,11 @@ always @(posedge g_clk) begin
 end
 
 
+// A granted memory request is being flushed before reaching writeback.
+// Writeback must still consume (and discard) the response.
+assign lsu_orphan  = flush && lsu_valid && lsu_finished && !lsu_mmio &&
+                     !lsu_a_error;
+
 // Address error?
 assign lsu_a_error = lsu_half &&  lsu_addr[  0] ||
                      lsu_word && |lsu_addr[1:0]  ;
@@ -106,7 +123,7 @@ assign lsu_a_error = lsu_half &&  lsu_addr[  0] ||
 // -------------------------------------------------------------------------
 
 assign dmem_req     = lsu_valid && !lsu_finished && !lsu_a_error &&
-                      !hold_lsu_req && !lsu_mmio;
+                      !lsu_hold && !lsu_mmio;
 assign dmem_wen     = lsu_store ;
 assign dmem_addr    = lsu_addr  & 32'hFFFF_FFFC;
 
@@ -0,0 +1,88 @@
+
+//
+// module: frv_mul_fast
+//
+//  Single (or two) cycle 32x32 multiplier. Used in place of the iterative
+//  xc_malu for the instructions which dominate bignum / crypto code:
+//  - mul, mulh, mulhu, mulhsu
+//  - xc.mmul
+//
+module frv_mul_fast (
+
+input  wire         g_clk           , // Global clock
+input  wire         g_resetn        , // Global reset.
+
+input  wire [31:0]  rs1             , //
+input  wire [31:0]  rs2             , //
+input  wire [31:0]  rs3             , //
+
+input  wire         flush           , // Flush state / pipeline progress
+input  wire [31:0]  flush_data      , // Data to flush into the result reg.
+input  wire         valid           , // Inputs valid.
+
+input  wire         uop_mul         , // mul, mulh
+input  wire         uop_mulu        , // mulhu
+input  wire         uop_mulsu       , // mulhsu
+input  wire         uop_mmul        , // xc.mmul
+
+output wire [63:0]  result          , // 64-bit result
+output wire         ready             // Outputs ready.
+
+);
+
+//
+// Number of cycles taken to produce a result.
+// - 1: Purely combinatorial. Result ready in the same cycle.
+// - 2: Result registered. Ready in the cycle after valid is raised.
+parameter MUL_CYCLES = 1;
+
+//
+// Multiplier
+// ------------------------------------------------------------
+
+wire        lhs_signed  = uop_mul || uop_mulsu;
+wire        rhs_signed  = uop_mul;
+
+wire signed [32:0] lhs  = {lhs_signed && rs1[31], rs1};
+wire signed [32:0] rhs  = {rhs_signed && rs2[31], rs2};
+
+wire signed [65:0] product = lhs * rhs;
+
+// xc.mmul accumulates rs3 into the 64-bit product.
+wire [63:0] acc         = {32'b0, {32{uop_mmul}} & rs3};
+
+wire [63:0] n_result    = product[63:0] + acc;
+
+//
+// Result
+// ------------------------------------------------------------
+
+generate if(MUL_CYCLES == 1) begin
+
+    assign result = n_result;
+    assign ready  = valid;
+
+end else begin
+
+    reg  [63:0] result_r;
+    reg         done;
+
+    assign result = result_r;
+    assign ready  = done;
+
+    always @(posedge g_clk) begin
+        if(!g_resetn) begin
+            done     <= 1'b0;
+            result_r <= 64'b0;
+        end else if(flush) begin
+            done     <= 1'b0;
+            result_r <= {flush_data, flush_data};
+        end else if(valid && !done) begin
+            done     <= 1'b1;
+            result_r <= n_result;
+        end
+    end
+
+end endgenerate
+
+endmodule
@@ -151,6 +151,18 @@ parameter XC_CLASS_LEAK_BUBBLE= 1'b1 && XC_CLASS_LEAK;
 parameter AES_SUB_FAST = 1'b1;
 parameter AES_MIX_FAST = 1'b1;
 
+// Issue loads while an older data access is still awaiting its response?
+parameter LSU_PIPELINE      = 1'b0;
+
+// Retire stores without waiting for their data memory response?
+parameter LSU_STORE_BUFFER  = 1'b0;
+
+// Forward load data to decode in the cycle it arrives in writeback?
+parameter LOAD_BYPASS       = 1'b1;
+
+// Fast multiplier. 0 - iterative xc_malu, 1 - single cycle, 2 - two cycle.
+parameter MUL_FAST          = 0;
+
 //
 // Partial Bitmanip Extension Support
 parameter BITMANIP_BASELINE   = 1'b1;
@@ -282,6 +294,7 @@ wire        s4_valid      ; // Is this input valid?
 wire [ 4:0] fwd_s4_rd     ; // Writeback stage destination reg.
 wire [XL:0] fwd_s4_wdata  ; // Write data for writeback stage.
 wire        fwd_s4_load   ; // Writeback stage has load in it.
+wire        fwd_s4_lrdy   ; // Writeback stage load data arriving now.
 wire        fwd_s4_csr    ; // Writeback stage has CSR op in it.
 
 wire        gpr_wen       ; // GPR write enable.
@@ -291,6 +304,8 @@ wire [XL:0] gpr_wdata     ; // GPR write data [31:0].
 wire [XL:0] gpr_wdata_hi  ; // GPR write data [63:32].
 
 wire        hold_lsu_req  ; // Don't make LSU requests yet.
+wire        hold_lsu_ld   ; // Don't make LSU load requests yet.
+wire        lsu_orphan    ; // Memory stage flushed a granted request.
 
 `ifdef RVFI
 wire [XL:0] rvfi_s2_rs1_rdata; // Source register data 1
@@ -364,13 +379,21 @@ wire fwd_s2_rs3_hi = s1_rs3_addr[0] && fwd_s2_wide;
 wire fwd_s3_rs3_hi = s1_rs3_addr[0] && fwd_s3_wide;
 wire fwd_s4_rs3_hi = s1_rs3_addr[0] && gpr_wide   ;
 
+//
+// Load data arriving in writeback this cycle is already on gpr_wdata, so
+// it can be forwarded to decode rather than bubbling for a cycle.
+// This puts the data memory read path in front of the decode operand
+// registers, so can be disabled for timing critical builds.
+wire   s4_ld_bypass = LOAD_BYPASS && fwd_s4_lrdy;
+
 //
 // Bubbling occurs when:
 // - There is a data hazard due to a CSR read or a data load.
 // - There is a leakage fence in decode and subsequent stages still have
 //   an instruction in them.
 wire   s1_bubble_no_instr = !s1_valid && !s2_busy ;
-wire   s1_bubble_from_s4  = fwd_s4_csr||(fwd_s4_load && (hzd_rs1_s4 || hzd_rs2_s4 || hzd_rs3_s4));
+wire   s1_bubble_from_s4  = fwd_s4_csr||(fwd_s4_load && !s4_ld_bypass &&
+                                         (hzd_rs1_s4 || hzd_rs2_s4 || hzd_rs3_s4));
 wire   s1_bubble_from_s3  = fwd_s3_csr||(fwd_s3_load && (hzd_rs1_s3 || hzd_rs2_s3 || hzd_rs3_s3));
 wire   s1_bubble_from_s2  = fwd_s2_csr||(fwd_s2_load && (hzd_rs1_s2 || hzd_rs2_s2 || hzd_rs3_s2));
 wire   s1_bubble   =
@@ -514,6 +537,7 @@ frv_pipeline_execute #(
 .XC_CLASS_SHA3      (XC_CLASS_SHA3      ),
 .AES_SUB_FAST       (AES_SUB_FAST       ),
 .AES_MIX_FAST       (AES_MIX_FAST       ),
+.MUL_FAST           (MUL_FAST           ),
 .BITMANIP_BASELINE  (BITMANIP_BASELINE  ) 
 ) i_pipeline_s2_execute (
 .g_clk            (g_clk            ), // global clock
@@ -635,6 +659,8 @@ frv_pipeline_memory #(
 .rvfi_s4_mem_wdata(rvfi_s4_mem_wdata), // Memory write data.
 `endif // RVFI
 .hold_lsu_req     (hold_lsu_req     ), // Disallow LSU requests when set.
+.hold_lsu_ld      (hold_lsu_ld      ), // Disallow LSU loads when set.
+.lsu_orphan       (lsu_orphan       ), // Flushed a granted LSU request.
 .mmio_en          (mmio_en          ), // MMIO enable
 .mmio_wen         (mmio_wen         ), // MMIO write enable
 .mmio_addr        (mmio_addr        ), // MMIO address
@@ -667,7 +693,9 @@ frv_pipeline_memory #(
 //  - GPR writeback.
 //
 frv_pipeline_writeback #(
-.FRV_PC_RESET_VALUE(FRV_PC_RESET_VALUE)
+.FRV_PC_RESET_VALUE(FRV_PC_RESET_VALUE),
+.LSU_PIPELINE      (LSU_PIPELINE      ),
+.LSU_STORE_BUFFER  (LSU_STORE_BUFFER  )
 ) i_pipeline_s4_writeback(
 .g_clk            (g_clk            ), // global clock
 .g_resetn         (g_resetn         ), // synchronous reset
@@ -723,6 +751,7 @@ frv_pipeline_writeback #(
 .fwd_s4_rd        (fwd_s4_rd        ), // Writeback stage destination reg.
 .fwd_s4_wdata     (fwd_s4_wdata     ), // Write data for writeback stage.
 .fwd_s4_load      (fwd_s4_load      ), // Writeback stage has load in it.
+.fwd_s4_lrdy      (fwd_s4_lrdy      ), // Load data being written back now.
 .fwd_s4_csr       (fwd_s4_csr       ), // Writeback stage has CSR op in it.
 .gpr_wen          (gpr_wen          ), // GPR write enable.
 .gpr_wide         (gpr_wide         ), // GPR wide writeback.
@@ -756,6 +785,8 @@ frv_pipeline_writeback #(
 .cf_target        (cf_target        ), // Control flow change target
 .cf_ack           (cf_ack           ), // Control flow change acknowledge.
 .hold_lsu_req     (hold_lsu_req     ), // Don't make LSU requests yet.
+.hold_lsu_ld      (hold_lsu_ld      ), // Don't make LSU load requests yet.
+.lsu_orphan       (lsu_orphan       ), // Memory stage flushed a granted req.
 .mmio_rdata       (mmio_rdata       ), // MMIO read data
 .mmio_error       (mmio_error       ), // MMIO error
 .dmem_recv        (dmem_recv        ), // Instruction memory recieve response.
@@ -845,5 +876,36 @@ frv_gprs #(
 .rd_wdata_hi(gpr_wdata_hi   )  // Destination register write data [63:32]
 );
 
+`ifdef VERILATOR
+
+//
+// Lets the verilator testbench follow instructions through the pipeline
+// (flow/verilator/pipe_trace.hpp). Bit 0 of frv_pipeline_progress is set
+// while decode holds an instruction, bits 1-4 when decode, execute,
+// memory and writeback each pass theirs on at the next clock edge, and
+// bit 5 when the pipeline is flushed.
+//
+
+export "DPI-C" function frv_pipeline_progress;
+export "DPI-C" function frv_pipeline_s1_data;
+
+function int frv_pipeline_progress();
+    frv_pipeline_progress = {
+        26'b0               ,
+        s0_flush            ,
+        s4_valid && !s4_busy,
+        s3_valid && !s3_busy,
+        s2_valid && !s2_busy,
+        s1_valid && !s1_busy,
+        s1_valid
+    };
+endfunction
+
+function int frv_pipeline_s1_data();
+    frv_pipeline_s1_data = s1_data;
+endfunction
+
+`endif
+
 endmodule
 
@@ -99,6 +99,10 @@ parameter XC_CLASS_SHA3       = 1'b1;
 parameter AES_SUB_FAST = 1'b1;
 parameter AES_MIX_FAST = 1'b1;
 
+// Fast multiplier for mul/mulh/mulhu/mulhsu/xc.mmul.
+// 0 - Use the iterative xc_malu. 1 - Single cycle. 2 - Two cycle.
+parameter MUL_FAST     = 0;
+
 //
 // Partial Bitmanip Extension Support
 parameter BITMANIP_BASELINE   = 1'b1;
@@ -200,8 +204,21 @@ wire        imul_pw_8       = XC_CLASS_PACKED && s2_pw == PW_8 ;
 wire        imul_pw_16      = XC_CLASS_PACKED && s2_pw == PW_16;
 wire        imul_pw_32      = s2_pw == PW_32;
 
-wire        imul_ready      ;
-wire [63:0] imul_result_wide;
+// Send multiplies to the fast multiplier, if present.
+wire        imul_fast       = MUL_FAST != 0 && (
+    imul_mul || imul_mulhu || imul_mulhsu || imul_mmul
+);
+
+wire        malu_valid      = imul_valid && !imul_fast;
+wire        malu_ready      ;
+wire [63:0] malu_result     ;
+
+wire        fmul_valid      = imul_valid &&  imul_fast;
+wire        fmul_ready      ;
+wire [63:0] fmul_result     ;
+
+wire        imul_ready      = imul_fast ? fmul_ready  : malu_ready  ;
+wire [63:0] imul_result_wide= imul_fast ? fmul_result : malu_result ;
 
 // Source the high 32-bits of the multiplier output.
 wire        imul_result_hi  = imul_mulhu || imul_mulhsu ||
@@ -450,7 +467,7 @@ xc_malu i_xc_malu (
 .rs3        (imul_rs3        ), //
 .flush      (imul_flush      ), // Flush state / pipeline progress
 .flush_data (leak_prng       ), //
-.valid      (imul_valid      ), // Inputs valid.
+.valid      (malu_valid      ), // Inputs valid.
 .uop_div    (imul_div        ), //
 .uop_divu   (imul_divu       ), //
 .uop_rem    (imul_rem        ), //
@@ -470,10 +487,44 @@ xc_malu i_xc_malu (
 .pw_8       (imul_pw_8       ), //  8-bit width packed elements.
 .pw_4       (imul_pw_4       ), //  4-bit width packed elements.
 .pw_2       (imul_pw_2       ), //  2-bit width packed elements.
-.result     (imul_result_wide), // 64-bit result
-.ready      (imul_ready      )  // Outputs ready.
+.result     (malu_result     ), // 64-bit result
+.ready      (malu_ready      )  // Outputs ready.
+);
+
+//
+// instance: frv_mul_fast
+//
+//  Optional single/two cycle multiplier, used in place of xc_malu for
+//  mul, mulh, mulhu, mulhsu and xc.mmul.
+//
+generate if(MUL_FAST != 0) begin : g_mul_fast
+
+frv_mul_fast #(
+.MUL_CYCLES(MUL_FAST)
+) i_frv_mul_fast (
+.g_clk      (g_clk           ), // Global clock
+.g_resetn   (g_resetn        ), // Global reset.
+.rs1        (imul_rs1        ), //
+.rs2        (imul_rs2        ), //
+.rs3        (imul_rs3        ), //
+.flush      (imul_flush      ), // Flush state / pipeline progress
+.flush_data (leak_prng       ), // Data to flush into the result reg.
+.valid      (fmul_valid      ), // Inputs valid.
+.uop_mul    (imul_mul        ), // mul, mulh
+.uop_mulu   (imul_mulhu      ), // mulhu
+.uop_mulsu  (imul_mulhsu     ), // mulhsu
+.uop_mmul   (imul_mmul       ), // xc.mmul
+.result     (fmul_result     ), // 64-bit result
+.ready      (fmul_ready      )  // Outputs ready.
 );
 
+end else begin : g_no_mul_fast
+
+assign fmul_result = 64'b0;
+assign fmul_ready  = 1'b0;
+
+end endgenerate
+
 //
 // instance: frv_bitwise
 //
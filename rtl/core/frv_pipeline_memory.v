@@ -59,6 +59,8 @@ output reg  [XL:0] rvfi_s4_mem_wdata, // Memory write data.
 `endif
 
 input  wire        hold_lsu_req    , // Hold LSU requests for now.
+input  wire        hold_lsu_ld     , // Hold LSU load requests for now.
+output wire        lsu_orphan      , // Flushed a granted LSU request.
 
 output wire        mmio_en         , // MMIO enable
 output wire        mmio_wen        , // MMIO write enable
@@ -232,6 +234,8 @@ frv_lsu #(
 .lsu_ready   (lsu_ready   ), // Outputs are valid / instruction complete.
 .lsu_mmio    (lsu_mmio    ), // Is this an MMIO access?
 .pipe_prog   (pipe_progress),// Pipeline is progressing this cycle.
+.flush       (flush       ), // Flush the current access.
+.lsu_orphan  (lsu_orphan  ), // Flushed a granted access.
 .lsu_addr    (lsu_addr    ), // Memory address to access.
 .lsu_wdata   (lsu_wdata   ), // Data to write to memory.
 .lsu_load    (lsu_load    ), // Load instruction.
@@ -241,6 +245,7 @@ frv_lsu #(
 .lsu_word    (lsu_word    ), // Word operation width.
 .lsu_signed  (lsu_signed  ), // Sign extend loaded data?
 .hold_lsu_req(hold_lsu_req), // Don't make LSU requests yet.
+.hold_lsu_ld (hold_lsu_ld ), // Don't make LSU load requests yet.
 .mmio_en     (mmio_en     ), // MMIO enable
 .mmio_wen    (mmio_wen    ), // MMIO write enable
 .mmio_addr   (mmio_addr   ), // MMIO address
@@ -70,6 +70,7 @@ input  wire        s4_valid        , // Are the stage inputs valid?
 output wire [ 4:0] fwd_s4_rd       , // Writeback stage destination reg.
 output wire [XL:0] fwd_s4_wdata    , // Write data for writeback stage.
 output wire        fwd_s4_load     , // Writeback stage has load in it.
+output wire        fwd_s4_lrdy     , // Load data is being written back now.
 output wire        fwd_s4_csr      , // Writeback stage has CSR op in it.
 
 output wire        gpr_wen         , // GPR write enable.
@@ -112,6 +113,8 @@ output wire [XL:0] cf_target       , // Control flow change target
 input  wire        cf_ack          , // Control flow change acknowledge.
 
 output wire        hold_lsu_req    , // Don't make LSU requests yet.
+output wire        hold_lsu_ld     , // Don't make LSU load requests yet.
+input  wire        lsu_orphan      , // Memory stage flushed a granted request
 
 input  wire [31:0] mmio_rdata      , // MMIO read data
 input  wire        mmio_error      , // MMIO error
@@ -130,6 +133,12 @@ input  wire [XL:0] dmem_rdata        // Read data
 // Value taken by the PC on a reset.
 parameter FRV_PC_RESET_VALUE = 32'h8000_0000;
 
+// Issue loads while an older data access is still awaiting its response?
+parameter LSU_PIPELINE      = 1'b0;
+
+// Retire stores without waiting for their data memory response?
+parameter LSU_STORE_BUFFER  = 1'b0;
+
 wire  pipe_progress = s4_valid && !s4_busy;
 
 assign s4_busy = fu_cfu && cfu_busy ||
@@ -138,7 +147,13 @@ assign s4_busy = fu_cfu && cfu_busy ||
 
 // Don't make LSU memory requests until writeback stage is sure it won't
 // raise an exception.
-assign hold_lsu_req = cf_req || lsu_busy || trap_int;
+assign hold_lsu_req = cf_req || lsu_busy || trap_int || lsu_orphans_full;
+
+// Loads have no side effects, so with LSU_PIPELINE set they may be issued
+// while the writeback access is still waiting for its response. If that
+// access then traps, the load is flushed and its response dropped.
+assign hold_lsu_ld  = cf_req || trap_int || lsu_orphans_full ||
+                      lsu_busy && !LSU_PIPELINE;
 
 //
 // PC computation
@@ -322,17 +337,33 @@ wire [XL:0] cfu_gpr_wdata = n_s4_pc;
 // Are we expecting an MMIO access?
 wire        lsu_mmio        = fu_lsu    && s4_opr_a[4];
 
+//
+// Responses owed to accesses which have already left the pipeline: stores
+// retired early by LSU_STORE_BUFFER, or granted requests flushed from the
+// memory stage. These are older than the current writeback access, so
+// they are always the next responses to arrive, and are simply dropped.
+reg  [ 1:0] lsu_orphans     ;
+
+wire        lsu_orphans_pend= |lsu_orphans;
+wire        lsu_orphans_full= &lsu_orphans;
+
+wire        lsu_orphan_drop = lsu_orphans_pend && dmem_recv;
+
+//
+// A data memory response for the current writeback stage instruction.
+wire        lsu_rsp_now     = dmem_recv && dmem_ack && !lsu_orphans_pend;
+
 //
 // Are we recieving a data memory response which we expected?
 wire        lsu_txn_recv    = lsu_load               &&
-                              dmem_recv && dmem_ack  &&
+                              lsu_rsp_now            &&
                               lsu_rsp_expected       ;
 
 //
 // Track whether we've already seen the expected memory response for the
 // current writeback stage instruction.
 wire        n_lsu_rsp_seen  = 
-    !pipe_progress && (lsu_rsp_seen || lsu_mmio || (dmem_recv && dmem_ack));
+    !pipe_progress && (lsu_rsp_seen || lsu_mmio || lsu_rsp_now);
 
 reg         lsu_rsp_seen;
 
@@ -342,8 +373,31 @@ reg         lsu_rsp_seen;
 wire        lsu_rsp_expected= fu_lsu && !lsu_rsp_seen && !lsu_mmio;
 
 //
-// Only accept data memory responses if we expect them.
-assign      dmem_ack    = lsu_rsp_expected;
+// Only accept data memory responses if we expect them, or are draining
+// responses for accesses which have left the pipeline.
+assign      dmem_ack    = lsu_rsp_expected || lsu_orphans_pend;
+
+//
+// A store may leave writeback before its response arrives, so long as
+// there is room to track the response it still owes.
+wire        lsu_st_post_ok  = LSU_STORE_BUFFER && lsu_store && !s4_trap &&
+                              !lsu_mmio && !lsu_orphans_full;
+
+wire        lsu_st_posted   = lsu_st_post_ok && pipe_progress &&
+                              !(lsu_rsp_seen || lsu_rsp_now);
+
+wire [ 1:0] n_lsu_orphans   = lsu_orphans                   +
+                              {1'b0, lsu_st_posted  }       +
+                              {1'b0, lsu_orphan     }       -
+                              {1'b0, lsu_orphan_drop}       ;
+
+always @(posedge g_clk) begin
+    if(!g_resetn) begin
+        lsu_orphans <= 2'b0;
+    end else begin
+        lsu_orphans <= n_lsu_orphans;
+    end
+end
 
 wire        lsu_gpr_wen     = (lsu_txn_recv && !dmem_error ||
                                lsu_mmio     && !mmio_error  ) &&
@@ -367,7 +421,7 @@ wire [ 3:0] lsu_strb    = s4_opr_a[3:0];
 // Are we still waiting for the memory response?
 wire        lsu_busy    =
     fu_lsu && !(
-        lsu_rsp_seen || (dmem_recv && dmem_ack) || lsu_mmio
+        lsu_rsp_seen || lsu_rsp_now || lsu_mmio || lsu_st_post_ok
     );
 
 wire [31:0] mem_rdata = lsu_mmio ? mmio_rdata : dmem_rdata;
@@ -398,7 +452,7 @@ wire [XL:0] lsu_rdata   = {rdata_h1,rdata_b1,rdata_b0};
 reg  dmem_error_seen;
 
 wire n_dmem_error_seen = 
-    dmem_error_seen || (lsu_rsp_expected && dmem_error && dmem_recv);
+    dmem_error_seen || (lsu_rsp_expected && dmem_error && lsu_rsp_now);
 
 always @(posedge g_clk) begin
     if(!g_resetn) begin
@@ -460,6 +514,7 @@ assign gpr_wdata_hi = s4_opr_b;
 assign fwd_s4_rd    = gpr_rd;
 assign fwd_s4_wdata = gpr_wdata;
 assign fwd_s4_load  = fu_lsu && lsu_load;
+assign fwd_s4_lrdy  = lsu_gpr_wen && gpr_wen;
 assign fwd_s4_csr   = fu_csr;
 
 //
@@ -584,7 +639,7 @@ reg        use_saved_mem_rdata;
 
 wire       n_use_saved_mem_rdata =
     !pipe_progress && (
-        use_saved_mem_rdata || ((dmem_recv && dmem_ack) || lsu_mmio)
+        use_saved_mem_rdata || (lsu_rsp_now || lsu_mmio)
     );
 
 always @(posedge g_clk) begin
@@ -0,0 +1,47 @@
+
+//
+// Example program for the libgloss port: prints, writes a file into the
+// sandbox directory, reads it back and reports how long that took.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+int main() {
+
+    clock_t start = clock();
+
+    printf("Hello from the core.\n");
+
+    FILE * fh = fopen("hello.txt", "w");
+
+    if(fh == NULL) {
+        printf("Could not open hello.txt for writing.\n");
+        return 1;
+    }
+
+    fprintf(fh, "Written by the core.\n");
+    fclose(fh);
+
+    char line[64];
+
+    fh = fopen("hello.txt", "r");
+
+    if(fh == NULL || fgets(line, sizeof(line), fh) == NULL) {
+        printf("Could not read hello.txt back.\n");
+        return 2;
+    }
+
+    fclose(fh);
+
+    if(strcmp(line, "Written by the core.\n") != 0) {
+        printf("Read back the wrong text: %s", line);
+        return 3;
+    }
+
+    printf("Read back: %s", line);
+    printf("Took %ld clock() ticks.\n", (long)(clock() - start));
+
+    return 0;
+}
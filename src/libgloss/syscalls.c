@@ -0,0 +1,218 @@
+
+//
+// Newlib system calls, serviced by the testbench through the tohost /
+// fromhost registers of its exit device. See
+// flow/verilator/syscall_proxy.hpp for the host side.
+//
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/times.h>
+#include <time.h>
+#include <unistd.h>
+
+#undef errno
+extern int errno;
+
+//! Exit device registers.
+#define FRV_TOHOST      ((volatile uint32_t*)0x40700000)
+#define FRV_FROMHOST    ((volatile uint32_t*)0x40700004)
+
+// Call numbers, as understood by the testbench.
+#define FRV_SYS_CLOSE           57
+#define FRV_SYS_LSEEK           62
+#define FRV_SYS_READ            63
+#define FRV_SYS_WRITE           64
+#define FRV_SYS_GETTIMEOFDAY    169
+#define FRV_SYS_OPEN            1024
+
+// open() flags, as understood by the testbench.
+#define FRV_O_CREAT     0x040
+#define FRV_O_EXCL      0x080
+#define FRV_O_TRUNC     0x200
+#define FRV_O_APPEND    0x400
+
+//! Argument block passed to the testbench.
+static volatile uint32_t host_block[8] __attribute__((aligned(8)));
+
+//! Top of the heap. Starts at the end of .bss.
+static char * heap_end = 0;
+
+extern char _end[];
+
+
+/*!
+@brief Ask the testbench to service call n, and wait for it to do so.
+@returns The result, or -1 with errno set.
+*/
+static int32_t host_call(uint32_t n, uint32_t a0, uint32_t a1, uint32_t a2) {
+
+    host_block[0] = n;
+    host_block[1] = a0;
+    host_block[2] = a1;
+    host_block[3] = a2;
+
+    *FRV_TOHOST = (uint32_t)host_block;
+
+    while(*FRV_FROMHOST == 0) {
+        // Wait for the testbench.
+    }
+
+    *FRV_FROMHOST = 0;
+
+    int32_t result = host_block[0];
+
+    if(result < 0) {
+        errno = -result;
+        return -1;
+    }
+
+    return result;
+}
+
+
+void _exit(int code) {
+
+    *FRV_TOHOST = ((uint32_t)code << 1) | 0x1;
+
+    while(1) {
+        // The testbench stops the simulation.
+    }
+}
+
+
+int _write(int fd, const void * buf, size_t len) {
+    return host_call(FRV_SYS_WRITE, fd, (uint32_t)buf, len);
+}
+
+
+int _read(int fd, void * buf, size_t len) {
+    return host_call(FRV_SYS_READ, fd, (uint32_t)buf, len);
+}
+
+
+int _open(const char * path, int flags, int mode) {
+
+    uint32_t f = flags & O_ACCMODE;
+
+    if(flags & O_CREAT ) f |= FRV_O_CREAT ;
+    if(flags & O_EXCL  ) f |= FRV_O_EXCL  ;
+    if(flags & O_TRUNC ) f |= FRV_O_TRUNC ;
+    if(flags & O_APPEND) f |= FRV_O_APPEND;
+
+    return host_call(FRV_SYS_OPEN, (uint32_t)path, f, mode);
+}
+
+
+int _close(int fd) {
+    return host_call(FRV_SYS_CLOSE, fd, 0, 0);
+}
+
+
+off_t _lseek(int fd, off_t offset, int whence) {
+    return host_call(FRV_SYS_LSEEK, fd, offset, whence);
+}
+
+
+int _fstat(int fd, struct stat * st) {
+
+    st -> st_mode = fd <= 2 ? S_IFCHR : S_IFREG;
+
+    return 0;
+}
+
+
+int _isatty(int fd) {
+    return fd <= 2;
+}
+
+
+//! Microseconds since reset, by the testbench's clock.
+static uint64_t host_usec() {
+
+    if(host_call(FRV_SYS_GETTIMEOFDAY, 0, 0, 0) < 0) {
+        return 0;
+    }
+
+    return ((uint64_t)host_block[2] << 32) | host_block[1];
+}
+
+
+int _gettimeofday(struct timeval * tv, void * tz) {
+
+    uint64_t usec = host_usec();
+
+    tv -> tv_sec  = usec / 1000000;
+    tv -> tv_usec = usec % 1000000;
+
+    return 0;
+}
+
+
+clock_t _times(struct tms * buf) {
+
+    clock_t ticks = host_usec() / (1000000 / CLOCKS_PER_SEC);
+
+    buf -> tms_utime  = ticks;
+    buf -> tms_stime  = 0;
+    buf -> tms_cutime = 0;
+    buf -> tms_cstime = 0;
+
+    return ticks;
+}
+
+
+void * _sbrk(ptrdiff_t incr) {
+
+    char * sp;
+
+    __asm__ volatile ("mv %0, sp" : "=r"(sp));
+
+    if(heap_end == 0) {
+        heap_end = _end;
+    }
+
+    // Leave some room for the stack to grow into.
+    if(heap_end + incr > sp - 1024) {
+        errno = ENOMEM;
+        return (void*)-1;
+    }
+
+    char * prev = heap_end;
+
+    heap_end += incr;
+
+    return prev;
+}
+
+
+int _getpid() {
+    return 1;
+}
+
+
+int _kill(int pid, int sig) {
+    errno = EINVAL;
+    return -1;
+}
+
+
+int _link(const char * old, const char * new) {
+    errno = EMLINK;
+    return -1;
+}
+
+
+int _unlink(const char * path) {
+    errno = ENOENT;
+    return -1;
+}
+
+
+int _stat(const char * path, struct stat * st) {
+    errno = EACCES;
+    return -1;
+}
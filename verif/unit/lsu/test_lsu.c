@@ -0,0 +1,65 @@
+
+#include "unit_test.h"
+
+#define BUF_WORDS 64
+
+volatile uint32_t src [BUF_WORDS];
+volatile uint32_t dst [BUF_WORDS];
+
+/*!
+@brief Back-to-back loads and stores, checking that data and ordering are
+    preserved when accesses overlap in the memory system.
+*/
+int test_main() {
+
+    __putstr("--- Begin test ---\n");
+
+    for(int i = 0; i < BUF_WORDS; i ++) {
+        src[i] = 0x01010101 * i ^ 0xA5A5A5A5;
+        dst[i] = 0;
+    }
+
+    // Runs of independent word loads followed by runs of stores.
+    for(int i = 0; i < BUF_WORDS; i += 4) {
+        uint32_t a = src[i+0];
+        uint32_t b = src[i+1];
+        uint32_t c = src[i+2];
+        uint32_t d = src[i+3];
+        dst[i+0]   = a;
+        dst[i+1]   = b;
+        dst[i+2]   = c;
+        dst[i+3]   = d;
+    }
+
+    for(int i = 0; i < BUF_WORDS; i ++) {
+        if(dst[i] != src[i]) {
+            __putstr("Word copy mismatch\n");
+            return 1;
+        }
+    }
+
+    // Store immediately followed by a load from the same address.
+    volatile uint8_t  * dst_b = (volatile uint8_t  *)dst;
+    volatile uint16_t * dst_h = (volatile uint16_t *)dst;
+
+    for(int i = 0; i < 4*BUF_WORDS; i ++) {
+        dst_b[i] = (uint8_t)i;
+        if(dst_b[i] != (uint8_t)i) {
+            __putstr("Byte store/load mismatch\n");
+            return 2;
+        }
+    }
+
+    for(int i = 0; i < 2*BUF_WORDS; i ++) {
+        dst_h[i] = (uint16_t)(i * 3);
+        if(dst_h[i] != (uint16_t)(i * 3)) {
+            __putstr("Halfword store/load mismatch\n");
+            return 3;
+        }
+    }
+
+    __putstr("--- End test ---\n");
+
+    return 0;
+
+}
@@ -43,6 +43,12 @@ volatile uint64_t __rdtime();
 //! Intrisic for the `rdinstret` assembly instruction
 volatile uint64_t __rdinstret();
 
+//! Tell the testbench the region of interest (e.g. a benchmark) begins.
+void __roi_begin();
+
+//! Tell the testbench the region of interest ends.
+void __roi_end();
+
 //! Get the mcountinhibit CSR value
 volatile uint32_t __rdmcountinhibit();
 
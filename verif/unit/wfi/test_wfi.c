@@ -0,0 +1,75 @@
+
+
+#include "unit_test.h"
+
+#include "../timer/test_timer.h"
+
+// Interrupt handler table, from timer/test_timer.S
+extern void         vector_interrupt_table   ;
+
+static volatile int interrupt_count     =   0;
+static volatile uint64_t interrupt_time =   0;
+const           int max_interrupt_count =   5;
+const           int interrupt_period    = 800;
+
+
+//! Called when a machine timer interrupt occurs.
+void handler_machine_timer() {
+
+    uint64_t mtime = __rd_mtime();
+
+    interrupt_count ++;
+    interrupt_time  = mtime;
+
+    __wr_mtimecmp(mtime + interrupt_period);
+
+    // Disable the machine timer interrupt.
+    if(interrupt_count >= max_interrupt_count) {
+        __clr_mie(MIE_MTIE);
+    }
+
+    return;
+}
+
+
+/*!
+@brief Test for sleeping in WFI until a timer interrupt.
+@details Each sleep must last at least the timer period. Run with
+    +WFI_SKIP, the testbench skips over most of it: run-unit-wfi-skip
+    checks that it still passes and prints the same.
+*/
+int test_main() {
+    
+    interrupt_count = 0;
+
+    mtvec(&vector_interrupt_table, 1);
+
+    __wr_mtimecmp(__rd_mtime() + interrupt_period);
+
+    __set_mie(MIE_MTIE);
+    __set_mstatus(MSTATUS_MIE);
+
+    uint64_t last_time = 0;
+
+    while(interrupt_count < max_interrupt_count) {
+
+        int seen = interrupt_count;
+
+        while(interrupt_count == seen) {
+            __asm__ volatile ("wfi");
+        }
+
+        __putchar('.');
+
+        // Each interrupt is at least a period after the previous one.
+        if(seen > 0 && interrupt_time - last_time < interrupt_period) {
+            return 1;
+        }
+
+        last_time = interrupt_time;
+    }
+
+    __putchar('\n');
+
+    return 0;
+}